@@ -0,0 +1,47 @@
+#ifndef AFFINITY_HPP
+#define AFFINITY_HPP
+
+#include <string>
+#include <vector>
+
+// CaptureConfig::numa_node value that selects the node of the captured interface's device
+constexpr int NUMA_NODE_OF_INTERFACE = -2;
+
+// "0-3,8,10-11" -> {0, 1, 2, 3, 8, 10, 11}; false on malformed lists and CPUs past CPU_SETSIZE
+bool parse_cpu_list(const std::string& list, std::vector<int>& cpus);
+// {0, 1, 2, 3, 8} -> "0-3,8"
+std::string format_cpu_list(const std::vector<int>& cpus);
+
+// "auto" -> NUMA_NODE_OF_INTERFACE, "off" -> -1, "<n>" -> n
+bool parse_numa_node(const std::string& text, int& node);
+
+// restricts the calling thread to one CPU
+bool pin_current_thread(int cpu);
+
+// node of the interface's device from /sys/class/net/<iface>/device/numa_node; -1 for virtual
+// devices and machines with a single node
+int interface_numa_node(const std::string& iface);
+// CPUs of a NUMA node from /sys/devices/system/node/node<N>/cpulist, empty if unknown
+std::vector<int> numa_node_cpus(int node);
+
+// Makes page allocations of the calling thread prefer one NUMA node while in scope. Ring blocks
+// are allocated by the kernel under the caller's policy, and user buffers on first touch, so
+// opening a capture inside the scope places its memory on that node. A negative node does
+// nothing.
+class ScopedNumaPolicy {
+public:
+    explicit ScopedNumaPolicy(int node);
+    ~ScopedNumaPolicy();
+
+    ScopedNumaPolicy(const ScopedNumaPolicy&) = delete;
+    ScopedNumaPolicy& operator=(const ScopedNumaPolicy&) = delete;
+
+    bool active() const {
+        return m_active;
+    }
+
+private:
+    bool m_active = false;
+};
+
+#endif
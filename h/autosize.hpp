@@ -0,0 +1,75 @@
+#ifndef AUTOSIZE_HPP
+#define AUTOSIZE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct AutoSizeConfig {
+    size_t max_bytes = 0;  // memory cap for the buffer; 0 turns the controller off
+    size_t min_bytes = 0;  // floor for shrinking, 0 keeps the size the socket started with
+    uint32_t interval_ms = 1000;    // one decision per interval
+    uint32_t quiet_intervals = 30;  // intervals without drops and with low fill before a shrink
+};
+
+// accepts a byte count with an optional k, m or g suffix (powers of 1024), e.g. "64m"
+bool parse_byte_size(const std::string& text, size_t& bytes);
+
+enum class SizeDecision {
+    Hold,
+    Grow,
+    Shrink,
+    AtCap,  // drops or a full buffer called for growth, but the cap is reached
+};
+
+// Sizing policy for a receive buffer, fed with drop counts and fill samples. Drops or a buffer
+// seen at least three quarters full within an interval double the size up to the cap; a run of
+// quiet intervals, no drops and never more than a quarter full, halves it down to the floor.
+class BufferAutoSizer {
+public:
+    BufferAutoSizer() = default;
+    BufferAutoSizer(const AutoSizeConfig& config, size_t current);
+
+    bool enabled() const {
+        return m_config.max_bytes > 0;
+    }
+
+    const AutoSizeConfig& config() const {
+        return m_config;
+    }
+
+    // bytes queued over buffer size at some moment of the current interval
+    void sample_fill(double fill);
+    // closes the interval with the frames dropped in it and sets size to the size wanted;
+    // Grow and Shrink change it, the other decisions leave it alone
+    SizeDecision decide(uint64_t drops, size_t& size);
+
+    // peak fill of the interval just decided, for the log
+    double last_peak_fill() const {
+        return m_last_peak;
+    }
+
+    // the size a decision applies to, updated by applied() with what the kernel granted
+    size_t current() const {
+        return m_current;
+    }
+
+    void applied(size_t size) {
+        m_current = size;
+    }
+
+    // lowers the cap to what the system allows, e.g. when the kernel granted less than asked
+    void limit(size_t max_bytes) {
+        m_config.max_bytes = max_bytes;
+    }
+
+private:
+    AutoSizeConfig m_config;
+    size_t m_current = 0;
+    double m_peak = 0.0;
+    double m_last_peak = 0.0;
+    uint32_t m_quiet = 0;
+    bool m_reported_cap = false;  // AtCap is returned once per stay at the cap
+};
+
+#endif
@@ -1,30 +1,448 @@
 // h/capture.hpp
 #pragma once
+#include <linux/filter.h>
+#include <linux/if_packet.h>
+#include <sys/socket.h>
+
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
-#include <functional>
+#include <mutex>
 #include <string>
+#include <vector>
+
+#include "affinity.hpp"
+#include "autosize.hpp"
+#include "gso.hpp"
+#include "hugepages.hpp"
+#include "latency.hpp"
+#include "packet.hpp"
+#include "shed.hpp"
+#include "stop_signal.hpp"
+#include "xdp.hpp"
+
+enum class CaptureMode {
+    Recv,   // one recv() per frame into a private buffer
+    Ring,   // PACKET_RX_RING with TPACKET_V3 blocks, frames read in place
+    Batch,  // recvmmsg() into a preallocated array of buffers
+    Xdp,    // AF_XDP socket fed by an XDP redirect program, frames read in place from UMEM
+};
+
+// interface name that binds the socket to ifindex 0, receiving from every interface at once;
+// each frame then carries the ifindex it arrived on
+constexpr const char* ANY_INTERFACE = "any";
+
+enum class FanoutMode {
+    None,
+    Hash,         // PACKET_FANOUT_HASH, keeps a flow on one socket
+    Cpu,          // PACKET_FANOUT_CPU, socket chosen by the receiving CPU
+    LoadBalance,  // PACKET_FANOUT_LB, round robin
+    Rollover,     // PACKET_FANOUT_ROLLOVER, next socket only when the current one is full
+};
+
+// accepts "hash", "cpu", "lb" and "rollover"
+bool parse_fanout_mode(const std::string& name, FanoutMode& mode);
+
+enum class CaptureDirection {
+    Both,
+    In,   // frames received by the host
+    Out,  // frames sent by the host
+};
+
+// accepts "in", "out" and "both"
+bool parse_capture_direction(const std::string& name, CaptureDirection& direction);
+
+struct RingConfig {
+    uint32_t block_size = 1U << 22;  // bytes, multiple of the page size
+    uint32_t block_count = 64;
+    uint32_t block_timeout_ms = 64;  // kernel retires a partially filled block after this
+};
+
+struct CaptureConfig {
+    CaptureMode mode = CaptureMode::Recv;
+    RingConfig ring;
+    XdpConfig xdp;
+
+    // frames per recvmmsg() call; above 1 selects CaptureMode::Batch for Recv and is the
+    // fallback when the ring cannot be set up
+    uint32_t batch_size = 1;
+
+    // classic BPF program attached with SO_ATTACH_FILTER, see filter/bpf.hpp; empty accepts all
+    std::vector<struct sock_filter> filter;
+
+    // bytes kept of each frame, 0 keeps whole frames; the kernel truncates through the filter's
+    // return value so the rest is never copied to user space
+    uint32_t snaplen = 0;
+
+    // spin on the socket or ring for this long after the last frame before sleeping, with
+    // SO_BUSY_POLL/SO_PREFER_BUSY_POLL set to the same budget; 0 blocks right away
+    uint32_t busy_poll_us = 0;
+
+    // record the kernel-timestamp-to-callback delay of every frame, see latency()
+    bool measure_latency = false;
+
+    // false leaves SO_TIMESTAMPNS off, which spares the kernel a clock read per frame once no
+    // socket asks for it; frames are then stamped with one wall_clock_ns() per batch as they
+    // are read, see tsc_clock.hpp. Ring frames always carry the kernel's tp_sec/tp_nsec.
+    bool kernel_timestamps = true;
+
+    // NUMA node for ring, UMEM and receive buffers: -1 leaves placement to the kernel,
+    // NUMA_NODE_OF_INTERFACE takes the node of the interface's device, see affinity.hpp
+    int numa_node = -1;
+
+    // page size behind the recvmmsg() buffers; the TPACKET_V3 ring is mapped by the kernel in
+    // normal pages whatever this says, UMEM follows XdpConfig::huge_pages
+    HugePageMode huge_pages = HugePageMode::Auto;
+
+    // In sets PACKET_IGNORE_OUTGOING where the kernel has it; otherwise, and for Out, the
+    // filter tests the packet type first, see restrict_direction(). Either way the unwanted
+    // frames are dropped before they are copied. AF_XDP only ever sees inbound frames.
+    CaptureDirection direction = CaptureDirection::Both;
+
+    // anything but Off sets PACKET_VNET_HDR, so GRO/TSO super-frames come with their segment
+    // size in PacketView::gso; the frames themselves are delivered as they were, in place.
+    // AF_XDP frames never are super-frames.
+    GsoMode gso = GsoMode::Off;
+
+    // grow the socket receive buffer on drops and shrink it again when quiet, within
+    // autosize.max_bytes, see autosize.hpp. A live TPACKET_V3 ring cannot be resized without
+    // losing the frames in it, so in ring mode the sizes it should have are only logged.
+    AutoSizeConfig autosize;
+
+    // under pressure cut frames to their headers, then sample, then drop them before they are
+    // delivered, so the sink keeps up with a burst; see shed.hpp
+    LoadShedConfig shed;
+
+    // sockets sharing a group id on the same interface split its traffic between them
+    FanoutMode fanout = FanoutMode::None;
+    uint16_t fanout_group = 0;
+};
+
+// kernel-side counters of one capture socket, accumulated since open(), and what load
+// shedding did to the frames after the kernel
+struct CaptureStats {
+    uint64_t packets = 0;  // frames that passed the filter, the dropped ones included
+    uint64_t drops = 0;    // frames lost because the socket queue or ring was full
+    uint64_t freezes = 0;  // times a full TPACKET_V3 ring froze its queue
+    uint64_t cut = 0;      // frames delivered cut to their headers
+    uint64_t shed = 0;     // frames sampled out or dropped, never delivered
+
+    double drop_rate() const {
+        return packets > 0 ? static_cast<double>(drops) / static_cast<double>(packets) : 0.0;
+    }
+
+    CaptureStats& operator+=(const CaptureStats& other) {
+        packets += other.packets;
+        drops += other.drops;
+        freezes += other.freezes;
+        cut += other.cut;
+        shed += other.shed;
+        return *this;
+    }
+};
 
 class PacketCapturer {
 public:
     PacketCapturer() = default;
     ~PacketCapturer();
 
+    PacketCapturer(const PacketCapturer&) = delete;
+    PacketCapturer& operator=(const PacketCapturer&) = delete;
+
     bool open(const std::string& iface, bool promisc);
+    // falls back to CaptureMode::Batch or Recv when the ring or the AF_XDP socket cannot be
+    // set up
+    bool open(const std::string& iface, bool promisc, const CaptureConfig& config);
+
+    // The capture loops are templates over the sink, any callable taking (const uint8_t*,
+    // size_t) for run() or (const PacketView*, size_t) for run_batch() and drain(). A lambda or
+    // functor is called directly and can be inlined into the loop; a std::function works too,
+    // at the cost of one indirect call per frame or batch.
 
-    void run(const std::function<void(const uint8_t*, size_t)>& callback,
-             std::atomic<bool>& running);
+    // The loops run until the flag is cleared or the stop signal fires. A cleared flag is
+    // noticed within one poll interval (100 ms) on an idle interface; a StopSignal wakes the
+    // loop at once and ends it at the signal's deadline.
+
+    // in ring and XDP mode the data pointer refers into shared memory and is only valid during
+    // the call
+    template <typename Sink>
+    void run(Sink&& sink, std::atomic<bool>& running);
+    template <typename Sink>
+    void run(Sink&& sink, const StopSignal& stop);
+
+    // delivers every frame of one recvmmsg() call or one ring block together, each stamped with
+    // its kernel receive time; recv mode delivers batches of one
+    template <typename Sink>
+    void run_batch(Sink&& sink, std::atomic<bool>& running);
+    template <typename Sink>
+    void run_batch(Sink&& sink, const StopSignal& stop);
+
+    // delivers what is already queued without blocking, for callers that wait on get_fd()
+    // themselves; returns the number of frames delivered
+    template <typename Sink>
+    size_t drain(Sink&& sink);
 
     void close();
 
+    // reads PACKET_STATISTICS (XDP_STATISTICS for AF_XDP) and returns the totals since open();
+    // the kernel clears its counters on every read, the totals are kept here under a lock, so
+    // it is safe to call from any thread while run_batch() is running
+    CaptureStats poll_stats();
+
+    // frames handed to the callback so far; safe to read from other threads
+    uint64_t delivered() const {
+        return m_delivered.load(std::memory_order_relaxed);
+    }
+
+    // the descriptor to wait on for readable frames
     int get_fd() const {
-        return m_fd;
+        return m_mode == CaptureMode::Xdp ? m_xdp.get_fd() : m_fd;
+    }
+
+    // 0 for a capture on ANY_INTERFACE
+    int ifindex() const {
+        return m_ifindex;
+    }
+
+    bool any_interface() const {
+        return m_ifindex == 0;
+    }
+
+    const std::string& iface() const {
+        return m_iface;
+    }
+
+    CaptureMode mode() const {
+        return m_mode;
+    }
+
+    // node the capture memory was allocated on, -1 when placement was left to the kernel
+    int numa_node() const {
+        return m_numa_node;
+    }
+
+    uint32_t batch_size() const {
+        return m_batch_size;
+    }
+
+    // true when the kernel drops the host's own frames through PACKET_IGNORE_OUTGOING
+    bool ignores_outgoing() const {
+        return m_ignore_outgoing;
+    }
+
+    // true when every frame is read with its virtio-net header, see CaptureConfig::gso
+    bool reads_vnet_headers() const {
+        return m_vnet_hdr_len > 0;
+    }
+
+    // SO_RCVBUF as the kernel reports it, twice the value set, which frames are charged against
+    // with their full buffer overhead; 0 if it cannot be read
+    size_t receive_buffer_size() const;
+
+    // pages behind the recvmmsg() buffers, PageBacking::None in ring and AF_XDP mode
+    PageBacking buffer_backing() const {
+        return m_batch_buffer.backing();
+    }
+
+    const XdpSocket& xdp() const {
+        return m_xdp;
+    }
+
+    // delivery latency samples; read it only after run_batch() has returned
+    const LatencyHistogram& latency() const {
+        return m_latency;
     }
 
+    // every stretch of load shedding so far, the one in progress included and ended at the
+    // time of the call; read it only after run_batch() has returned
+    std::vector<ShedInterval> shed_intervals() const;
+
 private:
     int m_fd = -1;
     int m_ifindex = -1;
     bool m_promisc = false;
     std::string m_iface;
+    CaptureMode m_mode = CaptureMode::Recv;
+    uint32_t m_snaplen = 0;
+    uint64_t m_spin_ns = 0;
+    uint64_t m_spin_deadline = 0;  // end of the current busy-poll window, 0 outside of one
+    bool m_measure_latency = false;
+    int m_numa_node = -1;
+    bool m_ignore_outgoing = false;
+    size_t m_vnet_hdr_len = 0;  // VNET_HDR_LEN in front of each frame with PACKET_VNET_HDR set
+    LatencyHistogram m_latency;
+    std::atomic<uint64_t> m_delivered{0};
+
+    std::mutex m_stats_mutex;
+    CaptureStats m_stats;
+
+    // buffer auto-sizing and load shedding, driven from next_batch() on the capture thread
+    BufferAutoSizer m_autosize;
+    LoadShedder m_shedder;
+    uint64_t m_autosize_drops = 0;        // drops counted up to the last decision
+    uint64_t m_next_fill_sample = 0;      // CLOCK_MONOTONIC ns
+    uint64_t m_next_size_decision = 0;
+    // the shedder's totals, for poll_stats() on other threads
+    std::atomic<uint64_t> m_shed_cut{0};
+    std::atomic<uint64_t> m_shed_skipped{0};
+
+    // TPACKET_V3 ring state
+    uint8_t* m_ring = nullptr;
+    size_t m_ring_size = 0;
+    RingConfig m_ring_config;
+    uint32_t m_block_index = 0;
+
+    // recvmmsg() buffers, or the per-block views in ring mode; each slot holds the virtio-net
+    // header, if any, and then m_frame_buffer_size bytes of frame
+    uint32_t m_batch_size = 1;
+    size_t m_frame_buffer_size = 0;
+    HugeBuffer m_batch_buffer;
+    std::vector<PacketView> m_batch_views;
+    std::vector<struct iovec> m_iovecs;
+    std::vector<struct mmsghdr> m_msgs;
+    std::vector<struct sockaddr_ll> m_addrs;  // source address, for the packet type
+    std::vector<uint8_t> m_control;
+
+    // in XDP mode m_fd stays unbound and only serves the interface ioctls and promisc membership
+    XdpSocket m_xdp;
+
+    bool attach_filter(const std::vector<struct sock_filter>& program);
+    bool setup_ring(const RingConfig& ring);
+    void add_promisc_membership();
+    bool join_fanout(FanoutMode mode, uint16_t group);
+    void enable_busy_poll(int fd, uint32_t usec);
+    void teardown_ring();
+
+    // sets up m_autosize for the buffer open() ended up with
+    void start_autosize(const AutoSizeConfig& config);
+    // samples the fill level for m_autosize and m_shedder, and resizes the buffers once per
+    // auto-sizing interval
+    void watch_pressure();
+    // lets m_autosize decide on the drops since the last decision, then resizes the receive
+    // buffer or logs the ring size to use
+    void tune_buffers();
+    // cuts, samples or drops the batch in m_batch_views at the current shedding level
+    size_t shed_batch(size_t count);
+    // bytes queued over buffer size for the socket, blocks owned by user space over all blocks
+    // for the ring
+    double buffer_fill() const;
+    // asks for an effective receive buffer of bytes and returns what the kernel granted
+    size_t set_receive_buffer(size_t bytes);
+
+    // throws if open() has not succeeded
+    void require_open() const;
+
+    template <typename Sink, typename Stopped>
+    void run_loop(Sink& sink, Stopped stopped, const StopSignal* stop);
+    // adapts a per-frame sink to the batch loop
+    template <typename Sink>
+    static auto per_frame(Sink& sink);
+
+    // Fills m_batch_views with the next batch and sets count; false if nothing arrived. With
+    // wait set an empty queue is spun on through the busy-poll window, then slept on in
+    // wait_readable(). Every true return is paired with release_batch() once the frames are
+    // delivered.
+    bool next_batch(bool wait, const StopSignal* stop, size_t& count);
+    // hands the ring block or UMEM frames of the last batch back to the kernel
+    void release_batch();
+    // polls the capture descriptor and the stop signal's eventfd for up to one poll interval,
+    // less when the stop deadline is closer
+    void wait_readable(const StopSignal* stop);
+
+    // records latency samples, then hands the batch to the sink
+    template <typename Sink>
+    void deliver(Sink& sink, const PacketView* packets, size_t count);
+    void record_latency(const PacketView* packets, size_t count);
+
+    // true while the busy-poll window after the last frame is still open
+    bool keep_spinning();
+
+    // one recvmsg() into the first batch view; 0 when nothing was queued, on EINTR or when
+    // the kernel could not describe a frame in a virtio-net header and dropped it
+    size_t receive_one(int flags);
+    // one recvmmsg() into the batch views; 0 in the same cases as receive_one()
+    size_t receive_mmsg(int flags);
+    // fills the view from one received message: frame, control messages, virtio-net header;
+    // batch_ns is the batch's clock reading, 0 until a frame without kernel timestamp needs it
+    void read_message(size_t slot, size_t len, uint64_t& batch_ns, PacketView& packet);
+    // true for a receive error that only lost one frame, which is then counted as dropped
+    bool lost_to_vnet_header(int error);
+    // takes the current ring block if the kernel released it; false if it is still busy
+    bool take_ring_block(size_t& count);
+    // one batch from the AF_XDP RX ring; 0 when the ring is empty
+    size_t take_xdp_frames();
 };
+
+template <typename Sink>
+auto PacketCapturer::per_frame(Sink& sink) {
+    return [&sink](const PacketView* packets, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            sink(packets[i].data, packets[i].len);
+        }
+    };
+}
+
+template <typename Sink>
+void PacketCapturer::run(Sink&& sink, std::atomic<bool>& running) {
+    run_batch(per_frame(sink), running);
+}
+
+template <typename Sink>
+void PacketCapturer::run(Sink&& sink, const StopSignal& stop) {
+    run_batch(per_frame(sink), stop);
+}
+
+template <typename Sink>
+void PacketCapturer::run_batch(Sink&& sink, std::atomic<bool>& running) {
+    run_loop(sink, [&running]() { return !running.load(); }, nullptr);
+}
+
+template <typename Sink>
+void PacketCapturer::run_batch(Sink&& sink, const StopSignal& stop) {
+    run_loop(sink, [&stop]() { return stop.requested(); }, &stop);
+}
+
+template <typename Sink, typename Stopped>
+void PacketCapturer::run_loop(Sink& sink, Stopped stopped, const StopSignal* stop) {
+    require_open();
+
+    size_t count = 0;
+    while (!stopped()) {
+        if (next_batch(true, stop, count)) {
+            if (count > 0) {
+                deliver(sink, m_batch_views.data(), count);
+            }
+            release_batch();
+        }
+    }
+}
+
+template <typename Sink>
+size_t PacketCapturer::drain(Sink&& sink) {
+    require_open();
+
+    // at most one lap of the ring, so a busy interface cannot starve the caller's other sources
+    const uint32_t rounds = m_mode == CaptureMode::Ring ? m_ring_config.block_count : 1;
+
+    size_t total = 0;
+    size_t count = 0;
+    for (uint32_t i = 0; i < rounds && next_batch(false, nullptr, count); ++i) {
+        if (count > 0) {
+            deliver(sink, m_batch_views.data(), count);
+            total += count;
+        }
+        release_batch();
+    }
+    return total;
+}
+
+template <typename Sink>
+void PacketCapturer::deliver(Sink& sink, const PacketView* packets, size_t count) {
+    if (m_measure_latency) {
+        record_latency(packets, count);
+    }
+
+    sink(packets, count);
+    m_delivered.store(m_delivered.load(std::memory_order_relaxed) + count,
+                      std::memory_order_relaxed);
+}
@@ -2,8 +2,10 @@
 #define CLI_HPP
 
 #include <string>
+#include <vector>
 
 struct CliOptions {
+    // one interface or a comma-separated list, see split_interfaces()
     std::string interface = "eth0";
     bool promiscuous = false;
     std::string output_file;
@@ -13,10 +15,83 @@ struct CliOptions {
     bool interactive = false;
     bool show_parsed = true;
     bool show_hex = false;
+    // write frames to output_file without parsing or printing them
+    bool record_only = false;
+
+    // TPACKET_V3 ring capture
+    bool use_ring = false;
+    int ring_block_size = 1 << 22;
+    int ring_block_count = 64;
+    int ring_block_timeout = 64;
+
+    // AF_XDP capture on one RX queue
+    bool use_xdp = false;
+    int xdp_queue = 0;
+    std::string xdp_bind = "auto";
+    bool xdp_generic = false;
+
+    // recvmmsg() batch size, 1 keeps one recv() per frame
+    int batch_size = 1;
+
+    // bytes kept of each frame, 0 keeps whole frames
+    int snaplen = 0;
+
+    // spin this many microseconds before sleeping in the kernel, 0 disables busy polling
+    int busy_poll_us = 0;
+    // print kernel-timestamp-to-callback latency percentiles at the end
+    bool report_latency = false;
+    // "kernel" (SO_TIMESTAMPNS) or "tsc" (stamped in user space from the TSC), see tsc_clock.hpp
+    std::string timestamps = "kernel";
+
+    // kernel-side capture filter, see filter/bpf.hpp
+    std::string filter;
+    bool filter_dump = false;
+    // "in", "out" or "both"; the other direction is dropped at the socket
+    std::string direction = "both";
+    // GRO/TSO super-frames: "off", "keep" (whole, with segment size) or "segment", see gso.hpp
+    std::string gso = "off";
+    // bytes kept of each frame when load shedding starts, 0 disables shedding, see shed.hpp
+    int shed_bytes = 0;
+    // memory cap for receive buffer auto-sizing, e.g. "64m", see autosize.hpp; empty keeps the
+    // kernel's default size
+    std::string autosize;
+
+    // print a status line with kernel drop counters every this many seconds, 0 disables it
+    int stats_interval = 0;
+
+    // CPU list the capture thread, or worker i on entry i, is pinned to; empty leaves it to the
+    // scheduler
+    std::string cpus;
+    // NUMA node for capture memory: "auto" (the interface's node), "off" or a node number
+    std::string numa = "auto";
+    // page size behind packet buffers: "auto", "off", "2m" or "1g", see hugepages.hpp
+    std::string hugepages = "auto";
+
+    // how long frames of several interfaces are held to be merged in timestamp order
+    int merge_window_ms = 10;
+
+    // synthetic traffic instead of a live interface, see generator.hpp; needs no root
+    bool generate = false;
+    int gen_rate = 0;  // frames per second, 0 as fast as possible
+    int gen_flows = 64;
+    std::string gen_mix = "arp=1,udp=6,tcp=3";
+    std::string gen_size = "imix";
+
+    // transmit a PCAP file through a TX ring instead of capturing, see replay.hpp
+    std::string replay_file;
+    std::string replay_speed = "1";  // multiple of the original speed, or "max"
+    bool qdisc_bypass = false;
+
+    // PACKET_FANOUT worker threads
+    int workers = 1;
+    std::string fanout_mode = "hash";
 };
 
 bool handle_cli(int argc, char** argv, CliOptions& opts);
 
+// "eth0,eth1" -> {"eth0", "eth1"}; empty entries are skipped
+std::vector<std::string> split_interfaces(const std::string& list);
+
 void print_usage(const char* prog_name);
 bool parse_cli(int argc, char** argv, CliOptions& opts);
 
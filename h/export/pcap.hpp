@@ -4,25 +4,47 @@
 #include <cstdint>
 #include <fstream>
 #include <string>
+#include <vector>
 
-class PcapWriter {
+#include "export/writer.hpp"
+#include "packet.hpp"
+
+enum class PcapTimestampPrecision {
+    Micro,  // classic 0xa1b2c3d4 files
+    Nano,   // 0xa1b23c4d files, ts_usec holds nanoseconds
+};
+
+class PcapWriter : public PacketWriter {
 public:
     PcapWriter() = default;
-    ~PcapWriter();
+    ~PcapWriter() override;
 
-    bool open(const std::string& filename);
-    void write_packet(const uint8_t* data, size_t len);
-    void close();
+    // snaplen goes into the global header, and no record stores more than that many bytes
+    bool open(const std::string& filename,
+              PcapTimestampPrecision precision = PcapTimestampPrecision::Micro,
+              uint32_t snaplen = DEFAULT_SNAPLEN);
+    // ts_ns is the receive time in nanoseconds since the Unix epoch; the writer never reads
+    // the clock itself. orig_len is the length on the wire if the frame was already truncated.
+    void write_packet(const uint8_t* data, size_t len, uint64_t ts_ns = 0, size_t orig_len = 0);
+    // lays the batch out as one contiguous run of records and hands it to the file in a
+    // single write, so a whole ring block costs one system call
+    void write_packets(const PacketView* packets, size_t count) override;
+    void close() override;
 
-    bool is_open() const {
+    bool is_open() const override {
         return m_file.is_open();
     }
 
 private:
     std::ofstream m_file;
+    PcapTimestampPrecision m_precision = PcapTimestampPrecision::Micro;
+    uint32_t m_snaplen = DEFAULT_SNAPLEN;
+    std::vector<uint8_t> m_run;  // records of the batch being written, kept for its capacity
 
     void write_global_header();
-    void write_packet_header(uint32_t len);
+    // appends header and frame to m_run
+    void append_record(const PacketView& packet);
+    void write_run();
 };
 
 #pragma pack(push, 1)
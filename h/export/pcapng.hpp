@@ -0,0 +1,63 @@
+#ifndef PCAPNG_HPP
+#define PCAPNG_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "export/writer.hpp"
+#include "interface_names.hpp"
+#include "packet.hpp"
+
+// pcapng file with one section. Every capture interface gets its own Interface Description
+// Block, so frames merged from several interfaces keep track of where they were received;
+// timestamps are stored in nanoseconds (if_tsresol 9).
+class PcapngWriter : public PacketWriter {
+public:
+    PcapngWriter() = default;
+    ~PcapngWriter() override;
+
+    // snaplen goes into every interface block, and no record stores more than that many bytes
+    bool open(const std::string& filename, uint32_t snaplen = DEFAULT_SNAPLEN);
+    // declares an interface up front; frames of an unknown ifindex declare theirs on first use,
+    // named through a cached lookup
+    void add_interface(const std::string& name, int ifindex) override;
+    void write_packets(const PacketView* packets, size_t count) override;
+    // appends an Interface Statistics Block; a later block for the same interface supersedes it
+    void write_statistics(int ifindex, const InterfaceStatistics& stats) override;
+    // appends a statistics block with only its start and end time and a comment describing the
+    // shedding; written before the final counters so those still supersede everything
+    void write_shed_interval(int ifindex, const ShedInterval& interval) override;
+    void close() override;
+
+    bool is_open() const override {
+        return m_file.is_open();
+    }
+
+private:
+    std::ofstream m_file;
+    uint32_t m_snaplen = DEFAULT_SNAPLEN;
+    // ifindex -> interface id, the position of its description block in the section
+    std::unordered_map<int, uint32_t> m_interfaces;
+    InterfaceNames m_names;
+    // blocks not yet written: one block, or all of a write_packets() batch so it goes to the
+    // file in one write
+    std::vector<uint8_t> m_block;
+    size_t m_block_start = 0;  // offset of the block being built
+    bool m_gathering = false;  // end_block() leaves the block in m_block for write_blocks()
+
+    uint32_t interface_id(int ifindex);
+    void write_section_header();
+    void write_interface(const std::string& name);
+    void write_packet(const PacketView& packet, uint32_t interface);
+
+    void begin_block(uint32_t type);
+    void append(const void* data, size_t len);
+    void append_option(uint16_t code, const void* data, uint16_t len);
+    void end_block();
+    void write_blocks();
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef WRITER_HPP
+#define WRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "gso.hpp"
+#include "packet.hpp"
+#include "shed.hpp"
+
+constexpr size_t MAC_ADDRESSES_LEN = 12;
+constexpr size_t VLAN_TAG_LEN = 4;
+
+// true when the frame is exported with its stripped VLAN tag put back
+inline bool reinserts_vlan(const PacketView& packet) {
+    return packet.has_vlan() && packet.len >= MAC_ADDRESSES_LEN;
+}
+
+// length of the frame as exported, and on the wire, counting a reinserted tag
+inline size_t export_len(const PacketView& packet) {
+    return packet.len + (reinserts_vlan(packet) ? VLAN_TAG_LEN : 0);
+}
+
+inline size_t export_wire_len(const PacketView& packet) {
+    return packet.wire_len() + (reinserts_vlan(packet) ? VLAN_TAG_LEN : 0);
+}
+
+// Hands emit(const uint8_t*, size_t) the first incl_len bytes of the exported frame in up to
+// three pieces - MAC addresses, reinserted tag, the rest - so the frame itself is never moved
+// and parsing never pays for the reinsertion.
+template <typename Emit>
+void emit_frame(const PacketView& packet, size_t incl_len, Emit&& emit) {
+    if (!reinserts_vlan(packet)) {
+        emit(packet.data, incl_len);
+        return;
+    }
+
+    const uint8_t tag[VLAN_TAG_LEN] = {
+        static_cast<uint8_t>(packet.vlan_tpid >> 8), static_cast<uint8_t>(packet.vlan_tpid),
+        static_cast<uint8_t>(packet.vlan_tci >> 8), static_cast<uint8_t>(packet.vlan_tci)};
+    const size_t head = incl_len < MAC_ADDRESSES_LEN ? incl_len : MAC_ADDRESSES_LEN;
+    emit(packet.data, head);
+    incl_len -= head;
+    const size_t tag_len = incl_len < VLAN_TAG_LEN ? incl_len : VLAN_TAG_LEN;
+    emit(tag, tag_len);
+    incl_len -= tag_len;
+    emit(packet.data + MAC_ADDRESSES_LEN, incl_len);
+}
+
+// counters of one capture interface at ts_ns, as recorded in a pcapng statistics block
+struct InterfaceStatistics {
+    uint64_t ts_ns = 0;
+    uint64_t received = 0;   // frames the kernel accepted through the filter
+    uint64_t dropped = 0;    // frames the kernel dropped for lack of buffer space
+    uint64_t delivered = 0;  // frames handed to user space
+};
+
+// Sink for captured frames, implemented by the PCAP and pcapng writers so the pipeline does not
+// care which file format it is exporting to.
+class PacketWriter {
+public:
+    virtual ~PacketWriter() = default;
+
+    virtual bool is_open() const = 0;
+    // writes the whole batch and flushes once at the end
+    virtual void write_packets(const PacketView* packets, size_t count) = 0;
+    virtual void close() = 0;
+
+    // declares an interface the frames and counters of ifindex belong to; formats with a single
+    // interface per file ignore it
+    virtual void add_interface(const std::string& name, int ifindex) {
+        (void) name;
+        (void) ifindex;
+    }
+
+    // formats without a place for capture counters ignore them
+    virtual void write_statistics(int ifindex, const InterfaceStatistics& stats) {
+        (void) ifindex;
+        (void) stats;
+    }
+
+    // marks a stretch of the capture where load shedding degraded the frames; ignored like the
+    // counters by formats that cannot hold it
+    virtual void write_shed_interval(int ifindex, const ShedInterval& interval) {
+        (void) ifindex;
+        (void) interval;
+    }
+
+    // record GSO super-frames as the wire frames they stand for instead of as they were read
+    void set_segment_gso(bool segment) {
+        m_segment_gso = segment;
+    }
+
+protected:
+    // calls write(const PacketView&) with the frame, or with each of its segments when it is a
+    // super-frame to be cut up; other frames are passed through untouched
+    template <typename Write>
+    void export_frames(const PacketView& packet, Write&& write) {
+        if (m_segment_gso && packet.is_gso() && m_segmenter.begin(packet)) {
+            PacketView segment;
+            while (m_segmenter.next(segment)) {
+                write(segment);
+            }
+            return;
+        }
+        write(packet);
+    }
+
+private:
+    bool m_segment_gso = false;
+    GsoSegmenter m_segmenter;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef BPF_HPP
+#define BPF_HPP
+
+#include <linux/filter.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "packet.hpp"
+
+// Compiles a capture filter expression to classic BPF for SO_ATTACH_FILTER.
+//
+//   expr      := term { ("or" | "||") term }
+//   term      := factor { ["and" | "&&"] factor }
+//   factor    := ("not" | "!") factor | "(" expr ")" | primitive
+//   primitive := "ethertype" (number | "ip" | "ip6" | "arp" | "vlan")
+//              | "vlan" [vid]
+//              | ["src" | "dst"] "host" a.b.c.d
+//              | ["src" | "dst"] "net" a.b.c.d/len
+//              | ["src" | "dst"] "port" number
+//              | "proto" (number | "icmp" | "tcp" | "udp")
+//              | "ip" | "ip6" | "arp" | "icmp" | "tcp" | "udp"
+//
+// host and net match IPv4 addresses and ARP sender/target addresses, port matches TCP and UDP
+// over IPv4. vlan matches tags still in the frame as well as tags the NIC stripped into the
+// skb metadata. An empty expression accepts every frame.
+//
+// Accepted frames are truncated to accept_len bytes by the kernel, rejected ones never reach
+// user space.
+bool compile_filter(const std::string& expression, std::vector<struct sock_filter>& program,
+                    std::string& error, uint32_t accept_len = DEFAULT_SNAPLEN);
+
+// Runs program only on frames going one way, judged by the kernel's packet type: outbound
+// frames are the host's own (PACKET_OUTGOING), everything else is inbound. The other direction
+// is rejected before the frame is copied. An empty program stands for one accepting everything.
+std::vector<struct sock_filter> restrict_direction(const std::vector<struct sock_filter>& program,
+                                                   bool outbound);
+
+// Human readable listing of a program in the style of `tcpdump -d`.
+std::string dump_filter(const std::vector<struct sock_filter>& program);
+
+#endif
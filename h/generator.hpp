@@ -0,0 +1,127 @@
+#ifndef GENERATOR_HPP
+#define GENERATOR_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "hugepages.hpp"
+#include "packet.hpp"
+#include "stop_signal.hpp"
+
+enum class FrameSizes {
+    Imix,     // 60, 590 and 1514 bytes in a 7:4:1 ratio
+    Fixed,    // every IPv4 frame is min_size bytes
+    Uniform,  // uniformly spread between min_size and max_size
+};
+
+struct GeneratorConfig {
+    // relative share of each frame kind, see parse_traffic_mix()
+    uint32_t arp_weight = 1;
+    uint32_t icmp_weight = 0;
+    uint32_t udp_weight = 6;
+    uint32_t tcp_weight = 3;
+
+    // IPv4 frame lengths without FCS; ARP frames are always 42 bytes
+    FrameSizes sizes = FrameSizes::Imix;
+    uint32_t min_size = 60;
+    uint32_t max_size = 1514;
+
+    uint32_t flow_count = 64;  // distinct address/port pairs
+    uint64_t rate_pps = 0;     // 0 generates as fast as the callback takes frames
+    uint32_t batch_size = 64;  // frames per callback
+    uint32_t snaplen = 0;      // cut frames like the kernel would, 0 keeps them whole
+
+    // frames are built once into a pool and replayed, so the generator itself costs close to
+    // nothing per frame
+    uint32_t pool_size = 4096;
+    uint64_t seed = 1;
+    HugePageMode huge_pages = HugePageMode::Auto;  // page size behind the pool
+};
+
+// "arp=1,udp=6,tcp=3,icmp=0"; kinds left out get weight 0, at least one must be positive
+bool parse_traffic_mix(const std::string& spec, GeneratorConfig& config);
+// "imix", "<len>" or "<min>-<max>", lengths between 60 and 9014
+bool parse_frame_sizes(const std::string& spec, GeneratorConfig& config);
+
+// Synthetic traffic source with the same run_batch() interface as PacketCapturer. Needs no
+// root and no NIC, so the parse and export stages can be measured on any machine.
+class TrafficGenerator {
+public:
+    bool open(const GeneratorConfig& config);
+
+    // frames stay valid until the generator is opened again or destroyed; each batch is stamped
+    // with the current time. Sink is any callable taking (const PacketView*, size_t), see
+    // PacketCapturer::run_batch().
+    template <typename Sink>
+    void run_batch(Sink&& sink, std::atomic<bool>& running);
+    template <typename Sink>
+    void run_batch(Sink&& sink, const StopSignal& stop);
+
+    uint64_t generated() const {
+        return m_generated;
+    }
+
+    PageBacking pool_backing() const {
+        return m_pool.backing();
+    }
+
+    // wall time spent in the last run_batch() call
+    uint64_t elapsed_ns() const {
+        return m_elapsed_ns;
+    }
+
+private:
+    GeneratorConfig m_config;
+    HugeBuffer m_pool;
+    std::vector<PacketView> m_frames;  // views into m_pool
+    std::vector<PacketView> m_batch;
+    uint64_t m_generated = 0;
+    uint64_t m_elapsed_ns = 0;
+
+    // pacing state of the current run_batch() call
+    std::chrono::steady_clock::time_point m_start;
+    uint64_t m_sent = 0;
+    size_t m_next = 0;
+
+    bool build_pool();
+
+    template <typename Sink, typename Stopped>
+    void run_loop(Sink& sink, Stopped stopped);
+
+    void begin_run();
+    void end_run();
+    // fills m_batch with the frames due now; sleeps and returns 0 when none are due yet
+    size_t next_batch();
+};
+
+template <typename Sink>
+void TrafficGenerator::run_batch(Sink&& sink, std::atomic<bool>& running) {
+    run_loop(sink, [&running]() { return !running.load(); });
+}
+
+template <typename Sink>
+void TrafficGenerator::run_batch(Sink&& sink, const StopSignal& stop) {
+    run_loop(sink, [&stop]() { return stop.requested(); });
+}
+
+template <typename Sink, typename Stopped>
+void TrafficGenerator::run_loop(Sink& sink, Stopped stopped) {
+    begin_run();
+
+    while (!stopped()) {
+        const size_t count = next_batch();
+        if (count > 0) {
+            sink(m_batch.data(), count);
+            m_sent += count;
+            m_generated += count;
+        }
+    }
+
+    end_run();
+}
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef GSO_HPP
+#define GSO_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "packet.hpp"
+
+// length of the virtio-net header PACKET_VNET_HDR puts in front of every frame
+constexpr size_t VNET_HDR_LEN = 10;
+
+enum class GsoMode {
+    Off,      // no virtio-net headers; super-frames are recorded without their segment size
+    Keep,     // super-frames are recorded whole, with their segmentation details
+    Segment,  // super-frames are cut into the wire frames they stand for on export
+};
+
+// accepts "off", "keep" and "segment"
+bool parse_gso_mode(const std::string& name, GsoMode& mode);
+
+// "tcpv4", "tcpv6", "udp", ...
+const char* gso_type_name(uint8_t type);
+
+// longest super-frame the device can hand over: the largest of its GRO and GSO size limits, at
+// least the 64 KB of a maximal IP packet, behind an Ethernet header and two VLAN tags. Asks the
+// kernel over rtnetlink; ifindex 0 or a kernel without the attributes get the 64 KB limit.
+size_t max_gso_frame_len(int ifindex);
+
+// fills packet.gso from the virtio-net header the kernel wrote in front of the frame
+void read_vnet_header(const uint8_t* header, PacketView& packet);
+
+// Cuts a TCP or UDP super-frame into the frames it stands for. Each segment is the headers of
+// the super-frame with lengths, IPv4 id, TCP sequence number and flags and the checksums fixed
+// up, followed by its share of the payload. Segments are built one at a time in a buffer that
+// is reused, so frames that are not super-frames cost nothing.
+class GsoSegmenter {
+public:
+    // false when the frame is no super-frame or can't be cut: truncated by the snap length,
+    // or headers other than Ethernet, IPv4 or IPv6 and TCP or UDP
+    bool begin(const PacketView& packet);
+    // the next segment, valid until the following call; false once all were handed out
+    bool next(PacketView& segment);
+
+private:
+    PacketView m_packet;
+    size_t m_l3 = 0;      // offset of the IP header
+    size_t m_l4 = 0;      // offset of the TCP or UDP header
+    size_t m_header = 0;  // offset of the payload
+    bool m_ipv6 = false;
+    bool m_tcp = false;
+    size_t m_offset = 0;  // payload bytes already handed out
+    uint32_t m_index = 0;
+    std::vector<uint8_t> m_buffer;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef HUGEPAGES_HPP
+#define HUGEPAGES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum class HugePageMode {
+    Off,     // normal pages only
+    Auto,    // 1 GB or 2 MB hugepages for buffers of at least that size, else transparent ones
+    Huge2M,  // 2 MB hugepages whatever the size, normal pages when none are free
+    Huge1G,  // 1 GB hugepages, then 2 MB ones, then normal pages
+};
+
+// accepts "auto", "off", "2m" and "1g"
+bool parse_huge_page_mode(const std::string& name, HugePageMode& mode);
+
+// what a HugeBuffer ended up being backed with
+enum class PageBacking {
+    None,         // nothing allocated
+    Normal,       // base pages
+    Transparent,  // base pages advised with MADV_HUGEPAGE, the kernel may collapse them
+    Huge2M,       // hugetlb 2 MB pages
+    Huge1G,       // hugetlb 1 GB pages
+};
+
+// "2 MB hugepages", "normal pages", ...
+const char* page_backing_name(PageBacking backing);
+
+// Anonymous mapping for packet buffers, backed by hugetlb pages when the pool has free ones so
+// that walking a large buffer takes few TLB entries. Pages are faulted in by allocate(), so they
+// land on the NUMA node preferred by the calling thread's policy, see affinity.hpp.
+class HugeBuffer {
+public:
+    HugeBuffer() = default;
+    ~HugeBuffer();
+
+    HugeBuffer(const HugeBuffer&) = delete;
+    HugeBuffer& operator=(const HugeBuffer&) = delete;
+
+    // zero-filled; falls back page size by page size down to normal pages and fails only
+    // when none are left, warning when an explicit hugepage size could not be had
+    bool allocate(size_t size, HugePageMode mode);
+    void release();
+
+    uint8_t* data() const {
+        return m_data;
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+    PageBacking backing() const {
+        return m_backing;
+    }
+
+private:
+    uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_mapped = 0;  // m_size rounded up to the page size of the backing
+    PageBacking m_backing = PageBacking::None;
+
+    bool map(size_t size, int flags, size_t page_size, PageBacking backing);
+};
+
+#endif
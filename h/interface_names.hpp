@@ -0,0 +1,30 @@
+#ifndef INTERFACE_NAMES_HPP
+#define INTERFACE_NAMES_HPP
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+// ifindex -> interface name, resolved with if_indextoname() the first time an index is asked
+// for and kept from then on, so labelling the frames of a capture on every interface costs one
+// SIOCGIFNAME per interface instead of one per frame. Not thread-safe; each pipeline and writer
+// keeps its own.
+class InterfaceNames {
+public:
+    // names ifindex without asking the kernel, e.g. with the name it was opened by
+    void set(int ifindex, const std::string& name);
+
+    // the interface's name; empty for ifindex 0 and for an index that no longer resolves, which
+    // is remembered as well
+    const std::string& lookup(int ifindex);
+
+    // indexes resolved or set so far
+    size_t size() const {
+        return m_names.size();
+    }
+
+private:
+    std::unordered_map<int, std::string> m_names;
+};
+
+#endif
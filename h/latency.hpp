@@ -0,0 +1,44 @@
+#ifndef LATENCY_HPP
+#define LATENCY_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Fixed-size log-linear histogram of nanosecond latencies: every power of two is split into 16
+// linear sub-buckets, so a percentile is off by at most 1/16 of its value. record() does not
+// allocate and is meant for the capture thread; merge workers' histograms after they stop.
+class LatencyHistogram {
+public:
+    void record(uint64_t ns);
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    uint64_t count() const {
+        return m_count;
+    }
+
+    uint64_t max() const {
+        return m_max;
+    }
+
+    // upper bound of the bucket holding the p-th percentile, p in [0, 100]; 0 when empty
+    uint64_t percentile(double p) const;
+
+    // "p50 1.2 us, p90 ..., max ... (N samples)"
+    std::string summary() const;
+
+private:
+    static constexpr size_t SUB_BUCKETS = 16;
+    static constexpr size_t BUCKETS = 64 * SUB_BUCKETS;
+
+    std::array<uint64_t, BUCKETS> m_buckets{};
+    uint64_t m_count = 0;
+    uint64_t m_max = 0;
+
+    static size_t bucket_index(uint64_t ns);
+    static uint64_t bucket_upper_bound(size_t index);
+};
+
+#endif
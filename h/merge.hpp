@@ -0,0 +1,44 @@
+#ifndef MERGE_HPP
+#define MERGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "packet.hpp"
+
+// Reorders frames from several captures into one timestamp-ordered stream. Frames are copied in,
+// because ring and UMEM memory goes back to the kernel as soon as a batch is delivered, and held
+// until the caller's watermark passes their timestamp. Frames with equal timestamps keep the
+// order they were pushed in.
+class FrameMerger {
+public:
+    void push(const PacketView* packets, size_t count);
+
+    // delivers every held frame stamped at or before watermark_ns, oldest first; returns how
+    // many were delivered
+    size_t flush(uint64_t watermark_ns, const std::function<void(const PacketView*, size_t)>& fn);
+    size_t flush_all(const std::function<void(const PacketView*, size_t)>& fn);
+
+    size_t pending() const {
+        return m_frames.size();
+    }
+
+    void clear();
+
+private:
+    // the view keeps its metadata, its data pointer is stale once copied in
+    struct Frame {
+        size_t offset;
+        PacketView view;
+    };
+
+    std::vector<Frame> m_frames;
+    std::vector<uint8_t> m_data;
+    // scratch space reused between flushes
+    std::vector<uint8_t> m_spare;
+    std::vector<PacketView> m_views;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef MULTI_CAPTURE_HPP
+#define MULTI_CAPTURE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "capture.hpp"
+#include "latency.hpp"
+#include "merge.hpp"
+#include "packet.hpp"
+#include "stop_signal.hpp"
+
+// Captures several interfaces from one thread: every capturer's descriptor sits in one epoll
+// set, ready ones are drained without blocking, and their frames are merged into a single
+// timestamp-ordered stream. A frame is held for the merge window so a slightly later frame of
+// another interface can still be put in front of it.
+class MultiCapturer {
+public:
+    MultiCapturer() = default;
+    ~MultiCapturer();
+
+    MultiCapturer(const MultiCapturer&) = delete;
+    MultiCapturer& operator=(const MultiCapturer&) = delete;
+
+    // opens one capturer per interface with the same config; recv mode is upgraded to batches
+    // so one wakeup drains everything queued on a socket
+    bool open(const std::vector<std::string>& ifaces, bool promisc, const CaptureConfig& config);
+
+    void set_merge_window(uint32_t ms) {
+        m_window_ns = static_cast<uint64_t>(ms) * 1000000ULL;
+    }
+
+    // delivers frames of all interfaces in timestamp order, each tagged with its ifindex; the
+    // data pointers are valid during the callback only
+    void run_batch(const std::function<void(const PacketView*, size_t)>& callback,
+                   std::atomic<bool>& running);
+    // the stop signal's eventfd joins the epoll set, so a request or the deadline ends the loop
+    // without waiting for traffic
+    void run_batch(const std::function<void(const PacketView*, size_t)>& callback,
+                   const StopSignal& stop);
+
+    void close();
+
+    size_t size() const {
+        return m_capturers.size();
+    }
+
+    const PacketCapturer& capturer(size_t index) const {
+        return *m_capturers[index];
+    }
+
+    PacketCapturer& capturer(size_t index) {
+        return *m_capturers[index];
+    }
+
+    // delivery latency of every interface together; read it only after run_batch() has returned
+    LatencyHistogram latency() const;
+
+private:
+    std::vector<std::unique_ptr<PacketCapturer>> m_capturers;
+    int m_epoll_fd = -1;
+    uint64_t m_window_ns = 10000000ULL;
+    FrameMerger m_merger;
+
+    // stops when running is cleared or stop fires; either may be null
+    void run_loop(const std::function<void(const PacketView*, size_t)>& callback,
+                  const std::atomic<bool>* running, const StopSignal* stop);
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef PACKET_HPP
+#define PACKET_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// snap length of the filter and the writers when none is given, as in tcpdump; long enough for
+// a GSO super-frame, which is cut into segments only on export
+constexpr uint32_t DEFAULT_SNAPLEN = 262144;
+
+enum class PacketDirection : uint8_t {
+    Unknown,
+    Inbound,   // received by the host, addressed to it or seen in promiscuous mode
+    Outbound,  // sent by the host
+};
+
+// How a frame reached the capture socket, from the sll_pkttype the kernel reports with it.
+enum class PacketType : uint8_t {
+    Unknown,
+    Host,       // unicast to this host
+    Broadcast,
+    Multicast,
+    OtherHost,  // unicast to another host, seen in promiscuous mode
+    Outgoing,   // sent by this host
+};
+
+inline const char* packet_type_name(PacketType type) {
+    switch (type) {
+        case PacketType::Host:
+            return "host";
+        case PacketType::Broadcast:
+            return "broadcast";
+        case PacketType::Multicast:
+            return "multicast";
+        case PacketType::OtherHost:
+            return "otherhost";
+        case PacketType::Outgoing:
+            return "outgoing";
+        case PacketType::Unknown:
+            break;
+    }
+    return "unknown";
+}
+
+// Segmentation offload details of a super-frame, from the virtio-net header PACKET_VNET_HDR puts
+// in front of each frame: GRO merged it on receive, or the stack built it for a device that
+// segments on transmit. It stands for several wire frames of size payload bytes each.
+struct GsoInfo {
+    uint8_t type = 0;          // VIRTIO_NET_HDR_GSO_TCPV4, _TCPV6 or _UDP_L4, 0 for a plain frame
+    bool needs_csum = false;   // the L4 checksum is partial, over the pseudo-header only
+    uint16_t size = 0;         // payload bytes per segment
+    uint16_t csum_start = 0;   // L4 header offset when needs_csum is set
+    uint16_t csum_offset = 0;  // checksum field, relative to csum_start
+};
+
+// A captured frame as handed out by a capture source. The data pointer belongs to the source
+// (ring slot or receive buffer) and is only valid until the callback that received it returns.
+struct PacketView {
+    const uint8_t* data = nullptr;
+    size_t len = 0;
+    uint64_t ts_ns = 0;   // kernel receive time, nanoseconds since the Unix epoch
+    size_t orig_len = 0;  // length on the wire when the frame was cut to a snap length, else 0
+    int ifindex = 0;      // interface the frame was received on, 0 if unknown
+    PacketDirection direction = PacketDirection::Unknown;
+    PacketType type = PacketType::Unknown;
+
+    // 802.1Q/802.1ad tag the NIC or the kernel took out of the frame before delivery. data never
+    // contains it; the writers put it back behind the MAC addresses.
+    uint16_t vlan_tci = 0;
+    uint16_t vlan_tpid = 0;  // 0x8100 or 0x88a8, 0 when no tag was stripped
+
+    // filled in only when the capture reads virtio-net headers, see gso.hpp
+    GsoInfo gso;
+
+    size_t wire_len() const {
+        return orig_len > len ? orig_len : len;
+    }
+
+    bool has_vlan() const {
+        return vlan_tpid != 0;
+    }
+
+    uint16_t vlan_id() const {
+        return vlan_tci & 0x0fff;
+    }
+
+    bool is_gso() const {
+        return gso.type != 0 && gso.size > 0;
+    }
+};
+
+#endif
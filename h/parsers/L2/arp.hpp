@@ -2,8 +2,8 @@
 #define ARP_HPP
 
 #include <cstdint>
-#include <string>
 
+#include "parsers/address.hpp"
 #include "parsers/protocol_parser.hpp"
 
 struct ArpPacket {
@@ -12,20 +12,25 @@ struct ArpPacket {
     uint8_t hw_addr_len;
     uint8_t proto_addr_len;
     uint16_t opcode;
-    std::string sender_mac;
-    std::string sender_ip;
-    std::string target_mac;
-    std::string target_ip;
+    MacAddress sender_mac;
+    Ipv4Address sender_ip;
+    MacAddress target_mac;
+    Ipv4Address target_ip;
 };
 
 class ArpParser : public ProtocolParser {
 public:
     bool parse(const uint8_t* data, size_t len) override;
-    void print() const override;
+    void print(std::ostream& os) const override;
     const char* protocol_name() const override {
         return "ARP";
     }
 
+    // the last packet parse() accepted
+    const ArpPacket& packet() const {
+        return m_packet;
+    }
+
 private:
     ArpPacket m_packet;
 };
@@ -2,8 +2,8 @@
 #define IPV4_HPP
 
 #include <cstdint>
-#include <string>
 
+#include "parsers/address.hpp"
 #include "parsers/protocol_parser.hpp"
 
 struct Ipv4Packet {
@@ -16,18 +16,23 @@ struct Ipv4Packet {
     uint8_t ttl;
     uint8_t protocol;
     uint16_t checksum;
-    std::string src_ip;
-    std::string dst_ip;
+    Ipv4Address src_ip;
+    Ipv4Address dst_ip;
 };
 
 class Ipv4Parser : public ProtocolParser {
 public:
     bool parse(const uint8_t* data, size_t len) override;
-    void print() const override;
+    void print(std::ostream& os) const override;
     const char* protocol_name() const override {
         return "IPv4";
     }
 
+    // fields of the last parse() call, complete only when it returned true
+    const Ipv4Packet& packet() const {
+        return m_packet;
+    }
+
 private:
     Ipv4Packet m_packet;
     const char* get_protocol_name(uint8_t protocol) const;
@@ -0,0 +1,62 @@
+#ifndef ADDRESS_HPP
+#define ADDRESS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Addresses as decoded from a frame: the raw bytes in network order, copied out of the packet so
+// a parse result owns no heap memory. Text forms are produced only when something is printed.
+
+struct MacAddress {
+    std::array<uint8_t, 6> bytes{};
+
+    // copies the six bytes at data
+    static MacAddress from(const uint8_t* data);
+
+    // group bit, set for multicast and broadcast destinations
+    bool is_multicast() const {
+        return (bytes[0] & 0x01) != 0;
+    }
+};
+
+struct Ipv4Address {
+    std::array<uint8_t, 4> bytes{};
+
+    static Ipv4Address from(const uint8_t* data);
+};
+
+inline bool operator==(const MacAddress& a, const MacAddress& b) {
+    return a.bytes == b.bytes;
+}
+
+inline bool operator!=(const MacAddress& a, const MacAddress& b) {
+    return !(a == b);
+}
+
+inline bool operator==(const Ipv4Address& a, const Ipv4Address& b) {
+    return a.bytes == b.bytes;
+}
+
+inline bool operator!=(const Ipv4Address& a, const Ipv4Address& b) {
+    return !(a == b);
+}
+
+// longest text forms, without the terminating NUL
+constexpr size_t MAC_TEXT_LEN = 17;   // "aa:bb:cc:dd:ee:ff"
+constexpr size_t IPV4_TEXT_LEN = 15;  // "255.255.255.255"
+
+// write the text form into out, NUL-terminated, and return its length
+size_t format_address(const MacAddress& mac, char (&out)[MAC_TEXT_LEN + 1]);
+size_t format_address(const Ipv4Address& ip, char (&out)[IPV4_TEXT_LEN + 1]);
+
+// lower-case colon-separated hex and dotted quad, straight into the stream
+std::ostream& operator<<(std::ostream& os, const MacAddress& mac);
+std::ostream& operator<<(std::ostream& os, const Ipv4Address& ip);
+
+std::string to_string(const MacAddress& mac);
+std::string to_string(const Ipv4Address& ip);
+
+#endif
@@ -3,11 +3,14 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <string>
 
+#include "parsers/address.hpp"
+
+// Decoded Ethernet header. It holds no heap memory, so filling one per packet never allocates;
+// the payload points into the frame.
 struct EthernetFrame {
-    std::string src_mac;
-    std::string dst_mac;
+    MacAddress src_mac;
+    MacAddress dst_mac;
     uint16_t ethertype;
     const uint8_t* payload;
     size_t payload_len;
@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <ostream>
 #include <unordered_map>
 
 class ProtocolParser {
@@ -11,13 +12,14 @@ public:
     virtual ~ProtocolParser() = default;
 
     virtual bool parse(const uint8_t* data, size_t len) = 0;
-    virtual void print() const = 0;
+    virtual void print(std::ostream& os) const = 0;
     virtual const char* protocol_name() const = 0;
 
+    // parsers keep per-packet state, so every capture thread gets its own instances
     static ProtocolParser* get_parser(uint16_t ethertype);
 
 private:
-    static std::unordered_map<uint16_t, std::unique_ptr<ProtocolParser>> s_parsers;
+    static thread_local std::unordered_map<uint16_t, std::unique_ptr<ProtocolParser>> s_parsers;
     static ProtocolParser* create_parser(uint16_t ethertype);
 };
 
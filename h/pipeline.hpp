@@ -0,0 +1,76 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include "cli.hpp"
+#include "export/writer.hpp"
+#include "interface_names.hpp"
+#include "packet.hpp"
+
+// Parse/print/export stage for one capture thread. Each worker owns its pipeline, counter and
+// writer, so nothing on the per-packet path is shared between threads.
+class Pipeline {
+public:
+    // worker_id < 0 marks the single-threaded pipeline and drops the worker tag from the output;
+    // writer may be null when nothing is exported
+    Pipeline(const CliOptions& opts, PacketWriter* writer, int worker_id = -1);
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    void on_frame(const uint8_t* data, size_t len);
+    // exports the batch with one flush and prints it under one console lock; with
+    // CliOptions::record_only set frames are only exported and counted, never parsed
+    void on_batch(const PacketView* packets, size_t count);
+
+    // stop counting, exporting and printing after this many frames; 0 means no limit
+    void set_packet_limit(uint64_t limit) {
+        m_packet_limit = limit;
+    }
+
+    // prefixes frames received on ifindex with the interface name, for merged captures
+    void set_interface_name(int ifindex, const std::string& name) {
+        m_interface_names.set(ifindex, name);
+        m_label_interfaces = true;
+    }
+
+    // prefixes every frame with the name of the interface it was received on, looked up the
+    // first time each ifindex shows up, for a capture on every interface
+    void label_interfaces() {
+        m_label_interfaces = true;
+    }
+
+    bool limit_reached() const {
+        return m_packet_limit > 0 && packet_count() >= m_packet_limit;
+    }
+
+    // safe to read from other threads while the owner is capturing
+    uint64_t packet_count() const {
+        return m_packet_count.load(std::memory_order_relaxed);
+    }
+
+private:
+    const CliOptions& m_opts;
+    PacketWriter* m_writer;
+    int m_worker_id;
+    uint64_t m_packet_limit = 0;
+    InterfaceNames m_interface_names;
+    bool m_label_interfaces = false;
+
+    alignas(64) std::atomic<uint64_t> m_packet_count{0};
+
+    // a packet is formatted here first so lines of concurrent workers do not interleave
+    std::ostringstream m_out;
+
+    // counts and prints one frame without exporting it or flushing the console buffer
+    void process(const PacketView& packet);
+    void print_hex_dump(const uint8_t* data, size_t len);
+    void flush_output();
+};
+
+#endif
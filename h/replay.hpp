@@ -0,0 +1,105 @@
+#ifndef REPLAY_HPP
+#define REPLAY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "packet.hpp"
+#include "stop_signal.hpp"
+
+// Classic PCAP file (microsecond or nanosecond magic, either byte order) mapped into memory, with
+// one view per record. The views point into the mapping and stay valid until close().
+class PcapReader {
+public:
+    PcapReader() = default;
+    ~PcapReader();
+
+    PcapReader(const PcapReader&) = delete;
+    PcapReader& operator=(const PcapReader&) = delete;
+
+    // only Ethernet (linktype 1) files are accepted; a truncated last record is dropped with a
+    // warning
+    bool open(const std::string& filename);
+    void close();
+
+    const std::vector<PacketView>& frames() const {
+        return m_frames;
+    }
+
+private:
+    uint8_t* m_map = nullptr;
+    size_t m_map_size = 0;
+    std::vector<PacketView> m_frames;
+};
+
+struct ReplayConfig {
+    // multiple of the original speed, so 1 keeps the file's timestamps and 0 sends at top speed
+    double speed = 1.0;
+    uint32_t frame_count = 1024;  // TX ring slots
+    // hand frames straight to the driver, skipping the qdisc layer; frames are dropped instead of
+    // queued when the device queue is full
+    bool qdisc_bypass = false;
+};
+
+// "max" -> 0 (top speed), otherwise a positive multiplier such as "1", "2" or "0.5"
+bool parse_replay_speed(const std::string& text, double& speed);
+
+struct ReplayStats {
+    uint64_t frames = 0;   // frames handed to the kernel
+    uint64_t bytes = 0;    // their Ethernet frame bytes, without preamble and FCS
+    uint64_t skipped = 0;  // longer than the interface MTU allows or shorter than a header
+    uint64_t elapsed_ns = 0;
+
+    double pps() const {
+        return elapsed_ns > 0 ? static_cast<double>(frames) * 1e9 / elapsed_ns : 0.0;
+    }
+
+    double gbps() const {
+        return elapsed_ns > 0 ? static_cast<double>(bytes) * 8.0 / elapsed_ns : 0.0;
+    }
+};
+
+// Transmits frames through a TPACKET_V2 PACKET_TX_RING: frames are copied into mmap'd slots and
+// the kernel is kicked with one send() per batch, so sending costs no syscall per frame.
+class PacketReplayer {
+public:
+    PacketReplayer() = default;
+    ~PacketReplayer();
+
+    PacketReplayer(const PacketReplayer&) = delete;
+    PacketReplayer& operator=(const PacketReplayer&) = delete;
+
+    bool open(const std::string& iface, const ReplayConfig& config);
+    void close();
+
+    // sends the frames in order, paced by their ts_ns unless the speed is 0, until the end or
+    // the stop signal; returns once the kernel has sent everything queued. False on a send error.
+    bool replay(const PacketView* frames, size_t count, const StopSignal& stop);
+
+    const ReplayStats& stats() const {
+        return m_stats;
+    }
+
+private:
+    int m_fd = -1;
+    uint8_t* m_ring = nullptr;
+    size_t m_ring_size = 0;
+    uint32_t m_frame_size = 0;
+    uint32_t m_frame_count = 0;
+    uint32_t m_slot = 0;
+    size_t m_max_len = 0;  // longest frame the device takes
+    double m_speed = 1.0;
+    bool m_failed = false;
+    ReplayStats m_stats;
+
+    bool setup_ring(size_t max_len, uint32_t frame_count);
+    // the next free slot, kicking the kernel and waiting while the ring is full; null once
+    // stopped
+    uint8_t* next_slot(const StopSignal& stop);
+    // asks the kernel to send every queued slot; wait blocks until they are all sent
+    bool kick(bool wait);
+};
+
+#endif
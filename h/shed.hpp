@@ -0,0 +1,108 @@
+#ifndef SHED_HPP
+#define SHED_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "packet.hpp"
+
+enum class ShedLevel : uint8_t {
+    None,
+    Headers,  // frames cut to LoadShedConfig::header_bytes
+    Sample,   // cut, and only one frame in sample_rate kept
+    Drop,     // nothing delivered
+};
+
+// "none", "headers", "sample", "drop"
+const char* shed_level_name(ShedLevel level);
+
+struct LoadShedConfig {
+    bool enabled = false;
+    uint32_t header_bytes = 128;  // room for Ethernet, a VLAN tag, IPv6 and TCP with options
+    uint32_t sample_rate = 8;
+
+    // buffer fill, queued bytes or user-owned ring blocks, that moves the capture to each level
+    double headers_at = 0.5;
+    double sample_at = 0.75;
+    double drop_at = 0.9;
+
+    // the fill has to stay below the current level's threshold this long for each step down
+    uint32_t recover_ms = 200;
+};
+
+// one stretch of time the capture spent at a shedding level
+struct ShedInterval {
+    ShedLevel level = ShedLevel::None;
+    uint32_t header_bytes = 0;
+    uint32_t sample_rate = 0;
+    uint64_t start_ns = 0;  // wall clock
+    uint64_t end_ns = 0;
+    uint64_t frames = 0;   // frames that arrived in it
+    uint64_t cut = 0;      // delivered cut to header_bytes
+    uint64_t skipped = 0;  // sampled out or dropped, never delivered
+    double peak_fill = 0.0;
+};
+
+// "frames cut to 128 bytes, 1 in 8 kept, 0.42 s: 9000 frames, 1125 cut, 7875 skipped, 93% full"
+std::string describe_shed_interval(const ShedInterval& interval);
+
+// Overload policy of one capture. A fill sample above a threshold moves it straight to that
+// level; stepping down goes one level per recover_ms of calm, so a burst that keeps coming back
+// does not flap the capture between full frames and headers. The levels are applied to each
+// batch in place before it is delivered, and every stretch at a level other than None is
+// recorded.
+class LoadShedder {
+public:
+    LoadShedder() = default;
+    explicit LoadShedder(const LoadShedConfig& config);
+
+    bool enabled() const {
+        return m_config.enabled;
+    }
+
+    ShedLevel level() const {
+        return m_level;
+    }
+
+    // one fill sample at wall-clock now_ns; true when the level changed
+    bool update(double fill, uint64_t now_ns);
+
+    // cuts, samples or drops the batch at the current level, compacting the kept views to the
+    // front; returns how many are left
+    size_t apply(PacketView* packets, size_t count);
+
+    // intervals already over, oldest first
+    const std::vector<ShedInterval>& finished() const {
+        return m_finished;
+    }
+
+    // the interval in progress; its level is None when nothing is being shed
+    const ShedInterval& current() const {
+        return m_current;
+    }
+
+    uint64_t total_cut() const {
+        return m_total_cut;
+    }
+
+    uint64_t total_skipped() const {
+        return m_total_skipped;
+    }
+
+private:
+    LoadShedConfig m_config;
+    ShedLevel m_level = ShedLevel::None;
+    uint64_t m_calm_since = 0;  // first calm sample since the last change, 0 while pressed
+    uint32_t m_sample_phase = 0;
+    ShedInterval m_current;
+    std::vector<ShedInterval> m_finished;
+    uint64_t m_total_cut = 0;
+    uint64_t m_total_skipped = 0;
+
+    ShedLevel level_for(double fill) const;
+    void enter(ShedLevel level, uint64_t now_ns);
+};
+
+#endif
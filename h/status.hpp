@@ -0,0 +1,47 @@
+#ifndef STATUS_HPP
+#define STATUS_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "capture.hpp"
+
+// "1200 received, 3 dropped (0.25%)", plus ring freezes and shed frames when there were any
+std::string format_capture_stats(const CaptureStats& stats);
+
+// sums poll_stats() over the capturers
+CaptureStats poll_capture_stats(const std::vector<PacketCapturer*>& capturers);
+
+// Prints a status line with the user-space count and the kernel counters every interval from its
+// own thread until stop().
+class StatusReporter {
+public:
+    // captured returns the frames counted by the pipelines so far; interval_s 0 prints nothing
+    StatusReporter(std::vector<PacketCapturer*> capturers, std::function<uint64_t()> captured,
+                   int interval_s, std::ostream& out);
+    ~StatusReporter();
+
+    StatusReporter(const StatusReporter&) = delete;
+    StatusReporter& operator=(const StatusReporter&) = delete;
+
+    void stop();
+
+private:
+    std::vector<PacketCapturer*> m_capturers;
+    std::function<uint64_t()> m_captured;
+    std::ostream& m_out;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    bool m_running = true;  // guarded by m_mutex
+    std::thread m_thread;
+
+    void run(int interval_s);
+};
+
+#endif
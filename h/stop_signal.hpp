@@ -0,0 +1,50 @@
+#ifndef STOP_SIGNAL_HPP
+#define STOP_SIGNAL_HPP
+
+#include <atomic>
+#include <cstdint>
+
+// Shutdown request shared by the capture loops and whatever ends them: a signal handler, a
+// packet limit or the capture deadline. request() also makes an eventfd readable, so a loop
+// sleeping in poll() or epoll_wait() next to its sockets wakes at once instead of after the next
+// frame. The deadline needs no timer thread; the loops shorten their poll timeout to reach it.
+class StopSignal {
+public:
+    StopSignal();
+    ~StopSignal();
+
+    StopSignal(const StopSignal&) = delete;
+    StopSignal& operator=(const StopSignal&) = delete;
+
+    // async-signal-safe, may be called from any thread
+    void request();
+
+    // true once request() was called or the deadline has passed
+    bool requested() const;
+
+    // requested() turns true duration_ms from now; 0 clears the deadline
+    void set_deadline_in(uint64_t duration_ms);
+
+    // poll() timeout for a loop that re-checks requested() when it wakes: max_ms, or the time
+    // left to the deadline rounded up when that is shorter, 0 once stopped
+    int timeout_ms(int max_ms) const;
+
+    // sleeps until a request, the deadline or max_ms, whichever comes first; returns requested()
+    bool wait(int max_ms) const;
+
+    // readable from the first request() until reset(); -1 if no eventfd could be created, in
+    // which case the loops still notice a request within their poll interval
+    int fd() const {
+        return m_fd;
+    }
+
+    // clears the request and the deadline so the signal can be used again
+    void reset();
+
+private:
+    int m_fd = -1;
+    std::atomic<bool> m_requested{false};
+    std::atomic<uint64_t> m_deadline_ns{0};  // CLOCK_MONOTONIC, 0 for none
+};
+
+#endif
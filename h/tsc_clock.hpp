@@ -0,0 +1,113 @@
+#ifndef TSC_CLOCK_HPP
+#define TSC_CLOCK_HPP
+
+#include <time.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Wall-clock time for frames stamped in user space. Until calibrate_tsc_clock() succeeds,
+// wall_clock_ns() is clock_gettime(CLOCK_REALTIME); after it, one read of the invariant TSC (the
+// generic timer's virtual counter on arm64) scaled by a rate and offset taken from
+// CLOCK_REALTIME. Next to a vDSO clock_gettime() that saves little, 26 ns against 41 ns per call
+// in a VM, so callers still read it once per batch rather than per frame. The counter and an
+// NTP-disciplined clock drift apart, so a TscResync thread takes a fresh reading now and then.
+
+namespace tsc_detail {
+
+// published under a sequence lock, odd while an update is in progress:
+// ns = base_ns + (ticks - base_ticks) * mult / 2^32
+inline std::atomic<uint32_t> seq{0};
+inline std::atomic<uint64_t> base_ticks{0};
+inline std::atomic<uint64_t> base_ns{0};
+inline std::atomic<uint64_t> mult{0};  // 0 until calibrated
+
+inline uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t value;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return 0;
+#endif
+}
+
+inline uint64_t realtime_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+}  // namespace tsc_detail
+
+// Measures the counter's rate against CLOCK_REALTIME over a few milliseconds and switches
+// wall_clock_ns() to it; false, leaving wall_clock_ns() on the clock, when the CPU has no
+// invariant counter
+bool calibrate_tsc_clock();
+
+// re-measures the counter's rate since the last reading and slews the clock towards
+// CLOCK_REALTIME, so it never jumps back; only a step of the system clock itself is followed at
+// once. Nothing happens before calibrate_tsc_clock() succeeded.
+void resync_tsc_clock();
+
+// true once wall_clock_ns() reads the counter
+bool tsc_clock_active();
+
+// counter ticks per second the clock runs at, slewing included, 0 before calibration
+uint64_t tsc_clock_hz();
+
+// nanoseconds since the epoch; safe to call from any thread while a resync runs
+inline uint64_t wall_clock_ns() {
+    using namespace tsc_detail;
+    uint32_t before = 0;
+    uint64_t ticks0 = 0;
+    uint64_t ns0 = 0;
+    uint64_t rate = 0;
+    do {
+        before = seq.load(std::memory_order_acquire);
+        ticks0 = base_ticks.load(std::memory_order_relaxed);
+        ns0 = base_ns.load(std::memory_order_relaxed);
+        rate = mult.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((before & 1) != 0 || before != seq.load(std::memory_order_relaxed));
+
+    if (rate == 0) {
+        return realtime_ns();
+    }
+    // a counter read on another core may trail the base by a little
+    const auto delta = static_cast<int64_t>(ticks() - ticks0);
+    return ns0 + static_cast<uint64_t>(static_cast<int64_t>(
+                     (static_cast<__int128>(delta) * static_cast<__int128>(rate)) >> 32));
+}
+
+// Calls resync_tsc_clock() every interval from its own thread until stop().
+class TscResync {
+public:
+    // interval_ms 0 starts no thread
+    explicit TscResync(int interval_ms);
+    ~TscResync();
+
+    TscResync(const TscResync&) = delete;
+    TscResync& operator=(const TscResync&) = delete;
+
+    void stop();
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    bool m_running = true;  // guarded by m_mutex
+    std::thread m_thread;
+
+    void run(int interval_ms);
+};
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef XDP_HPP
+#define XDP_HPP
+
+#include <linux/if_xdp.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "hugepages.hpp"
+#include "packet.hpp"
+
+enum class XdpBindMode {
+    Auto,      // zero-copy when the driver supports it, copy otherwise
+    Copy,      // XDP_COPY, the kernel copies each frame into UMEM
+    ZeroCopy,  // XDP_ZEROCOPY, the NIC DMAs straight into UMEM; fails if unsupported
+};
+
+// accepts "auto", "copy" and "zerocopy"
+bool parse_xdp_bind_mode(const std::string& name, XdpBindMode& mode);
+
+struct XdpConfig {
+    uint32_t frame_size = 2048;   // UMEM chunk, power of two between 2048 and the page size
+    uint32_t frame_count = 4096;  // power of two, also the size of the fill and RX rings
+    uint32_t queue_id = 0;        // only this RX queue is redirected to the socket
+    XdpBindMode bind = XdpBindMode::Auto;
+    bool generic = false;  // attach in generic (skb) mode without trying the driver hook first
+    HugePageMode huge_pages = HugePageMode::Auto;  // page size behind UMEM
+};
+
+// AF_XDP socket with its UMEM frame pool and the XDP program that redirects one RX queue to
+// it. Frames are read in place from UMEM; received frames stay with the caller until
+// release() returns them to the fill ring.
+class XdpSocket {
+public:
+    XdpSocket() = default;
+    ~XdpSocket();
+
+    XdpSocket(const XdpSocket&) = delete;
+    XdpSocket& operator=(const XdpSocket&) = delete;
+
+    // attaches in native mode and falls back to generic XDP unless config.generic is set
+    bool open(int ifindex, const XdpConfig& config);
+    void close();
+
+    // fills up to max views with frames from the RX ring; 0 when the ring is empty
+    size_t receive(PacketView* packets, size_t max);
+    // hands the frames of the last receive() back to the kernel
+    void release();
+    // false on a poll() error other than EINTR
+    bool wait(int timeout_ms);
+    // the kernel's cumulative drop counters of this socket
+    bool statistics(struct xdp_statistics& stats) const;
+
+    bool is_open() const {
+        return m_fd >= 0;
+    }
+
+    int get_fd() const {
+        return m_fd;
+    }
+
+    bool zero_copy() const {
+        return m_zero_copy;
+    }
+
+    bool generic() const {
+        return m_generic;
+    }
+
+    PageBacking umem_backing() const {
+        return m_umem.backing();
+    }
+
+private:
+    // producer/consumer ring shared with the kernel through mmap()
+    struct Ring {
+        uint32_t* producer = nullptr;
+        uint32_t* consumer = nullptr;
+        uint32_t* flags = nullptr;
+        void* descs = nullptr;
+        uint32_t mask = 0;
+        void* map = nullptr;
+        size_t map_size = 0;
+    };
+
+    int m_fd = -1;
+    int m_map_fd = -1;
+    int m_prog_fd = -1;
+    int m_link_fd = -1;
+    bool m_zero_copy = false;
+    bool m_generic = false;
+
+    HugeBuffer m_umem;
+    XdpConfig m_config;
+
+    Ring m_fill;
+    Ring m_completion;
+    Ring m_rx;
+    uint32_t m_pending = 0;  // frames handed out by receive() and not yet released
+
+    bool attach_program(int ifindex);
+    bool create_socket(int ifindex, uint16_t bind_flags);
+    void destroy_socket();
+    bool map_ring(Ring& ring, uint64_t pgoff, const struct xdp_ring_offset& offsets,
+                  size_t entry_size, uint32_t entries);
+};
+
+#endif
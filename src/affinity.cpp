@@ -0,0 +1,155 @@
+#include "affinity.hpp"
+
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+constexpr int MAX_NUMA_NODES = 64;
+
+bool parse_cpu(const std::string& text, int& cpu) {
+    if (text.empty() || text.size() > 5 ||
+        text.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    cpu = std::stoi(text);
+    return cpu < CPU_SETSIZE;
+}
+
+long set_mempolicy(int mode, const unsigned long* nodemask, unsigned long maxnode) {
+    return syscall(SYS_set_mempolicy, mode, nodemask, maxnode);
+}
+
+}  // namespace
+
+bool parse_cpu_list(const std::string& list, std::vector<int>& cpus) {
+    std::vector<int> parsed;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        size_t dash = range.find('-');
+        int first = 0;
+        int last = 0;
+        if (dash == std::string::npos) {
+            if (!parse_cpu(range, first)) {
+                return false;
+            }
+            last = first;
+        } else if (!parse_cpu(range.substr(0, dash), first) ||
+                   !parse_cpu(range.substr(dash + 1), last) || first > last) {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            parsed.push_back(cpu);
+        }
+    }
+
+    if (parsed.empty()) {
+        return false;
+    }
+    cpus = parsed;
+    return true;
+}
+
+std::string format_cpu_list(const std::vector<int>& cpus) {
+    std::ostringstream out;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t end = i;
+        while (end + 1 < cpus.size() && cpus[end + 1] == cpus[end] + 1) {
+            ++end;
+        }
+        if (i > 0) {
+            out << ",";
+        }
+        out << cpus[i];
+        if (end > i) {
+            out << "-" << cpus[end];
+        }
+        i = end + 1;
+    }
+    return out.str();
+}
+
+bool parse_numa_node(const std::string& text, int& node) {
+    if (text == "auto") {
+        node = NUMA_NODE_OF_INTERFACE;
+        return true;
+    }
+    if (text == "off") {
+        node = -1;
+        return true;
+    }
+    if (text.empty() || text.size() > 2 ||
+        text.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    node = std::stoi(text);
+    return node < MAX_NUMA_NODES;
+}
+
+bool pin_current_thread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        std::cerr << "[!] Failed to pin thread to CPU " << cpu << ": " << strerror(rc) << "\n";
+        return false;
+    }
+    return true;
+}
+
+int interface_numa_node(const std::string& iface) {
+    std::ifstream file("/sys/class/net/" + iface + "/device/numa_node");
+    int node = -1;
+    if (!(file >> node)) {
+        return -1;
+    }
+    return node;
+}
+
+std::vector<int> numa_node_cpus(int node) {
+    std::vector<int> cpus;
+    if (node < 0) {
+        return cpus;
+    }
+
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    if (std::getline(file, list)) {
+        parse_cpu_list(list, cpus);
+    }
+    return cpus;
+}
+
+ScopedNumaPolicy::ScopedNumaPolicy(int node) {
+    if (node < 0 || node >= MAX_NUMA_NODES) {
+        return;
+    }
+
+    unsigned long nodemask = 1UL << node;
+    // MPOL_PREFERRED falls back to other nodes instead of failing when this one is full
+    if (set_mempolicy(MPOL_PREFERRED, &nodemask, MAX_NUMA_NODES + 1) < 0) {
+        std::cerr << "[!] set_mempolicy() failed for NUMA node " << node << ": "
+                  << strerror(errno) << "\n";
+        return;
+    }
+    m_active = true;
+}
+
+ScopedNumaPolicy::~ScopedNumaPolicy() {
+    if (m_active) {
+        set_mempolicy(MPOL_DEFAULT, nullptr, 0);
+    }
+}
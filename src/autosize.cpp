@@ -0,0 +1,83 @@
+#include "autosize.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+constexpr double GROW_FILL = 0.75;
+constexpr double QUIET_FILL = 0.25;
+
+}  // namespace
+
+bool parse_byte_size(const std::string& text, size_t& bytes) {
+    size_t digits = 0;
+    while (digits < text.size() && std::isdigit(static_cast<unsigned char>(text[digits]))) {
+        ++digits;
+    }
+    if (digits == 0 || digits > 12 || text.size() > digits + 1) {
+        return false;
+    }
+
+    size_t shift = 0;
+    if (text.size() == digits + 1) {
+        switch (std::tolower(static_cast<unsigned char>(text[digits]))) {
+            case 'k':
+                shift = 10;
+                break;
+            case 'm':
+                shift = 20;
+                break;
+            case 'g':
+                shift = 30;
+                break;
+            default:
+                return false;
+        }
+    }
+    bytes = static_cast<size_t>(std::stoull(text.substr(0, digits))) << shift;
+    return true;
+}
+
+BufferAutoSizer::BufferAutoSizer(const AutoSizeConfig& config, size_t current)
+    : m_config(config), m_current(current) {
+    if (m_config.min_bytes == 0) {
+        m_config.min_bytes = current;
+    }
+}
+
+void BufferAutoSizer::sample_fill(double fill) {
+    m_peak = std::max(m_peak, fill);
+}
+
+SizeDecision BufferAutoSizer::decide(uint64_t drops, size_t& size) {
+    m_last_peak = m_peak;
+    m_peak = 0.0;
+    size = m_current;
+
+    if (drops > 0 || m_last_peak >= GROW_FILL) {
+        m_quiet = 0;
+        if (m_current >= m_config.max_bytes) {
+            if (m_reported_cap) {
+                return SizeDecision::Hold;
+            }
+            m_reported_cap = true;
+            return SizeDecision::AtCap;
+        }
+        size = std::min(m_current * 2, m_config.max_bytes);
+        return SizeDecision::Grow;
+    }
+
+    if (m_last_peak > QUIET_FILL) {
+        m_quiet = 0;
+        return SizeDecision::Hold;
+    }
+
+    if (++m_quiet < m_config.quiet_intervals || m_current <= m_config.min_bytes) {
+        return SizeDecision::Hold;
+    }
+    m_quiet = 0;
+    m_reported_cap = false;
+    size = std::max(m_current / 2, m_config.min_bytes);
+    return SizeDecision::Shrink;
+}
@@ -3,98 +3,1037 @@
 #include <arpa/inet.h>
 #include <linux/if_ether.h>
 #include <linux/if_packet.h>
+#include <linux/sock_diag.h>
 #include <net/if.h>
+#include <poll.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+#ifndef SO_BUSY_POLL_BUDGET
+#define SO_BUSY_POLL_BUDGET 70
+#endif
+#ifndef PACKET_IGNORE_OUTGOING
+#define PACKET_IGNORE_OUTGOING 23
+#endif
+#ifndef SO_MEMINFO
+#define SO_MEMINFO 55
+#endif
+
+#include <algorithm>
 #include <cerrno>
+#include <climits>
+#include <ctime>
 #include <csignal>
 #include <cstring>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
 
+#include "filter/bpf.hpp"
+#include "tsc_clock.hpp"
+
 PacketCapturer::~PacketCapturer() {
     close();
 }
 
+namespace {
+
+// frame slot size handed to the kernel; TPACKET_V3 packs variable-length frames into
+// blocks, so this only has to satisfy the kernel's ring geometry checks
+constexpr uint32_t RING_FRAME_SIZE = 2048;
+
+// room a frame takes in a ring block besides its data: the block descriptor, tpacket3_hdr,
+// sockaddr_ll and virtio-net header, with their alignment
+constexpr size_t RING_FRAME_OVERHEAD = 256;
+
+// largest frame the recv() and recvmmsg() paths accept, unless GSO super-frames are read with
+// their virtio-net header, see max_gso_frame_len()
+constexpr size_t FRAME_BUFFER_SIZE = 65536;
+
+// how long the capture loops sleep in poll() before re-checking the running flag
+constexpr int POLL_TIMEOUT_MS = 100;
+
+// frames taken from the AF_XDP RX ring per callback when no batch size is configured
+constexpr uint32_t XDP_DEFAULT_BATCH = 64;
+
+// the busy-poll budget per syscall the kernel may spend draining the device queue
+constexpr int BUSY_POLL_BUDGET = 64;
+
+// how often the buffer fill level is sampled for auto-sizing and load shedding; often enough
+// for shedding to react within a burst, rare enough that the getsockopt() does not add up
+constexpr uint64_t FILL_SAMPLE_NS = 1000000;
+
+// smallest ring the auto-sizer suggests shrinking to
+constexpr uint32_t RING_MIN_BLOCKS = 8;
+
+// room for the SCM_TIMESTAMPNS and PACKET_AUXDATA control messages of one frame
+constexpr size_t CONTROL_BUFFER_SIZE =
+    CMSG_SPACE(sizeof(struct timespec)) + CMSG_SPACE(sizeof(struct tpacket_auxdata));
+
+uint64_t timespec_to_ns(const struct timespec& ts) {
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return timespec_to_ns(ts);
+}
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// the tag the kernel stripped, from PACKET_AUXDATA or the ring frame header; kernels before
+// 3.13 report no TPID and only ever strip 802.1Q tags
+void read_vlan(uint32_t status, uint16_t tci, uint16_t tpid, PacketView& packet) {
+    if ((status & TP_STATUS_VLAN_VALID) == 0) {
+        packet.vlan_tci = 0;
+        packet.vlan_tpid = 0;
+        return;
+    }
+    packet.vlan_tci = tci;
+    packet.vlan_tpid = (status & TP_STATUS_VLAN_TPID_VALID) != 0 ? tpid : ETH_P_8021Q;
+}
+
+// receive time from SCM_TIMESTAMPNS, wire length and stripped VLAN tag from PACKET_AUXDATA.
+// Frames the kernel did not stamp get batch_ns, the wall clock read once for the whole batch
+// by the first of them, like the AF_XDP path does.
+void read_control(const struct msghdr& msg, uint64_t& batch_ns, PacketView& packet) {
+    packet.ts_ns = 0;
+    packet.orig_len = 0;
+    packet.vlan_tci = 0;
+    packet.vlan_tpid = 0;
+
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(const_cast<struct msghdr*>(&msg), cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            struct timespec ts;
+            std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            packet.ts_ns = timespec_to_ns(ts);
+        } else if (cmsg->cmsg_level == SOL_PACKET && cmsg->cmsg_type == PACKET_AUXDATA) {
+            struct tpacket_auxdata aux;
+            std::memcpy(&aux, CMSG_DATA(cmsg), sizeof(aux));
+            packet.orig_len = aux.tp_len;
+            read_vlan(aux.tp_status, aux.tp_vlan_tci, aux.tp_vlan_tpid, packet);
+        }
+    }
+
+    if (packet.ts_ns == 0) {
+        if (batch_ns == 0) {
+            batch_ns = wall_clock_ns();
+        }
+        packet.ts_ns = batch_ns;
+    }
+}
+
+PacketDirection direction_of(unsigned char pkttype) {
+    return pkttype == PACKET_OUTGOING ? PacketDirection::Outbound : PacketDirection::Inbound;
+}
+
+// the frame's interface and how it got there, from the address the kernel reports with it
+void read_address(const struct sockaddr_ll& sll, PacketView& packet) {
+    packet.ifindex = sll.sll_ifindex;
+    packet.direction = direction_of(sll.sll_pkttype);
+    switch (sll.sll_pkttype) {
+        case PACKET_HOST:
+            packet.type = PacketType::Host;
+            break;
+        case PACKET_BROADCAST:
+            packet.type = PacketType::Broadcast;
+            break;
+        case PACKET_MULTICAST:
+            packet.type = PacketType::Multicast;
+            break;
+        case PACKET_OTHERHOST:
+            packet.type = PacketType::OtherHost;
+            break;
+        case PACKET_OUTGOING:
+            packet.type = PacketType::Outgoing;
+            break;
+        default:
+            packet.type = PacketType::Unknown;
+            break;
+    }
+}
+
+// a program returning at most snaplen, so accepted frames are cut in the kernel
+std::vector<struct sock_filter> clamp_filter(const std::vector<struct sock_filter>& program,
+                                             uint32_t snaplen) {
+    if (program.empty()) {
+        return {{static_cast<uint16_t>(BPF_RET | BPF_K), 0, 0, snaplen}};
+    }
+
+    std::vector<struct sock_filter> clamped = program;
+    for (struct sock_filter& insn : clamped) {
+        if (insn.code == (BPF_RET | BPF_K) && insn.k > snaplen) {
+            insn.k = snaplen;
+        }
+    }
+    return clamped;
+}
+
+}  // namespace
+
+bool parse_fanout_mode(const std::string& name, FanoutMode& mode) {
+    if (name == "hash") {
+        mode = FanoutMode::Hash;
+    } else if (name == "cpu") {
+        mode = FanoutMode::Cpu;
+    } else if (name == "lb") {
+        mode = FanoutMode::LoadBalance;
+    } else if (name == "rollover") {
+        mode = FanoutMode::Rollover;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parse_capture_direction(const std::string& name, CaptureDirection& direction) {
+    if (name == "both") {
+        direction = CaptureDirection::Both;
+    } else if (name == "in") {
+        direction = CaptureDirection::In;
+    } else if (name == "out") {
+        direction = CaptureDirection::Out;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 bool PacketCapturer::open(const std::string& iface, bool promisc) {
+    return open(iface, promisc, CaptureConfig{});
+}
+
+bool PacketCapturer::open(const std::string& iface, bool promisc, const CaptureConfig& config) {
+    const bool any = iface == ANY_INTERFACE;
+    if (any && config.mode == CaptureMode::Xdp) {
+        std::cerr << "[!] AF_XDP binds to one device queue, it cannot capture on every "
+                     "interface\n";
+        return false;
+    }
+    if (any && promisc) {
+        // membership is per device, and ifindex 0 names none
+        std::cerr << "[!] Warning: promiscuous mode needs a single interface, capturing on "
+                  << ANY_INTERFACE << " without it\n";
+        promisc = false;
+    }
+
     m_iface = iface;
     m_promisc = promisc;
+    m_batch_size = config.batch_size > 0 ? config.batch_size : 1;
+    m_snaplen = config.snaplen;
+    m_spin_ns = static_cast<uint64_t>(config.busy_poll_us) * 1000;
+    m_spin_deadline = 0;
+    m_measure_latency = config.measure_latency;
+    m_latency.reset();
+    m_delivered.store(0, std::memory_order_relaxed);
+    m_shed_cut.store(0, std::memory_order_relaxed);
+    m_shed_skipped.store(0, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(m_stats_mutex);
+        m_stats = CaptureStats();
+    }
+    m_frame_buffer_size = m_snaplen > 0 && m_snaplen < FRAME_BUFFER_SIZE ? m_snaplen
+                                                                         : FRAME_BUFFER_SIZE;
+    m_mode = m_batch_size > 1 ? CaptureMode::Batch : CaptureMode::Recv;
+
+    // everything allocated from here on, in the kernel or on first touch, prefers this node
+    const int numa_node =
+        config.numa_node == NUMA_NODE_OF_INTERFACE ? interface_numa_node(iface) : config.numa_node;
+    ScopedNumaPolicy numa_policy(numa_node);
+    m_numa_node = numa_policy.active() ? numa_node : -1;
 
-    m_fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    // a socket created with a protocol starts receiving from every interface at once; the
+    // AF_XDP path never binds its packet socket, so it must not have one
+    const bool want_xdp = config.mode == CaptureMode::Xdp;
+    if (want_xdp && config.direction == CaptureDirection::Out) {
+        std::cerr << "[!] AF_XDP only sees received frames, it cannot capture outgoing ones\n";
+        return false;
+    }
+    m_fd = socket(AF_PACKET, SOCK_RAW, want_xdp ? 0 : htons(ETH_P_ALL));
     if (m_fd < 0) {
         std::cerr << "[!] socket(AF_PACKET) failed: " << strerror(errno) << "\n";
         return false;
     }
 
-    struct ifreq ifr;
-    std::memset(&ifr, 0, sizeof(ifr));
-    std::strncpy(ifr.ifr_name, iface.c_str(), IFNAMSIZ - 1);
+    // the kernel skips this socket when it mirrors the host's own frames; kernels before 4.20
+    // lack the option, so the filter tests the packet type instead
+    m_ignore_outgoing = false;
+    std::vector<struct sock_filter> filter = config.filter;
+    if (config.direction == CaptureDirection::In) {
+        int enable = 1;
+        m_ignore_outgoing =
+            setsockopt(m_fd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &enable, sizeof(enable)) == 0;
+    }
+    if (config.direction != CaptureDirection::Both && !m_ignore_outgoing) {
+        filter = restrict_direction(filter, config.direction == CaptureDirection::Out);
+    }
 
-    // get system interface indx
-    if (ioctl(m_fd, SIOCGIFINDEX, &ifr) < 0) {
-        std::cerr << "[!] ioctl(SIOCGIFINDEX) failed for " << iface << ": " << strerror(errno)
-                  << "\n";
+    // attach before the ring and bind() so rejected frames are never queued to this socket
+    if (m_snaplen > 0 ? !attach_filter(clamp_filter(filter, m_snaplen))
+                      : !filter.empty() && !attach_filter(filter)) {
         ::close(m_fd);
         m_fd = -1;
         return false;
     }
-    m_ifindex = ifr.ifr_ifindex;
+
+    if (any) {
+        m_ifindex = 0;
+    } else {
+        struct ifreq ifr;
+        std::memset(&ifr, 0, sizeof(ifr));
+        std::strncpy(ifr.ifr_name, iface.c_str(), IFNAMSIZ - 1);
+
+        // get system interface indx
+        if (ioctl(m_fd, SIOCGIFINDEX, &ifr) < 0) {
+            std::cerr << "[!] ioctl(SIOCGIFINDEX) failed for " << iface << ": "
+                      << strerror(errno) << "\n";
+            ::close(m_fd);
+            m_fd = -1;
+            return false;
+        }
+        m_ifindex = ifr.ifr_ifindex;
+    }
+
+    if (want_xdp) {
+        if (config.fanout != FanoutMode::None) {
+            std::cerr << "[!] AF_XDP sockets cannot join a fanout group, bind one per queue\n";
+            ::close(m_fd);
+            m_fd = -1;
+            return false;
+        }
+
+        if (m_xdp.open(m_ifindex, config.xdp)) {
+            m_mode = CaptureMode::Xdp;
+            if (!config.filter.empty()) {
+                std::cerr << "[!] Warning: the kernel filter does not apply to AF_XDP capture\n";
+            }
+            m_batch_views.resize(config.batch_size > 1 ? config.batch_size : XDP_DEFAULT_BATCH);
+            if (config.busy_poll_us > 0) {
+                enable_busy_poll(m_xdp.get_fd(), config.busy_poll_us);
+            }
+            if (promisc) {
+                add_promisc_membership();
+            }
+            if (config.autosize.max_bytes > 0 || config.shed.enabled) {
+                std::cerr << "[!] Warning: buffer auto-sizing and load shedding do not apply to "
+                             "AF_XDP capture\n";
+            }
+            m_autosize = BufferAutoSizer();
+            m_shedder = LoadShedder();
+            return true;
+        }
+        std::cerr << "[!] Warning: falling back to "
+                  << (m_mode == CaptureMode::Batch ? "recvmmsg()" : "recv()") << " capture\n";
+    }
+
+    // like the ring, PACKET_VNET_HDR can only be set while there is none
+    m_vnet_hdr_len = 0;
+    if (config.gso != GsoMode::Off && m_mode != CaptureMode::Xdp) {
+        int enable = 1;
+        if (setsockopt(m_fd, SOL_PACKET, PACKET_VNET_HDR, &enable, sizeof(enable)) == 0) {
+            m_vnet_hdr_len = VNET_HDR_LEN;
+            // super-frames are longer than any plain frame, and one cut short cannot be
+            // segmented any more
+            const size_t gso_frame = max_gso_frame_len(m_ifindex);
+            m_frame_buffer_size = m_snaplen > 0 && m_snaplen < gso_frame ? m_snaplen : gso_frame;
+        } else {
+            std::cerr << "[!] Warning: failed to enable PACKET_VNET_HDR, super-frames will have "
+                         "no segment size: "
+                      << strerror(errno) << "\n";
+        }
+    }
+
+    // the ring has to exist before bind() so no frame is queued to the plain receive path
+    if (config.mode == CaptureMode::Ring) {
+        if (setup_ring(config.ring)) {
+            m_mode = CaptureMode::Ring;
+            // a frame has to fit into one block, the kernel cuts the rest
+            if (m_vnet_hdr_len > 0 &&
+                config.ring.block_size < m_frame_buffer_size + RING_FRAME_OVERHEAD) {
+                std::cerr << "[!] Warning: " << config.ring.block_size
+                          << "-byte ring blocks cut super-frames of up to " << m_frame_buffer_size
+                          << " bytes, raise --ring-block-size to segment them\n";
+            }
+        } else {
+            std::cerr << "[!] Warning: falling back to "
+                      << (m_mode == CaptureMode::Batch ? "recvmmsg()" : "recv()") << " capture\n";
+        }
+    }
+
+    // recv() mode keeps a one-frame batch as well, so drain() and next_batch() hand out the same
+    // batch views whichever of recv() and recvmmsg() filled them
+    if (m_mode != CaptureMode::Ring) {
+        const size_t slot_size = m_vnet_hdr_len + m_frame_buffer_size;
+        if (!m_batch_buffer.allocate(static_cast<size_t>(m_batch_size) * slot_size,
+                                     config.huge_pages)) {
+            ::close(m_fd);
+            m_fd = -1;
+            return false;
+        }
+        m_batch_views.resize(m_batch_size);
+        m_iovecs.resize(m_batch_size);
+        m_msgs.resize(m_batch_size);
+        m_addrs.resize(m_batch_size);
+        m_control.resize(static_cast<size_t>(m_batch_size) * CONTROL_BUFFER_SIZE);
+
+        for (uint32_t i = 0; i < m_batch_size; ++i) {
+            m_iovecs[i].iov_base = m_batch_buffer.data() + i * slot_size;
+            m_iovecs[i].iov_len = slot_size;
+        }
+    }
+
+    // ring frames carry tp_sec/tp_nsec and tp_len; the socket paths need control messages
+    if (m_mode != CaptureMode::Ring) {
+        int enable = 1;
+        if (config.kernel_timestamps &&
+            setsockopt(m_fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) < 0) {
+            std::cerr << "[!] Warning: failed to enable SO_TIMESTAMPNS: " << strerror(errno)
+                      << "\n";
+        }
+        if (setsockopt(m_fd, SOL_PACKET, PACKET_AUXDATA, &enable, sizeof(enable)) < 0) {
+            std::cerr << "[!] Warning: failed to enable PACKET_AUXDATA: " << strerror(errno)
+                      << "\n";
+        }
+    }
+
+    if (config.busy_poll_us > 0) {
+        enable_busy_poll(m_fd, config.busy_poll_us);
+    }
 
     struct sockaddr_ll sll;
     std::memset(&sll, 0, sizeof(sll));
     sll.sll_family = AF_PACKET;
     sll.sll_protocol = htons(ETH_P_ALL);
-    sll.sll_ifindex = m_ifindex;
+    sll.sll_ifindex = m_ifindex;  // 0 keeps the socket on every interface
 
     if (bind(m_fd, reinterpret_cast<struct sockaddr*>(&sll), sizeof(sll)) < 0) {
         std::cerr << "[!] bind() failed: " << strerror(errno) << "\n";
+        teardown_ring();
         ::close(m_fd);
         m_fd = -1;
         return false;
     }
 
     if (promisc) {
-        struct packet_mreq mreq;
-        std::memset(&mreq, 0, sizeof(mreq));
-        mreq.mr_ifindex = m_ifindex;
-        mreq.mr_type = PACKET_MR_PROMISC;
+        add_promisc_membership();
+    }
 
-        if (setsockopt(m_fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
-            std::cerr << "[!] Warning: failed to enable promiscuous mode: " << strerror(errno)
-                      << "\n";
-        }
+    if (config.fanout != FanoutMode::None && !join_fanout(config.fanout, config.fanout_group)) {
+        close();
+        return false;
+    }
+
+    start_autosize(config.autosize);
+    m_shedder = LoadShedder(config.shed);
+    return true;
+}
+
+void PacketCapturer::add_promisc_membership() {
+    struct packet_mreq mreq;
+    std::memset(&mreq, 0, sizeof(mreq));
+    mreq.mr_ifindex = m_ifindex;
+    mreq.mr_type = PACKET_MR_PROMISC;
+
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+        std::cerr << "[!] Warning: failed to enable promiscuous mode: " << strerror(errno) << "\n";
+    }
+}
+
+void PacketCapturer::enable_busy_poll(int fd, uint32_t usec) {
+    // the user-space spin works without these, they only let the kernel poll the device queue
+    // from our syscalls instead of waiting for an interrupt
+    int value = static_cast<int>(usec);
+    if (setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &value, sizeof(value)) < 0) {
+        std::cerr << "[!] Warning: failed to set SO_BUSY_POLL: " << strerror(errno) << "\n";
+        return;
+    }
+
+    int prefer = 1;
+    int budget = BUSY_POLL_BUDGET;
+    if (setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer)) < 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL_BUDGET, &budget, sizeof(budget)) < 0) {
+        std::cerr << "[!] Warning: failed to set SO_PREFER_BUSY_POLL: " << strerror(errno)
+                  << "\n";
+    }
+}
+
+bool PacketCapturer::join_fanout(FanoutMode mode, uint16_t group) {
+    int type = PACKET_FANOUT_HASH;
+    switch (mode) {
+        case FanoutMode::Hash:
+            // reassemble fragments first so all pieces of a datagram hash to the same socket
+            type = PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG;
+            break;
+        case FanoutMode::Cpu:
+            type = PACKET_FANOUT_CPU;
+            break;
+        case FanoutMode::LoadBalance:
+            type = PACKET_FANOUT_LB;
+            break;
+        case FanoutMode::Rollover:
+            type = PACKET_FANOUT_ROLLOVER;
+            break;
+        case FanoutMode::None:
+            return true;
+    }
+
+    int arg = group | (type << 16);
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_FANOUT, &arg, sizeof(arg)) < 0) {
+        std::cerr << "[!] setsockopt(PACKET_FANOUT) failed for group " << group << ": "
+                  << strerror(errno) << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool PacketCapturer::attach_filter(const std::vector<struct sock_filter>& program) {
+    struct sock_fprog fprog;
+    fprog.len = static_cast<unsigned short>(program.size());
+    fprog.filter = const_cast<struct sock_filter*>(program.data());
+
+    if (setsockopt(m_fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) < 0) {
+        std::cerr << "[!] setsockopt(SO_ATTACH_FILTER) failed: " << strerror(errno) << "\n";
+        return false;
     }
 
     return true;
 }
 
-void PacketCapturer::run(const std::function<void(const uint8_t*, size_t)>& callback,
-                         std::atomic<bool>& running) {
+bool PacketCapturer::setup_ring(const RingConfig& ring) {
+    const long page_size = sysconf(_SC_PAGESIZE);
+    if (ring.block_count == 0 || ring.block_size < RING_FRAME_SIZE ||
+        ring.block_size % static_cast<uint32_t>(page_size) != 0) {
+        std::cerr << "[!] Invalid ring geometry: block size must be a multiple of " << page_size
+                  << " bytes and the block count non-zero\n";
+        return false;
+    }
+
+    int version = TPACKET_V3;
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        std::cerr << "[!] setsockopt(PACKET_VERSION) failed: " << strerror(errno) << "\n";
+        return false;
+    }
+
+    struct tpacket_req3 req;
+    std::memset(&req, 0, sizeof(req));
+    req.tp_block_size = ring.block_size;
+    req.tp_block_nr = ring.block_count;
+    req.tp_frame_size = RING_FRAME_SIZE;
+    req.tp_frame_nr = (ring.block_size / RING_FRAME_SIZE) * ring.block_count;
+    req.tp_retire_blk_tov = ring.block_timeout_ms;
+    req.tp_feature_req_word = TP_FT_REQ_FILL_RXHASH;
+
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) {
+        std::cerr << "[!] setsockopt(PACKET_RX_RING) failed: " << strerror(errno) << "\n";
+        return false;
+    }
+
+    size_t ring_size = static_cast<size_t>(ring.block_size) * ring.block_count;
+    void* mem = mmap(nullptr, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, m_fd, 0);
+    if (mem == MAP_FAILED) {
+        // MAP_LOCKED fails under a small RLIMIT_MEMLOCK, the ring works without it
+        mem = mmap(nullptr, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    }
+    if (mem == MAP_FAILED) {
+        std::cerr << "[!] mmap() of RX ring failed: " << strerror(errno) << "\n";
+        std::memset(&req, 0, sizeof(req));
+        setsockopt(m_fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req));
+        return false;
+    }
+
+    m_ring = static_cast<uint8_t*>(mem);
+    m_ring_size = ring_size;
+    m_ring_config = ring;
+    m_block_index = 0;
+    return true;
+}
+
+void PacketCapturer::teardown_ring() {
+    if (m_ring) {
+        munmap(m_ring, m_ring_size);
+        m_ring = nullptr;
+        m_ring_size = 0;
+    }
+}
+
+void PacketCapturer::start_autosize(const AutoSizeConfig& config) {
+    m_autosize = BufferAutoSizer();
+    if (config.max_bytes == 0) {
+        return;
+    }
+
+    AutoSizeConfig sizing = config;
+    size_t current = m_ring_size;
+    if (m_mode == CaptureMode::Ring) {
+        if (sizing.min_bytes == 0) {
+            sizing.min_bytes = std::min<size_t>(
+                current, static_cast<size_t>(m_ring_config.block_size) * RING_MIN_BLOCKS);
+        }
+    } else {
+        current = receive_buffer_size();
+    }
+    m_autosize = BufferAutoSizer(sizing, current);
+
+    const uint64_t now = clock_ns(CLOCK_MONOTONIC);
+    m_autosize_drops = 0;
+    m_next_fill_sample = now;
+    m_next_size_decision = now + static_cast<uint64_t>(sizing.interval_ms) * 1000000;
+}
+
+void PacketCapturer::watch_pressure() {
+    const uint64_t now = clock_ns(CLOCK_MONOTONIC);
+    if (now >= m_next_fill_sample) {
+        const double fill = buffer_fill();
+        m_next_fill_sample = now + FILL_SAMPLE_NS;
+        if (m_autosize.enabled()) {
+            m_autosize.sample_fill(fill);
+        }
+        if (m_shedder.enabled()) {
+            const ShedLevel before = m_shedder.level();
+            if (m_shedder.update(fill, wall_clock_ns())) {
+                std::ostringstream line;
+                line << "[*] Load shedding " << m_iface << ": " << shed_level_name(before)
+                     << " -> " << shed_level_name(m_shedder.level()) << " at "
+                     << static_cast<int>(fill * 100) << "% full";
+                const std::vector<ShedInterval>& finished = m_shedder.finished();
+                if (before != ShedLevel::None && !finished.empty()) {
+                    line << ", after " << describe_shed_interval(finished.back());
+                }
+                line << "\n";
+                std::cerr << line.str();
+            }
+        }
+    }
+    if (m_autosize.enabled() && now >= m_next_size_decision) {
+        m_next_size_decision =
+            now + static_cast<uint64_t>(m_autosize.config().interval_ms) * 1000000;
+        tune_buffers();
+    }
+}
+
+size_t PacketCapturer::shed_batch(size_t count) {
+    count = m_shedder.apply(m_batch_views.data(), count);
+    m_shed_cut.store(m_shedder.total_cut(), std::memory_order_relaxed);
+    m_shed_skipped.store(m_shedder.total_skipped(), std::memory_order_relaxed);
+    return count;
+}
+
+std::vector<ShedInterval> PacketCapturer::shed_intervals() const {
+    std::vector<ShedInterval> intervals = m_shedder.finished();
+    if (m_shedder.level() != ShedLevel::None) {
+        intervals.push_back(m_shedder.current());
+        intervals.back().end_ns = wall_clock_ns();
+    }
+    return intervals;
+}
+
+void PacketCapturer::tune_buffers() {
+    const AutoSizeConfig& config = m_autosize.config();
+
+    const uint64_t drops = poll_stats().drops;
+    const uint64_t new_drops = drops - m_autosize_drops;
+    m_autosize_drops = drops;
+
+    const size_t before = m_autosize.current();
+    size_t wanted = 0;
+    const SizeDecision decision = m_autosize.decide(new_drops, wanted);
+    if (decision == SizeDecision::Hold) {
+        return;
+    }
+
+    std::ostringstream reason;
+    if (decision == SizeDecision::Shrink) {
+        reason << "no drops for " << config.quiet_intervals * config.interval_ms / 1000
+               << " s, at most ";
+    } else {
+        reason << new_drops << " drops, ";
+    }
+    reason << static_cast<int>(m_autosize.last_peak_fill() * 100) << "% full";
+
+    std::ostringstream line;
+    line << "[*] Auto-size " << m_iface << ": ";
+    if (m_mode == CaptureMode::Ring) {
+        // the advice is tracked as if taken, so a lasting overload walks it up to the cap once
+        const size_t blocks = wanted / m_ring_config.block_size;
+        if (decision == SizeDecision::AtCap) {
+            line << "ring needs more than the " << config.max_bytes << "-byte cap (" << reason.str()
+                 << ")";
+        } else {
+            line << "ring of " << m_ring_config.block_count << " x " << m_ring_config.block_size
+                 << " bytes " << (decision == SizeDecision::Grow ? "is too small" : "sits idle")
+                 << " (" << reason.str() << "), restart with --ring-blocks " << blocks
+                 << "; a live ring is not resized";
+            m_autosize.applied(wanted);
+        }
+    } else if (decision == SizeDecision::AtCap) {
+        line << "receive buffer stays at " << before << " bytes, the cap (" << reason.str()
+             << ")";
+    } else {
+        const size_t granted = set_receive_buffer(wanted);
+        line << "receive buffer " << before << " -> " << granted << " bytes (" << reason.str()
+             << ")";
+        if (granted > 0) {
+            m_autosize.applied(granted);
+        }
+        if (decision == SizeDecision::Grow && granted > 0 && granted < wanted) {
+            // SO_RCVBUF is capped at net.core.rmem_max, growing further needs the force variant
+            line << ", limited by net.core.rmem_max; SO_RCVBUFFORCE needs CAP_NET_ADMIN";
+            m_autosize.limit(granted);
+        }
+    }
+    line << "\n";
+    std::cerr << line.str();
+}
+
+double PacketCapturer::buffer_fill() const {
+    if (m_mode == CaptureMode::Ring) {
+        uint32_t taken = 0;
+        for (uint32_t i = 0; i < m_ring_config.block_count; ++i) {
+            const auto* block = reinterpret_cast<const struct tpacket_block_desc*>(
+                m_ring + static_cast<size_t>(i) * m_ring_config.block_size);
+            if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_RELAXED) &
+                 TP_STATUS_USER) != 0) {
+                ++taken;
+            }
+        }
+        return static_cast<double>(taken) / m_ring_config.block_count;
+    }
+
+    // the kernel drops a frame once the allocated receive memory reaches the buffer size
+    uint32_t meminfo[SK_MEMINFO_VARS];
+    socklen_t len = sizeof(meminfo);
+    if (getsockopt(m_fd, SOL_SOCKET, SO_MEMINFO, meminfo, &len) < 0 ||
+        meminfo[SK_MEMINFO_RCVBUF] == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(meminfo[SK_MEMINFO_RMEM_ALLOC]) / meminfo[SK_MEMINFO_RCVBUF];
+}
+
+size_t PacketCapturer::receive_buffer_size() const {
+    int value = 0;
+    socklen_t len = sizeof(value);
+    if (m_fd < 0 || getsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, &value, &len) < 0 || value < 0) {
+        return 0;
+    }
+    return static_cast<size_t>(value);
+}
+
+size_t PacketCapturer::set_receive_buffer(size_t bytes) {
+    // the kernel doubles the value set to leave room for its bookkeeping
+    const int value = static_cast<int>(std::min<size_t>(bytes / 2, INT_MAX));
+    if (setsockopt(m_fd, SOL_SOCKET, SO_RCVBUFFORCE, &value, sizeof(value)) < 0 &&
+        setsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, &value, sizeof(value)) < 0) {
+        std::cerr << "[!] Warning: failed to resize the receive buffer: " << strerror(errno)
+                  << "\n";
+    }
+    return receive_buffer_size();
+}
+
+void PacketCapturer::require_open() const {
     if (m_fd < 0) {
         throw std::runtime_error("Socket not opened. Call open() first.");
     }
+}
 
-    const size_t BUFFER_SIZE = 65536;
-    uint8_t buffer[BUFFER_SIZE];
+void PacketCapturer::record_latency(const PacketView* packets, size_t count) {
+    // AF_XDP frames are stamped in user space, so there is no kernel time to measure from
+    if (m_mode == CaptureMode::Xdp) {
+        return;
+    }
 
-    while (running.load()) {
-        ssize_t len = recv(m_fd, buffer, BUFFER_SIZE, 0);
+    const uint64_t now = wall_clock_ns();
+    for (size_t i = 0; i < count; ++i) {
+        if (packets[i].ts_ns > 0 && packets[i].ts_ns <= now) {
+            m_latency.record(now - packets[i].ts_ns);
+        }
+    }
+}
 
-        if (len < 0) {
-            if (errno == EINTR) {
-                continue;
-            }
-            throw std::runtime_error(std::string("recv() failed: ") + strerror(errno));
+bool PacketCapturer::keep_spinning() {
+    if (m_spin_ns == 0) {
+        return false;
+    }
+    const uint64_t now = clock_ns(CLOCK_MONOTONIC);
+    if (m_spin_deadline == 0) {
+        m_spin_deadline = now + m_spin_ns;
+    }
+    return now < m_spin_deadline;
+}
+
+bool PacketCapturer::next_batch(bool wait, const StopSignal* stop, size_t& count) {
+    count = 0;
+    if (m_autosize.enabled() || m_shedder.enabled()) {
+        watch_pressure();
+    }
+
+    // every path only takes what is already there; sleeping is left to wait_readable(), where
+    // the stop signal can interrupt it
+    bool ready = false;
+    switch (m_mode) {
+        case CaptureMode::Recv:
+            count = receive_one(MSG_DONTWAIT);
+            ready = count > 0;
+            break;
+        case CaptureMode::Batch:
+            count = receive_mmsg(MSG_DONTWAIT);
+            ready = count > 0;
+            break;
+        case CaptureMode::Ring:
+            ready = take_ring_block(count);
+            break;
+        case CaptureMode::Xdp:
+            count = take_xdp_frames();
+            ready = count > 0;
+            break;
+    }
+
+    if (ready) {
+        m_spin_deadline = 0;
+        // a batch shed to nothing still goes through release_batch()
+        if (m_shedder.level() != ShedLevel::None) {
+            count = shed_batch(count);
+        }
+        return true;
+    }
+
+    if (wait) {
+        if (keep_spinning()) {
+            cpu_relax();
+        } else {
+            wait_readable(stop);
+        }
+    }
+    return false;
+}
+
+void PacketCapturer::wait_readable(const StopSignal* stop) {
+    // poll() skips the negative fd when there is no stop signal
+    struct pollfd pfds[2];
+    std::memset(pfds, 0, sizeof(pfds));
+    pfds[0].fd = get_fd();
+    pfds[0].events = POLLIN | POLLERR;
+    pfds[1].fd = stop != nullptr ? stop->fd() : -1;
+    pfds[1].events = POLLIN;
+
+    const int timeout = stop != nullptr ? stop->timeout_ms(POLL_TIMEOUT_MS) : POLL_TIMEOUT_MS;
+    if (poll(pfds, 2, timeout) < 0 && errno != EINTR) {
+        throw std::runtime_error(std::string("poll() failed: ") + strerror(errno));
+    }
+}
+
+void PacketCapturer::release_batch() {
+    if (m_mode == CaptureMode::Ring) {
+        auto* block = reinterpret_cast<struct tpacket_block_desc*>(
+            m_ring + static_cast<size_t>(m_block_index) * m_ring_config.block_size);
+        __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        m_block_index = (m_block_index + 1) % m_ring_config.block_count;
+    } else if (m_mode == CaptureMode::Xdp) {
+        // frames go back to the fill ring only after the sink is done with them
+        m_xdp.release();
+    }
+}
+
+CaptureStats PacketCapturer::poll_stats() {
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    m_stats.cut = m_shed_cut.load(std::memory_order_relaxed);
+    m_stats.shed = m_shed_skipped.load(std::memory_order_relaxed);
+    if (m_fd < 0) {
+        return m_stats;
+    }
+
+    if (m_mode == CaptureMode::Xdp) {
+        // AF_XDP counters are cumulative and the kernel does not count accepted frames
+        struct xdp_statistics xdp_stats;
+        if (m_xdp.statistics(xdp_stats)) {
+            m_stats.drops = xdp_stats.rx_dropped + xdp_stats.rx_ring_full;
+            m_stats.packets = delivered() + m_stats.drops;
+        }
+        return m_stats;
+    }
+
+    // tp_packets already includes tp_drops; the v3 layout only adds the freeze count
+    struct tpacket_stats_v3 kernel_stats;
+    std::memset(&kernel_stats, 0, sizeof(kernel_stats));
+    socklen_t optlen = m_mode == CaptureMode::Ring ? sizeof(struct tpacket_stats_v3)
+                                                   : sizeof(struct tpacket_stats);
+    if (getsockopt(m_fd, SOL_PACKET, PACKET_STATISTICS, &kernel_stats, &optlen) == 0) {
+        m_stats.packets += kernel_stats.tp_packets;
+        m_stats.drops += kernel_stats.tp_drops;
+        if (m_mode == CaptureMode::Ring) {
+            m_stats.freezes += kernel_stats.tp_freeze_q_cnt;
+        }
+    }
+    return m_stats;
+}
+
+size_t PacketCapturer::receive_one(int flags) {
+    struct msghdr& msg = m_msgs[0].msg_hdr;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &m_addrs[0];
+    msg.msg_namelen = sizeof(m_addrs[0]);
+    msg.msg_iov = &m_iovecs[0];
+    msg.msg_iovlen = 1;
+    msg.msg_control = m_control.data();
+    msg.msg_controllen = CONTROL_BUFFER_SIZE;
+
+    ssize_t len = recvmsg(m_fd, &msg, flags);
+
+    if (len < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK ||
+            lost_to_vnet_header(errno)) {
+            return 0;
+        }
+        throw std::runtime_error(std::string("recvmsg() failed: ") + strerror(errno));
+    }
+    if (static_cast<size_t>(len) <= m_vnet_hdr_len) {
+        return 0;
+    }
+
+    uint64_t batch_ns = 0;
+    read_message(0, static_cast<size_t>(len), batch_ns, m_batch_views[0]);
+    return 1;
+}
+
+size_t PacketCapturer::receive_mmsg(int flags) {
+    for (uint32_t i = 0; i < m_batch_size; ++i) {
+        std::memset(&m_msgs[i], 0, sizeof(m_msgs[i]));
+        m_msgs[i].msg_hdr.msg_name = &m_addrs[i];
+        m_msgs[i].msg_hdr.msg_namelen = sizeof(m_addrs[i]);
+        m_msgs[i].msg_hdr.msg_iov = &m_iovecs[i];
+        m_msgs[i].msg_hdr.msg_iovlen = 1;
+        m_msgs[i].msg_hdr.msg_control = m_control.data() + i * CONTROL_BUFFER_SIZE;
+        m_msgs[i].msg_hdr.msg_controllen = CONTROL_BUFFER_SIZE;
+    }
+
+    // MSG_WAITFORONE blocks for the first frame only, then takes whatever else is queued
+    int received = recvmmsg(m_fd, m_msgs.data(), m_batch_size, flags | MSG_WAITFORONE, nullptr);
+
+    if (received < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK ||
+            lost_to_vnet_header(errno)) {
+            return 0;
         }
+        throw std::runtime_error(std::string("recvmmsg() failed: ") + strerror(errno));
+    }
 
-        if (len == 0) {
+    size_t count = 0;
+    uint64_t batch_ns = 0;
+    for (int i = 0; i < received; ++i) {
+        if (m_msgs[i].msg_len <= m_vnet_hdr_len) {
             continue;
         }
+        read_message(static_cast<size_t>(i), m_msgs[i].msg_len, batch_ns, m_batch_views[count]);
+        ++count;
+    }
+    return count;
+}
+
+void PacketCapturer::read_message(size_t slot, size_t len, uint64_t& batch_ns,
+                                  PacketView& packet) {
+    // the virtio-net header comes first and counts into the returned length
+    const auto* data = static_cast<const uint8_t*>(m_iovecs[slot].iov_base);
+    packet.data = data + m_vnet_hdr_len;
+    packet.len = len - m_vnet_hdr_len;
+    read_address(m_addrs[slot], packet);
+    read_control(m_msgs[slot].msg_hdr, batch_ns, packet);
+    if (m_vnet_hdr_len > 0) {
+        read_vnet_header(data, packet);
+    } else {
+        packet.gso = GsoInfo{};
+    }
+}
+
+bool PacketCapturer::lost_to_vnet_header(int error) {
+    // the kernel has no virtio-net header for some GSO types, e.g. tunnels, and frees the
+    // frame; a recvmmsg() batch ends early and the error comes with the next call
+    if (error != EINVAL || m_vnet_hdr_len == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    ++m_stats.drops;
+    return true;
+}
+
+bool PacketCapturer::take_ring_block(size_t& count) {
+    auto* block = reinterpret_cast<struct tpacket_block_desc*>(
+        m_ring + static_cast<size_t>(m_block_index) * m_ring_config.block_size);
+
+    // the kernel hands the block over by setting TP_STATUS_USER; pair with its write barrier
+    if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0) {
+        return false;
+    }
+
+    uint32_t num_pkts = block->hdr.bh1.num_pkts;
+    auto* hdr = reinterpret_cast<struct tpacket3_hdr*>(reinterpret_cast<uint8_t*>(block) +
+                                                       block->hdr.bh1.offset_to_first_pkt);
+
+    if (m_batch_views.size() < num_pkts) {
+        m_batch_views.resize(num_pkts);
+    }
+
+    for (uint32_t i = 0; i < num_pkts; ++i) {
+        PacketView& packet = m_batch_views[i];
+        packet.data = reinterpret_cast<const uint8_t*>(hdr) + hdr->tp_mac;
+        packet.len = hdr->tp_snaplen;
+        packet.orig_len = hdr->tp_len;
+        packet.ts_ns = static_cast<uint64_t>(hdr->tp_sec) * 1000000000ULL + hdr->tp_nsec;
+        // the kernel puts the frame's sockaddr_ll right behind the aligned header
+        read_address(*reinterpret_cast<const struct sockaddr_ll*>(
+                         reinterpret_cast<const uint8_t*>(hdr) +
+                         TPACKET_ALIGN(sizeof(struct tpacket3_hdr))),
+                     packet);
+        read_vlan(hdr->tp_status, hdr->hv1.tp_vlan_tci, hdr->hv1.tp_vlan_tpid, packet);
+        if (m_vnet_hdr_len > 0) {
+            // written just in front of the frame, the kernel leaves room for it in tp_mac
+            read_vnet_header(packet.data - m_vnet_hdr_len, packet);
+        }
+        hdr = reinterpret_cast<struct tpacket3_hdr*>(reinterpret_cast<uint8_t*>(hdr) +
+                                                     hdr->tp_next_offset);
+    }
+
+    count = num_pkts;
+    return true;
+}
 
-        callback(buffer, static_cast<size_t>(len));
+size_t PacketCapturer::take_xdp_frames() {
+    size_t count = m_xdp.receive(m_batch_views.data(), m_batch_views.size());
+    if (count == 0) {
+        return 0;
     }
+
+    // XDP runs on the receive path only
+    for (size_t i = 0; i < count; ++i) {
+        m_batch_views[i].ifindex = m_ifindex;
+        m_batch_views[i].direction = PacketDirection::Inbound;
+        m_batch_views[i].type = PacketType::Unknown;
+        m_batch_views[i].vlan_tpid = 0;
+        m_batch_views[i].gso = GsoInfo{};
+    }
+
+    // XDP runs before any socket filter, so the snap length is applied to the views
+    if (m_snaplen > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            m_batch_views[i].orig_len = m_batch_views[i].len;
+            if (m_batch_views[i].len > m_snaplen) {
+                m_batch_views[i].len = m_snaplen;
+            }
+        }
+    }
+    return count;
 }
 
 void PacketCapturer::close() {
@@ -108,7 +1047,17 @@ void PacketCapturer::close() {
             setsockopt(m_fd, SOL_PACKET, PACKET_DROP_MEMBERSHIP, &mreq, sizeof(mreq));
         }
 
+        teardown_ring();
         ::close(m_fd);
         m_fd = -1;
     }
+
+    m_xdp.close();
+
+    m_batch_buffer.release();
+    m_batch_views.clear();
+    m_iovecs.clear();
+    m_msgs.clear();
+    m_addrs.clear();
+    m_control.clear();
 }
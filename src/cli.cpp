@@ -11,6 +11,14 @@
 #include <sstream>
 #include <vector>
 
+#include "affinity.hpp"
+#include "autosize.hpp"
+#include "capture.hpp"
+#include "generator.hpp"
+#include "gso.hpp"
+#include "hugepages.hpp"
+#include "replay.hpp"
+
 static std::vector<std::string> get_available_interfaces() {
     std::vector<std::string> interfaces;
 
@@ -122,7 +130,7 @@ static void setup_interface(CliOptions& opts) {
     for (size_t i = 0; i < interfaces.size(); ++i) {
         std::cout << "  " << (i + 1) << ") " << interfaces[i] << "\n";
     }
-    std::cout << "  0) Enter manually\n\n";
+    std::cout << "  0) Enter manually (\"" << ANY_INTERFACE << "\" for all of them)\n\n";
 
     int choice = get_choice(0, static_cast<int>(interfaces.size()));
 
@@ -149,7 +157,7 @@ static void setup_interface(CliOptions& opts) {
                 continue;
             }
 
-            if (!interface_exists(iface_input)) {
+            if (iface_input != ANY_INTERFACE && !interface_exists(iface_input)) {
                 std::cout << "[!] Interface '" << iface_input << "' not found\n";
                 std::cout << "    Continue anyway? (y/n): ";
                 std::string confirm;
@@ -295,7 +303,9 @@ static void print_final_config(const CliOptions& opts) {
     }
 
     std::cout << "  Display mode:    ";
-    if (opts.show_parsed && opts.show_hex) {
+    if (opts.record_only) {
+        std::cout << "None (record only)\n";
+    } else if (opts.show_parsed && opts.show_hex) {
         std::cout << "Parsed + HEX\n";
     } else if (opts.show_parsed) {
         std::cout << "Parsed only\n";
@@ -306,6 +316,48 @@ static void print_final_config(const CliOptions& opts) {
     std::cout << "  Output file:     "
               << (opts.output_file.empty() ? "(console only)" : opts.output_file) << "\n";
     std::cout << "  Verbose:         " << (opts.verbose ? "YES" : "NO") << "\n";
+    if (!opts.cpus.empty()) {
+        std::cout << "  CPUs:            " << opts.cpus << "\n";
+    }
+    if (opts.stats_interval > 0) {
+        std::cout << "  Status every:    " << opts.stats_interval << " s\n";
+    }
+    if (opts.busy_poll_us > 0) {
+        std::cout << "  Busy poll:       " << opts.busy_poll_us << " us\n";
+    }
+    if (opts.snaplen > 0) {
+        std::cout << "  Snap length:     " << opts.snaplen << " bytes\n";
+    }
+    std::cout << "  Filter:          " << (opts.filter.empty() ? "(none)" : opts.filter) << "\n";
+    if (opts.direction != "both") {
+        std::cout << "  Direction:       " << opts.direction << "\n";
+    }
+    if (opts.gso != "off") {
+        std::cout << "  GSO frames:      " << opts.gso << "\n";
+    }
+    if (opts.timestamps != "kernel") {
+        std::cout << "  Timestamps:      " << opts.timestamps << "\n";
+    }
+    if (opts.shed_bytes > 0) {
+        std::cout << "  Load shedding:   " << opts.shed_bytes << "-byte headers under load\n";
+    }
+    if (!opts.autosize.empty()) {
+        std::cout << "  Buffer cap:      " << opts.autosize << " (auto-sized)\n";
+    }
+    std::cout << "  Capture mode:    ";
+    if (opts.use_xdp) {
+        std::cout << "AF_XDP queue " << opts.xdp_queue << " (" << opts.xdp_bind << ")\n";
+    } else if (opts.use_ring) {
+        std::cout << "TPACKET_V3 ring\n";
+    } else if (opts.batch_size > 1) {
+        std::cout << "recvmmsg() x " << opts.batch_size << "\n";
+    } else {
+        std::cout << "recv()\n";
+    }
+    if (opts.workers > 1) {
+        std::cout << "  Workers:         " << opts.workers << " (fanout " << opts.fanout_mode
+                  << ")\n";
+    }
 
     std::cout << "\n╔═══════════════════════════════════════════╗\n";
     std::cout << "║  Ready to start capture                   ║\n";
@@ -324,10 +376,25 @@ static void interactive_setup(CliOptions& opts) {
     print_final_config(opts);
 }
 
+std::vector<std::string> split_interfaces(const std::string& list) {
+    std::vector<std::string> interfaces;
+    std::stringstream stream(list);
+    std::string iface;
+    while (std::getline(stream, iface, ',')) {
+        size_t start = iface.find_first_not_of(" \t");
+        size_t end = iface.find_last_not_of(" \t");
+        if (start != std::string::npos) {
+            interfaces.push_back(iface.substr(start, end - start + 1));
+        }
+    }
+    return interfaces;
+}
+
 void print_usage(const char* prog_name) {
     std::cout << "Usage: " << prog_name << " [OPTIONS]\n";
     std::cout << "\nOptions:\n";
-    std::cout << "  -I, --interface <name>    Network interface to capture\n";
+    std::cout << "  -I, --interface <name>    Network interface(s) to capture, comma-separated\n";
+    std::cout << "                            or \"any\" for every interface on one socket\n";
     std::cout << "  -p, --promiscuous         Enable promiscuous mode\n";
     std::cout << "  -o, --output <file>       Write packets to file\n";
     std::cout << "  -c, --count <num>         Capture only <num> packets\n";
@@ -335,12 +402,50 @@ void print_usage(const char* prog_name) {
     std::cout << "  -v, --verbose             Verbose output\n";
     std::cout << "  -x, --hex                 Show HEX dump\n";
     std::cout << "  -P, --parsed              Show parsed protocol details\n";
+    std::cout << "      --record              Only write frames to the output file, no parsing\n";
+    std::cout << "  -R, --ring                Capture through a TPACKET_V3 mmap ring\n";
+    std::cout << "      --ring-block-size <b> Ring block size in bytes (default 4194304)\n";
+    std::cout << "      --ring-blocks <num>   Number of ring blocks (default 64)\n";
+    std::cout << "      --ring-timeout <ms>   Block retire timeout in ms (default 64)\n";
+    std::cout << "  -X, --xdp                 Capture through an AF_XDP socket and UMEM\n";
+    std::cout << "      --xdp-queue <num>     RX queue redirected to the socket (default 0)\n";
+    std::cout << "      --xdp-bind <mode>     AF_XDP bind: auto, copy, zerocopy (default auto)\n";
+    std::cout << "      --xdp-generic         Attach the XDP program in generic (skb) mode\n";
+    std::cout << "      --busy-poll <usec>    Spin <usec> on the socket before sleeping\n";
+    std::cout << "      --latency             Report delivery latency percentiles at exit\n";
+    std::cout << "      --timestamps <src>    Frame times: kernel or tsc (default kernel)\n";
+    std::cout << "  -s, --snaplen <bytes>     Keep only the first <bytes> of each frame\n";
+    std::cout << "  -f, --filter <expr>       Drop non-matching frames in the kernel (BPF)\n";
+    std::cout << "      --filter-dump         Print the compiled BPF program and exit\n";
+    std::cout << "      --direction <dir>     Capture in, out or both (default both)\n";
+    std::cout << "      --gso <mode>          Super-frames: off, keep or segment (default off)\n";
+    std::cout << "      --autosize <max>      Grow the buffer on drops up to <max>, e.g. 64m\n";
+    std::cout << "      --shed <bytes>        Under load cut frames to <bytes>, then sample/drop\n";
+    std::cout << "  -B, --batch <num>         Receive up to <num> frames per recvmmsg() call\n";
+    std::cout << "      --cpus <list>         Pin the capture thread or workers, e.g. 2,4-7\n";
+    std::cout << "      --numa <node>         Memory node: auto, off or <n> (default auto)\n";
+    std::cout << "      --hugepages <mode>    Buffer pages: auto, off, 2m or 1g (default auto)\n";
+    std::cout << "      --stats <sec>         Print capture and kernel drop counters every <sec>\n";
+    std::cout << "      --merge-window <ms>   Hold frames <ms> to merge interfaces (default 10)\n";
+    std::cout << "  -G, --generate            Generate synthetic frames, no root needed\n";
+    std::cout << "      --gen-rate <pps>      Generated frames per second (default max)\n";
+    std::cout << "      --gen-flows <num>     Distinct generated flows (default 64)\n";
+    std::cout << "      --gen-mix <spec>      Frame mix, e.g. arp=1,icmp=1,udp=6,tcp=3\n";
+    std::cout << "      --gen-size <spec>     Sizes: imix, <len>, <min>-<max> (default imix)\n";
+    std::cout << "      --replay <file>       Send the frames of a PCAP file out of -I\n";
+    std::cout << "      --replay-speed <x>    Multiple of the original speed, or max (default 1)\n";
+    std::cout << "      --qdisc-bypass        Replay straight to the driver (PACKET_QDISC_BYPASS)\n";
+    std::cout << "  -w, --workers <num>       Capture with <num> PACKET_FANOUT worker threads\n";
+    std::cout << "      --fanout <mode>       Fanout mode: hash, cpu, lb, rollover (default hash)\n";
     std::cout << "  -i, --interactive         Interactive configuration mode\n";
     std::cout << "  -h, --help                Show this help\n";
     std::cout << "\nExamples:\n";
     std::cout << "  " << prog_name << "                    # Interactive mode\n";
     std::cout << "  " << prog_name << " -I eth0 -p -c 100  # Direct mode\n";
     std::cout << "  " << prog_name << " -P -x              # Both parsed and HEX\n";
+    std::cout << "  " << prog_name << " -I eth0,eth1 -o all.pcapng  # Merge two interfaces\n";
+    std::cout << "  " << prog_name << " -I any -o all.pcapng        # Every interface\n";
+    std::cout << "  " << prog_name << " -I eth1 --replay in.pcap --replay-speed max  # Load test\n";
 }
 
 bool parse_cli(int argc, char** argv, CliOptions& opts) {
@@ -393,6 +498,223 @@ bool parse_cli(int argc, char** argv, CliOptions& opts) {
         } else if (arg == "-P" || arg == "--parsed") {
             opts.show_parsed = true;
             explicit_parsed = true;
+        } else if (arg == "--record") {
+            opts.record_only = true;
+        } else if (arg == "-R" || arg == "--ring") {
+            opts.use_ring = true;
+        } else if (arg == "--ring-block-size") {
+            if (i + 1 < argc) {
+                opts.ring_block_size = std::atoi(argv[++i]);
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires an argument\n";
+                return false;
+            }
+        } else if (arg == "--ring-blocks") {
+            if (i + 1 < argc) {
+                opts.ring_block_count = std::atoi(argv[++i]);
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires an argument\n";
+                return false;
+            }
+        } else if (arg == "--ring-timeout") {
+            if (i + 1 < argc) {
+                opts.ring_block_timeout = std::atoi(argv[++i]);
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires an argument\n";
+                return false;
+            }
+        } else if (arg == "-X" || arg == "--xdp") {
+            opts.use_xdp = true;
+        } else if (arg == "--xdp-queue") {
+            if (i + 1 < argc) {
+                opts.xdp_queue = std::atoi(argv[++i]);
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires an argument\n";
+                return false;
+            }
+        } else if (arg == "--xdp-bind") {
+            XdpBindMode mode;
+            if (i + 1 < argc && parse_xdp_bind_mode(argv[i + 1], mode)) {
+                opts.xdp_bind = argv[++i];
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires one of: auto, copy, zerocopy\n";
+                return false;
+            }
+        } else if (arg == "--xdp-generic") {
+            opts.xdp_generic = true;
+        } else if (arg == "--busy-poll") {
+            if (i + 1 < argc) {
+                opts.busy_poll_us = std::atoi(argv[++i]);
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires an argument\n";
+                return false;
+            }
+        } else if (arg == "--latency") {
+            opts.report_latency = true;
+        } else if (arg == "--timestamps") {
+            const std::string source = i + 1 < argc ? argv[i + 1] : "";
+            if (source == "kernel" || source == "tsc") {
+                opts.timestamps = argv[++i];
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires kernel or tsc\n";
+                return false;
+            }
+        } else if (arg == "-s" || arg == "--snaplen") {
+            if (i + 1 < argc) {
+                opts.snaplen = std::atoi(argv[++i]);
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires an argument\n";
+                return false;
+            }
+        } else if (arg == "-f" || arg == "--filter") {
+            if (i + 1 < argc) {
+                opts.filter = argv[++i];
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires an argument\n";
+                return false;
+            }
+        } else if (arg == "--filter-dump") {
+            opts.filter_dump = true;
+        } else if (arg == "--direction") {
+            CaptureDirection direction;
+            if (i + 1 < argc && parse_capture_direction(argv[i + 1], direction)) {
+                opts.direction = argv[++i];
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires in, out or both\n";
+                return false;
+            }
+        } else if (arg == "--gso") {
+            GsoMode mode;
+            if (i + 1 < argc && parse_gso_mode(argv[i + 1], mode)) {
+                opts.gso = argv[++i];
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires off, keep or segment\n";
+                return false;
+            }
+        } else if (arg == "--shed") {
+            if (i + 1 < argc) {
+                opts.shed_bytes = std::atoi(argv[++i]);
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires an argument\n";
+                return false;
+            }
+        } else if (arg == "--autosize") {
+            size_t bytes = 0;
+            if (i + 1 < argc && parse_byte_size(argv[i + 1], bytes) && bytes > 0) {
+                opts.autosize = argv[++i];
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires a size like 65536, 512k or 64m\n";
+                return false;
+            }
+        } else if (arg == "-B" || arg == "--batch") {
+            if (i + 1 < argc) {
+                opts.batch_size = std::atoi(argv[++i]);
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires an argument\n";
+                return false;
+            }
+        } else if (arg == "--cpus") {
+            std::vector<int> cpus;
+            if (i + 1 < argc && parse_cpu_list(argv[i + 1], cpus)) {
+                opts.cpus = argv[++i];
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires a CPU list like 0,2-5\n";
+                return false;
+            }
+        } else if (arg == "--numa") {
+            int node;
+            if (i + 1 < argc && parse_numa_node(argv[i + 1], node)) {
+                opts.numa = argv[++i];
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires auto, off or a node number\n";
+                return false;
+            }
+        } else if (arg == "--hugepages") {
+            HugePageMode mode;
+            if (i + 1 < argc && parse_huge_page_mode(argv[i + 1], mode)) {
+                opts.hugepages = argv[++i];
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires auto, off, 2m or 1g\n";
+                return false;
+            }
+        } else if (arg == "--stats") {
+            if (i + 1 < argc) {
+                opts.stats_interval = std::atoi(argv[++i]);
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires an argument\n";
+                return false;
+            }
+        } else if (arg == "--merge-window") {
+            if (i + 1 < argc) {
+                opts.merge_window_ms = std::atoi(argv[++i]);
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires an argument\n";
+                return false;
+            }
+        } else if (arg == "-G" || arg == "--generate") {
+            opts.generate = true;
+        } else if (arg == "--gen-rate") {
+            if (i + 1 < argc) {
+                opts.gen_rate = std::atoi(argv[++i]);
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires an argument\n";
+                return false;
+            }
+        } else if (arg == "--gen-flows") {
+            if (i + 1 < argc) {
+                opts.gen_flows = std::atoi(argv[++i]);
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires an argument\n";
+                return false;
+            }
+        } else if (arg == "--gen-mix") {
+            GeneratorConfig config;
+            if (i + 1 < argc && parse_traffic_mix(argv[i + 1], config)) {
+                opts.gen_mix = argv[++i];
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires a mix like arp=1,udp=6,tcp=3\n";
+                return false;
+            }
+        } else if (arg == "--gen-size") {
+            GeneratorConfig config;
+            if (i + 1 < argc && parse_frame_sizes(argv[i + 1], config)) {
+                opts.gen_size = argv[++i];
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires imix, <len> or <min>-<max>\n";
+                return false;
+            }
+        } else if (arg == "--replay") {
+            if (i + 1 < argc) {
+                opts.replay_file = argv[++i];
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires an argument\n";
+                return false;
+            }
+        } else if (arg == "--replay-speed") {
+            double speed;
+            if (i + 1 < argc && parse_replay_speed(argv[i + 1], speed)) {
+                opts.replay_speed = argv[++i];
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires a positive multiplier or max\n";
+                return false;
+            }
+        } else if (arg == "--qdisc-bypass") {
+            opts.qdisc_bypass = true;
+        } else if (arg == "-w" || arg == "--workers") {
+            if (i + 1 < argc) {
+                opts.workers = std::atoi(argv[++i]);
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires an argument\n";
+                return false;
+            }
+        } else if (arg == "--fanout") {
+            FanoutMode mode;
+            if (i + 1 < argc && parse_fanout_mode(argv[i + 1], mode)) {
+                opts.fanout_mode = argv[++i];
+            } else {
+                std::cerr << "[!] Error: " << arg << " requires one of: hash, cpu, lb, rollover\n";
+                return false;
+            }
         } else {
             std::cerr << "[!] Error: unknown option " << arg << "\n";
             return false;
@@ -1,6 +1,5 @@
 #include "export/pcap.hpp"
 
-#include <chrono>
 #include <cstring>
 #include <iostream>
 
@@ -8,7 +7,8 @@ PcapWriter::~PcapWriter() {
     close();
 }
 
-bool PcapWriter::open(const std::string& filename) {
+bool PcapWriter::open(const std::string& filename, PcapTimestampPrecision precision,
+                      uint32_t snaplen) {
     std::string output_filename = filename;
 
     if (output_filename.size() < 5 ||
@@ -22,45 +22,80 @@ bool PcapWriter::open(const std::string& filename) {
         return false;
     }
 
+    m_precision = precision;
+    m_snaplen = snaplen > 0 ? snaplen : DEFAULT_SNAPLEN;
     write_global_header();
     return true;
 }
 
 void PcapWriter::write_global_header() {
     PcapGlobalHeader header;
-    header.magic_number = 0xa1b2c3d4;
+    header.magic_number = m_precision == PcapTimestampPrecision::Nano ? 0xa1b23c4d : 0xa1b2c3d4;
     header.version_major = 2;
     header.version_minor = 4;
     header.thiszone = 0;
     header.sigfigs = 0;
-    header.snaplen = 65535;
+    header.snaplen = m_snaplen;
     header.network = 1;
 
     m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
 }
 
-void PcapWriter::write_packet_header(uint32_t len) {
-    auto now = std::chrono::system_clock::now();
-    auto duration = now.time_since_epoch();
-    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(duration);
-    auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration - seconds);
+void PcapWriter::append_record(const PacketView& packet) {
+    const size_t len = export_len(packet);
+    const size_t incl_len = len < m_snaplen ? len : m_snaplen;
+    const uint64_t ts_ns = packet.ts_ns;
+
+    uint64_t fraction = ts_ns % 1000000000ULL;
+    if (m_precision == PcapTimestampPrecision::Micro) {
+        fraction /= 1000;
+    }
 
     PcapPacketHeader header;
-    header.ts_sec = static_cast<uint32_t>(seconds.count());
-    header.ts_usec = static_cast<uint32_t>(microseconds.count());
-    header.incl_len = len;
-    header.orig_len = len;
+    header.ts_sec = static_cast<uint32_t>(ts_ns / 1000000000ULL);
+    header.ts_usec = static_cast<uint32_t>(fraction);
+    header.incl_len = static_cast<uint32_t>(incl_len);
+    header.orig_len = static_cast<uint32_t>(export_wire_len(packet));
 
-    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&header);
+    m_run.insert(m_run.end(), bytes, bytes + sizeof(header));
+    emit_frame(packet, incl_len, [this](const uint8_t* data, size_t n) {
+        m_run.insert(m_run.end(), data, data + n);
+    });
 }
 
-void PcapWriter::write_packet(const uint8_t* data, size_t len) {
+void PcapWriter::write_run() {
+    // a write larger than the stream buffer goes to the file directly, without another copy
+    m_file.write(reinterpret_cast<const char*>(m_run.data()),
+                 static_cast<std::streamsize>(m_run.size()));
+    m_run.clear();
+}
+
+void PcapWriter::write_packet(const uint8_t* data, size_t len, uint64_t ts_ns,
+                              size_t orig_len) {
     if (!m_file.is_open()) {
         return;
     }
 
-    write_packet_header(static_cast<uint32_t>(len));
-    m_file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(len));
+    PacketView packet;
+    packet.data = data;
+    packet.len = len;
+    packet.ts_ns = ts_ns;
+    packet.orig_len = orig_len;
+    append_record(packet);
+    write_run();
+    m_file.flush();
+}
+
+void PcapWriter::write_packets(const PacketView* packets, size_t count) {
+    if (!m_file.is_open() || count == 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        export_frames(packets[i], [this](const PacketView& packet) { append_record(packet); });
+    }
+    write_run();
     m_file.flush();
 }
 
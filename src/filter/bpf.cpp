@@ -0,0 +1,671 @@
+#include "filter/bpf.hpp"
+
+#include <arpa/inet.h>
+#include <linux/if_packet.h>
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+namespace {
+
+constexpr uint32_t ETHERTYPE_IP = 0x0800;
+constexpr uint32_t ETHERTYPE_ARP = 0x0806;
+constexpr uint32_t ETHERTYPE_IPV6 = 0x86dd;
+constexpr uint32_t ETHERTYPE_VLAN = 0x8100;
+constexpr uint32_t ETHERTYPE_QINQ = 0x88a8;
+
+// frame offsets, assuming an untagged Ethernet header
+constexpr uint32_t OFF_ETHERTYPE = 12;
+constexpr uint32_t OFF_VLAN_TCI = 14;
+constexpr uint32_t OFF_IP_HEADER = 14;
+constexpr uint32_t OFF_IP_FRAG = 20;
+constexpr uint32_t OFF_IP_PROTO = 23;
+constexpr uint32_t OFF_IP_SRC = 26;
+constexpr uint32_t OFF_IP_DST = 30;
+constexpr uint32_t OFF_ARP_SPA = 28;
+constexpr uint32_t OFF_ARP_TPA = 38;
+// relative to the end of the IPv4 header, which ldx msh leaves in X
+constexpr uint32_t OFF_L4_SRC_PORT = 14;
+constexpr uint32_t OFF_L4_DST_PORT = 16;
+
+// One load-and-compare step. The comparison jumps to the node's true or false target.
+struct Test {
+    uint16_t size = BPF_H;    // BPF_B, BPF_H or BPF_W
+    uint32_t offset = 0;      // absolute, or relative to X when indexed
+    bool indexed = false;     // X = IPv4 header length, load [x + offset]
+    uint32_t mask = 0;        // and-ed into A before the comparison when non-zero
+    uint16_t jump = BPF_JEQ;  // BPF_JEQ or BPF_JSET
+    uint32_t k = 0;
+};
+
+struct Node {
+    enum class Kind { And, Or, Not, Test };
+
+    Kind kind = Kind::Test;
+    std::unique_ptr<Node> lhs;
+    std::unique_ptr<Node> rhs;
+    Test test;
+};
+
+using NodePtr = std::unique_ptr<Node>;
+
+NodePtr make_test(const Test& test) {
+    auto node = std::make_unique<Node>();
+    node->test = test;
+    return node;
+}
+
+NodePtr make_binary(Node::Kind kind, NodePtr lhs, NodePtr rhs) {
+    auto node = std::make_unique<Node>();
+    node->kind = kind;
+    node->lhs = std::move(lhs);
+    node->rhs = std::move(rhs);
+    return node;
+}
+
+NodePtr make_and(NodePtr lhs, NodePtr rhs) {
+    return make_binary(Node::Kind::And, std::move(lhs), std::move(rhs));
+}
+
+NodePtr make_or(NodePtr lhs, NodePtr rhs) {
+    return make_binary(Node::Kind::Or, std::move(lhs), std::move(rhs));
+}
+
+NodePtr make_not(NodePtr operand) {
+    auto node = std::make_unique<Node>();
+    node->kind = Node::Kind::Not;
+    node->lhs = std::move(operand);
+    return node;
+}
+
+NodePtr load_equals(uint16_t size, uint32_t offset, uint32_t k, uint32_t mask = 0) {
+    Test test;
+    test.size = size;
+    test.offset = offset;
+    test.mask = mask;
+    test.k = k;
+    return make_test(test);
+}
+
+NodePtr ethertype_is(uint32_t type) {
+    return load_equals(BPF_H, OFF_ETHERTYPE, type);
+}
+
+NodePtr ipv4_protocol_is(uint32_t protocol) {
+    return make_and(ethertype_is(ETHERTYPE_IP), load_equals(BPF_B, OFF_IP_PROTO, protocol));
+}
+
+NodePtr vlan_ethertype() {
+    return make_or(ethertype_is(ETHERTYPE_VLAN), ethertype_is(ETHERTYPE_QINQ));
+}
+
+NodePtr vlan_offloaded() {
+    return load_equals(BPF_W, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_VLAN_TAG_PRESENT), 1);
+}
+
+enum class Direction { Any, Src, Dst };
+
+// IPv4 source/destination and ARP sender/target address, optionally masked
+NodePtr address_matches(Direction dir, uint32_t addr, uint32_t mask) {
+    auto pick = [dir, addr, mask](uint32_t src_off, uint32_t dst_off) {
+        if (dir == Direction::Src) {
+            return load_equals(BPF_W, src_off, addr, mask);
+        }
+        if (dir == Direction::Dst) {
+            return load_equals(BPF_W, dst_off, addr, mask);
+        }
+        return make_or(load_equals(BPF_W, src_off, addr, mask),
+                       load_equals(BPF_W, dst_off, addr, mask));
+    };
+
+    return make_or(make_and(ethertype_is(ETHERTYPE_IP), pick(OFF_IP_SRC, OFF_IP_DST)),
+                   make_and(ethertype_is(ETHERTYPE_ARP), pick(OFF_ARP_SPA, OFF_ARP_TPA)));
+}
+
+NodePtr port_matches(Direction dir, uint32_t port) {
+    auto port_at = [port](uint32_t offset) {
+        Test test;
+        test.size = BPF_H;
+        test.offset = offset;
+        test.indexed = true;
+        test.k = port;
+        return make_test(test);
+    };
+
+    NodePtr ports;
+    if (dir == Direction::Src) {
+        ports = port_at(OFF_L4_SRC_PORT);
+    } else if (dir == Direction::Dst) {
+        ports = port_at(OFF_L4_DST_PORT);
+    } else {
+        ports = make_or(port_at(OFF_L4_SRC_PORT), port_at(OFF_L4_DST_PORT));
+    }
+
+    // only the first fragment carries the transport header
+    Test fragment;
+    fragment.size = BPF_H;
+    fragment.offset = OFF_IP_FRAG;
+    fragment.jump = BPF_JSET;
+    fragment.k = 0x1fff;
+
+    NodePtr transport = make_or(load_equals(BPF_B, OFF_IP_PROTO, IPPROTO_TCP),
+                                load_equals(BPF_B, OFF_IP_PROTO, IPPROTO_UDP));
+    return make_and(ethertype_is(ETHERTYPE_IP),
+                    make_and(std::move(transport),
+                             make_and(make_not(make_test(fragment)), std::move(ports))));
+}
+
+bool parse_number(const std::string& text, uint32_t max, uint32_t& value) {
+    if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0]))) {
+        return false;
+    }
+    char* end = nullptr;
+    unsigned long parsed = std::strtoul(text.c_str(), &end, 0);
+    if (*end != '\0' || parsed > max) {
+        return false;
+    }
+    value = static_cast<uint32_t>(parsed);
+    return true;
+}
+
+bool parse_ipv4(const std::string& text, uint32_t& addr) {
+    struct in_addr in;
+    if (inet_pton(AF_INET, text.c_str(), &in) != 1) {
+        return false;
+    }
+    addr = ntohl(in.s_addr);
+    return true;
+}
+
+bool is_word_char(char c) {
+    return !std::isspace(static_cast<unsigned char>(c)) && c != '(' && c != ')' && c != '!' &&
+           c != '&' && c != '|';
+}
+
+std::vector<std::string> tokenize(const std::string& expression) {
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < expression.size()) {
+        char c = expression[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else if (c == '(' || c == ')' || c == '!') {
+            tokens.emplace_back(1, c);
+            ++i;
+        } else if ((c == '&' || c == '|') && i + 1 < expression.size() &&
+                   expression[i + 1] == c) {
+            tokens.push_back(expression.substr(i, 2));
+            i += 2;
+        } else {
+            size_t start = i;
+            while (i < expression.size() && is_word_char(expression[i])) {
+                ++i;
+            }
+            if (i == start) {
+                tokens.emplace_back(1, c);
+                ++i;
+            } else {
+                tokens.push_back(expression.substr(start, i - start));
+            }
+        }
+    }
+    return tokens;
+}
+
+class Parser {
+public:
+    explicit Parser(std::vector<std::string> tokens) : m_tokens(std::move(tokens)) {}
+
+    NodePtr parse(std::string& error) {
+        NodePtr root = parse_or();
+        if (root && m_pos < m_tokens.size()) {
+            fail("unexpected '" + m_tokens[m_pos] + "'");
+            root.reset();
+        }
+        if (!root) {
+            error = m_error;
+        }
+        return root;
+    }
+
+private:
+    std::vector<std::string> m_tokens;
+    size_t m_pos = 0;
+    std::string m_error;
+
+    NodePtr fail(const std::string& message) {
+        if (m_error.empty()) {
+            m_error = message;
+        }
+        return nullptr;
+    }
+
+    bool at_end() const {
+        return m_pos >= m_tokens.size();
+    }
+
+    bool accept(const char* token) {
+        if (!at_end() && m_tokens[m_pos] == token) {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    // next token as an operand; empty when the expression ended
+    std::string operand() {
+        return at_end() ? std::string() : m_tokens[m_pos++];
+    }
+
+    NodePtr parse_or() {
+        NodePtr lhs = parse_and();
+        while (lhs && (accept("or") || accept("||"))) {
+            NodePtr rhs = parse_and();
+            if (!rhs) {
+                return nullptr;
+            }
+            lhs = make_or(std::move(lhs), std::move(rhs));
+        }
+        return lhs;
+    }
+
+    // juxtaposed primitives ("tcp port 80") are an implicit "and", as in tcpdump
+    bool implicit_and() const {
+        if (at_end()) {
+            return false;
+        }
+        const std::string& next = m_tokens[m_pos];
+        return next != "or" && next != "||" && next != ")";
+    }
+
+    NodePtr parse_and() {
+        NodePtr lhs = parse_factor();
+        while (lhs && (accept("and") || accept("&&") || implicit_and())) {
+            NodePtr rhs = parse_factor();
+            if (!rhs) {
+                return nullptr;
+            }
+            lhs = make_and(std::move(lhs), std::move(rhs));
+        }
+        return lhs;
+    }
+
+    NodePtr parse_factor() {
+        if (accept("not") || accept("!")) {
+            NodePtr operand = parse_factor();
+            return operand ? make_not(std::move(operand)) : nullptr;
+        }
+        if (accept("(")) {
+            NodePtr inner = parse_or();
+            if (inner && !accept(")")) {
+                return fail("missing ')'");
+            }
+            return inner;
+        }
+        if (at_end()) {
+            return fail("unexpected end of expression");
+        }
+        return parse_primitive();
+    }
+
+    NodePtr parse_primitive() {
+        Direction dir = Direction::Any;
+        if (accept("src")) {
+            dir = Direction::Src;
+        } else if (accept("dst")) {
+            dir = Direction::Dst;
+        }
+
+        std::string keyword = operand();
+        if (dir != Direction::Any && keyword != "host" && keyword != "net" && keyword != "port") {
+            return fail("'src' and 'dst' must be followed by host, net or port");
+        }
+
+        if (keyword == "ip") {
+            return ethertype_is(ETHERTYPE_IP);
+        }
+        if (keyword == "ip6") {
+            return ethertype_is(ETHERTYPE_IPV6);
+        }
+        if (keyword == "arp") {
+            return ethertype_is(ETHERTYPE_ARP);
+        }
+        if (keyword == "icmp") {
+            return ipv4_protocol_is(IPPROTO_ICMP);
+        }
+        if (keyword == "tcp") {
+            return ipv4_protocol_is(IPPROTO_TCP);
+        }
+        if (keyword == "udp") {
+            return ipv4_protocol_is(IPPROTO_UDP);
+        }
+        if (keyword == "ethertype") {
+            return parse_ethertype();
+        }
+        if (keyword == "vlan") {
+            return parse_vlan();
+        }
+        if (keyword == "proto") {
+            return parse_proto();
+        }
+        if (keyword == "host") {
+            std::string text = operand();
+            uint32_t addr = 0;
+            if (!parse_ipv4(text, addr)) {
+                return fail("invalid IPv4 address '" + text + "'");
+            }
+            return address_matches(dir, addr, 0);
+        }
+        if (keyword == "net") {
+            return parse_net(dir);
+        }
+        if (keyword == "port") {
+            std::string text = operand();
+            uint32_t port = 0;
+            if (!parse_number(text, 65535, port)) {
+                return fail("invalid port '" + text + "'");
+            }
+            return port_matches(dir, port);
+        }
+
+        return fail("unknown primitive '" + keyword + "'");
+    }
+
+    NodePtr parse_ethertype() {
+        std::string text = operand();
+        if (text == "ip") {
+            return ethertype_is(ETHERTYPE_IP);
+        }
+        if (text == "ip6") {
+            return ethertype_is(ETHERTYPE_IPV6);
+        }
+        if (text == "arp") {
+            return ethertype_is(ETHERTYPE_ARP);
+        }
+        if (text == "vlan") {
+            return ethertype_is(ETHERTYPE_VLAN);
+        }
+        uint32_t type = 0;
+        if (!parse_number(text, 0xffff, type)) {
+            return fail("invalid ethertype '" + text + "'");
+        }
+        return ethertype_is(type);
+    }
+
+    NodePtr parse_vlan() {
+        uint32_t vid = 0;
+        if (at_end() || !parse_number(m_tokens[m_pos], 4095, vid)) {
+            return make_or(vlan_offloaded(), vlan_ethertype());
+        }
+        ++m_pos;
+
+        NodePtr offloaded = make_and(
+            vlan_offloaded(),
+            load_equals(BPF_W, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_VLAN_TAG), vid, 0x0fff));
+        NodePtr in_frame =
+            make_and(vlan_ethertype(), load_equals(BPF_H, OFF_VLAN_TCI, vid, 0x0fff));
+        return make_or(std::move(offloaded), std::move(in_frame));
+    }
+
+    NodePtr parse_proto() {
+        std::string text = operand();
+        uint32_t protocol = 0;
+        if (text == "icmp") {
+            protocol = IPPROTO_ICMP;
+        } else if (text == "tcp") {
+            protocol = IPPROTO_TCP;
+        } else if (text == "udp") {
+            protocol = IPPROTO_UDP;
+        } else if (!parse_number(text, 255, protocol)) {
+            return fail("invalid protocol '" + text + "'");
+        }
+        return ipv4_protocol_is(protocol);
+    }
+
+    NodePtr parse_net(Direction dir) {
+        std::string text = operand();
+        size_t slash = text.find('/');
+        uint32_t addr = 0;
+        uint32_t prefix = 32;
+        if ((slash != std::string::npos && !parse_number(text.substr(slash + 1), 32, prefix)) ||
+            !parse_ipv4(text.substr(0, slash), addr)) {
+            return fail("invalid network '" + text + "'");
+        }
+        uint32_t mask = prefix == 0 ? 0 : ~0U << (32 - prefix);
+        if (mask == 0) {
+            // 0.0.0.0/0: any IPv4 or ARP frame
+            return make_or(ethertype_is(ETHERTYPE_IP), ethertype_is(ETHERTYPE_ARP));
+        }
+        return address_matches(dir, addr & mask, mask == ~0U ? 0 : mask);
+    }
+};
+
+class CodeGen {
+public:
+    CodeGen() : m_accept(new_label()), m_reject(new_label()) {}
+
+    void generate(const Node& root) {
+        gen(root, m_accept, m_reject);
+    }
+
+    bool finish(uint32_t accept_len, std::vector<struct sock_filter>& program,
+                std::string& error) {
+        place(m_accept);
+        emit(BPF_STMT(BPF_RET | BPF_K, accept_len));
+        place(m_reject);
+        emit(BPF_STMT(BPF_RET | BPF_K, 0));
+
+        if (m_code.size() > BPF_MAXINSNS) {
+            error = "filter expression too complex";
+            return false;
+        }
+
+        program.clear();
+        program.reserve(m_code.size());
+        for (size_t i = 0; i < m_code.size(); ++i) {
+            struct sock_filter insn = m_code[i].insn;
+            if (m_code[i].jt >= 0) {
+                int jt = m_labels[m_code[i].jt] - static_cast<int>(i) - 1;
+                int jf = m_labels[m_code[i].jf] - static_cast<int>(i) - 1;
+                // conditional jumps only reach 255 instructions ahead
+                if (jt > 255 || jf > 255) {
+                    error = "filter expression too complex";
+                    return false;
+                }
+                insn.jt = static_cast<uint8_t>(jt);
+                insn.jf = static_cast<uint8_t>(jf);
+            }
+            program.push_back(insn);
+        }
+        return true;
+    }
+
+private:
+    struct Insn {
+        struct sock_filter insn;
+        int jt = -1;  // label ids, -1 for non-jumps
+        int jf = -1;
+    };
+
+    std::vector<Insn> m_code;
+    std::vector<int> m_labels;
+    int m_accept;
+    int m_reject;
+
+    int new_label() {
+        m_labels.push_back(-1);
+        return static_cast<int>(m_labels.size()) - 1;
+    }
+
+    void place(int label) {
+        m_labels[label] = static_cast<int>(m_code.size());
+    }
+
+    void emit(const struct sock_filter& insn, int jt = -1, int jf = -1) {
+        m_code.push_back(Insn{insn, jt, jf});
+    }
+
+    void gen(const Node& node, int on_true, int on_false) {
+        switch (node.kind) {
+            case Node::Kind::And: {
+                int next = new_label();
+                gen(*node.lhs, next, on_false);
+                place(next);
+                gen(*node.rhs, on_true, on_false);
+                break;
+            }
+            case Node::Kind::Or: {
+                int next = new_label();
+                gen(*node.lhs, on_true, next);
+                place(next);
+                gen(*node.rhs, on_true, on_false);
+                break;
+            }
+            case Node::Kind::Not:
+                gen(*node.lhs, on_false, on_true);
+                break;
+            case Node::Kind::Test:
+                gen_test(node.test, on_true, on_false);
+                break;
+        }
+    }
+
+    void gen_test(const Test& test, int on_true, int on_false) {
+        if (test.indexed) {
+            emit(BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, OFF_IP_HEADER));
+            emit(BPF_STMT(BPF_LD | test.size | BPF_IND, test.offset));
+        } else {
+            emit(BPF_STMT(BPF_LD | test.size | BPF_ABS, test.offset));
+        }
+        if (test.mask != 0) {
+            emit(BPF_STMT(BPF_ALU | BPF_AND | BPF_K, test.mask));
+        }
+        emit(BPF_JUMP(BPF_JMP | test.jump | BPF_K, test.k, 0, 0), on_true, on_false);
+    }
+};
+
+const char* size_suffix(uint16_t code) {
+    switch (BPF_SIZE(code)) {
+        case BPF_H:
+            return "h";
+        case BPF_B:
+            return "b";
+        default:
+            return "";
+    }
+}
+
+std::string ancillary_name(uint32_t k) {
+    switch (static_cast<int32_t>(k) - SKF_AD_OFF) {
+        case SKF_AD_VLAN_TAG:
+            return "vlan_tci";
+        case SKF_AD_VLAN_TAG_PRESENT:
+            return "vlan_avail";
+        case SKF_AD_PKTTYPE:
+            return "pkttype";
+        default:
+            return "#ancillary+" + std::to_string(k - static_cast<uint32_t>(SKF_AD_OFF));
+    }
+}
+
+}  // namespace
+
+bool compile_filter(const std::string& expression, std::vector<struct sock_filter>& program,
+                    std::string& error, uint32_t accept_len) {
+    std::vector<std::string> tokens = tokenize(expression);
+
+    CodeGen codegen;
+    if (!tokens.empty()) {
+        NodePtr root = Parser(std::move(tokens)).parse(error);
+        if (!root) {
+            return false;
+        }
+        codegen.generate(*root);
+    }
+
+    return codegen.finish(accept_len, program, error);
+}
+
+std::vector<struct sock_filter> restrict_direction(const std::vector<struct sock_filter>& program,
+                                                   bool outbound) {
+    // jump offsets are relative, so the original program runs unchanged behind the prefix;
+    // wanted frames skip the reject, the others fall into it
+    const uint8_t jt = outbound ? 1 : 0;
+    const uint8_t jf = outbound ? 0 : 1;
+    std::vector<struct sock_filter> restricted = {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_PKTTYPE)),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, jt, jf),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+    if (program.empty()) {
+        restricted.push_back(BPF_STMT(BPF_RET | BPF_K, DEFAULT_SNAPLEN));
+    } else {
+        restricted.insert(restricted.end(), program.begin(), program.end());
+    }
+    return restricted;
+}
+
+std::string dump_filter(const std::vector<struct sock_filter>& program) {
+    std::string out;
+    char line[96];
+
+    for (size_t i = 0; i < program.size(); ++i) {
+        const struct sock_filter& insn = program[i];
+        std::string op;
+        std::string arg;
+        bool conditional = false;
+
+        switch (BPF_CLASS(insn.code)) {
+            case BPF_LD:
+                op = std::string("ld") + size_suffix(insn.code);
+                if (BPF_MODE(insn.code) == BPF_IND) {
+                    arg = "[x + " + std::to_string(insn.k) + "]";
+                } else if (BPF_MODE(insn.code) == BPF_ABS &&
+                           insn.k >= static_cast<uint32_t>(SKF_AD_OFF)) {
+                    arg = ancillary_name(insn.k);
+                } else {
+                    arg = "[" + std::to_string(insn.k) + "]";
+                }
+                break;
+            case BPF_LDX:
+                op = "ldxb";
+                arg = "4*([" + std::to_string(insn.k) + "]&0xf)";
+                break;
+            case BPF_ALU:
+                std::snprintf(line, sizeof(line), "#0x%x", insn.k);
+                op = BPF_OP(insn.code) == BPF_AND ? "and" : "alu";
+                arg = line;
+                break;
+            case BPF_JMP:
+                std::snprintf(line, sizeof(line), "#0x%x", insn.k);
+                conditional = BPF_OP(insn.code) != BPF_JA;
+                op = BPF_OP(insn.code) == BPF_JSET  ? "jset"
+                     : BPF_OP(insn.code) == BPF_JEQ ? "jeq"
+                     : BPF_OP(insn.code) == BPF_JA  ? "ja"
+                                                    : "jmp";
+                arg = BPF_OP(insn.code) == BPF_JA ? std::to_string(i + 1 + insn.k) : line;
+                break;
+            case BPF_RET:
+                op = "ret";
+                arg = "#" + std::to_string(insn.k);
+                break;
+            default:
+                std::snprintf(line, sizeof(line), "code=0x%x k=0x%x", insn.code, insn.k);
+                op = "unknown";
+                arg = line;
+                break;
+        }
+
+        if (conditional) {
+            std::snprintf(line, sizeof(line), "(%03zu) %-8s %-16s jt %zu\tjf %zu\n", i, op.c_str(),
+                          arg.c_str(), i + 1 + insn.jt, i + 1 + insn.jf);
+        } else {
+            std::snprintf(line, sizeof(line), "(%03zu) %-8s %s\n", i, op.c_str(), arg.c_str());
+        }
+        out += line;
+    }
+
+    return out;
+}
@@ -0,0 +1,314 @@
+#include "generator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "tsc_clock.hpp"
+
+namespace {
+
+constexpr uint32_t MIN_FRAME = 60;
+constexpr uint32_t MAX_FRAME = 9014;
+constexpr size_t ETH_HEADER = 14;
+constexpr size_t IPV4_HEADER = 20;
+
+// longest single sleep of the pacing loop
+constexpr auto MAX_PACING_SLEEP = std::chrono::milliseconds(10);
+
+enum class FrameKind { Arp, Icmp, Udp, Tcp };
+
+bool parse_number(const std::string& text, uint32_t& value) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos ||
+        text.size() > 9) {
+        return false;
+    }
+    value = static_cast<uint32_t>(std::stoul(text));
+    return true;
+}
+
+void put16(uint8_t* p, uint16_t value) {
+    p[0] = static_cast<uint8_t>(value >> 8);
+    p[1] = static_cast<uint8_t>(value);
+}
+
+uint16_t ipv4_checksum(const uint8_t* header) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < IPV4_HEADER; i += 2) {
+        sum += static_cast<uint32_t>(header[i] << 8 | header[i + 1]);
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return static_cast<uint16_t>(~sum);
+}
+
+void write_ethernet(uint8_t* frame, uint32_t flow, uint16_t ethertype) {
+    const uint8_t dst[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    const uint8_t src[6] = {0x02, 0x00, 0x00, static_cast<uint8_t>(flow >> 16),
+                            static_cast<uint8_t>(flow >> 8), static_cast<uint8_t>(flow)};
+    std::memcpy(frame, dst, 6);
+    std::memcpy(frame + 6, src, 6);
+    put16(frame + 12, ethertype);
+}
+
+// 10.x.y.1 asking for 10.x.y.2, x.y taken from the flow number
+size_t write_arp(uint8_t* frame, uint32_t flow) {
+    write_ethernet(frame, flow, 0x0806);
+    std::memset(frame, 0xff, 6);
+
+    uint8_t* arp = frame + ETH_HEADER;
+    const uint8_t fixed[8] = {0x00, 0x01, 0x08, 0x00, 0x06, 0x04, 0x00, 0x01};
+    std::memcpy(arp, fixed, sizeof(fixed));
+    std::memcpy(arp + 8, frame + 6, 6);
+    const uint8_t sender[4] = {10, static_cast<uint8_t>(flow >> 8), static_cast<uint8_t>(flow), 1};
+    std::memcpy(arp + 14, sender, 4);
+    std::memset(arp + 18, 0, 6);
+    std::memcpy(arp + 24, sender, 4);
+    arp[27] = 2;
+    return ETH_HEADER + 28;
+}
+
+// 10.x.y.1:<1024+flow> -> 192.168.x.y:80 (TCP) or :53 (UDP); payload bytes are left zero
+size_t write_ipv4(uint8_t* frame, uint32_t flow, FrameKind kind, size_t len, uint16_t id) {
+    write_ethernet(frame, flow, 0x0800);
+
+    uint8_t* ip = frame + ETH_HEADER;
+    const uint8_t protocol = kind == FrameKind::Tcp ? 6 : kind == FrameKind::Udp ? 17 : 1;
+    ip[0] = 0x45;
+    ip[1] = 0;
+    put16(ip + 2, static_cast<uint16_t>(len - ETH_HEADER));
+    put16(ip + 4, id);
+    put16(ip + 6, 0x4000);  // don't fragment
+    ip[8] = 64;
+    ip[9] = protocol;
+    put16(ip + 10, 0);
+    const uint8_t src[4] = {10, static_cast<uint8_t>(flow >> 8), static_cast<uint8_t>(flow), 1};
+    const uint8_t dst[4] = {192, 168, static_cast<uint8_t>(flow >> 8), static_cast<uint8_t>(flow)};
+    std::memcpy(ip + 12, src, 4);
+    std::memcpy(ip + 16, dst, 4);
+    put16(ip + 10, ipv4_checksum(ip));
+
+    uint8_t* l4 = ip + IPV4_HEADER;
+    const auto sport = static_cast<uint16_t>(1024 + flow % 64512);
+    if (kind == FrameKind::Tcp) {
+        put16(l4, sport);
+        put16(l4 + 2, 80);
+        put16(l4 + 6, id);  // low half of the sequence number
+        l4[12] = 0x50;      // data offset 5
+        l4[13] = 0x18;      // PSH|ACK
+        put16(l4 + 14, 0xffff);
+    } else if (kind == FrameKind::Udp) {
+        put16(l4, sport);
+        put16(l4 + 2, 53);
+        put16(l4 + 4, static_cast<uint16_t>(len - ETH_HEADER - IPV4_HEADER));
+    } else {
+        l4[0] = 8;  // echo request
+        put16(l4 + 4, static_cast<uint16_t>(flow));
+        put16(l4 + 6, id);
+    }
+    return len;
+}
+
+}  // namespace
+
+bool parse_traffic_mix(const std::string& spec, GeneratorConfig& config) {
+    uint32_t weights[4] = {0, 0, 0, 0};
+    const char* names[4] = {"arp", "icmp", "udp", "tcp"};
+
+    std::stringstream stream(spec);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            return false;
+        }
+        const std::string name = item.substr(0, eq);
+        auto it = std::find(std::begin(names), std::end(names), name);
+        if (it == std::end(names) || !parse_number(item.substr(eq + 1), weights[it - names])) {
+            return false;
+        }
+    }
+
+    if (weights[0] + weights[1] + weights[2] + weights[3] == 0) {
+        return false;
+    }
+    config.arp_weight = weights[0];
+    config.icmp_weight = weights[1];
+    config.udp_weight = weights[2];
+    config.tcp_weight = weights[3];
+    return true;
+}
+
+bool parse_frame_sizes(const std::string& spec, GeneratorConfig& config) {
+    if (spec == "imix") {
+        config.sizes = FrameSizes::Imix;
+        return true;
+    }
+
+    uint32_t min_size = 0;
+    uint32_t max_size = 0;
+    size_t dash = spec.find('-');
+    if (dash == std::string::npos) {
+        if (!parse_number(spec, min_size)) {
+            return false;
+        }
+        max_size = min_size;
+    } else if (!parse_number(spec.substr(0, dash), min_size) ||
+               !parse_number(spec.substr(dash + 1), max_size)) {
+        return false;
+    }
+
+    if (min_size < MIN_FRAME || max_size > MAX_FRAME || min_size > max_size) {
+        return false;
+    }
+    config.sizes = min_size == max_size ? FrameSizes::Fixed : FrameSizes::Uniform;
+    config.min_size = min_size;
+    config.max_size = max_size;
+    return true;
+}
+
+bool TrafficGenerator::open(const GeneratorConfig& config) {
+    const uint64_t total_weight = static_cast<uint64_t>(config.arp_weight) + config.icmp_weight +
+                                  config.udp_weight + config.tcp_weight;
+    if (total_weight == 0 || config.flow_count == 0 || config.batch_size == 0 ||
+        config.pool_size == 0) {
+        std::cerr << "[!] Generator needs a frame mix, flows, a batch size and a pool\n";
+        return false;
+    }
+    if (config.sizes != FrameSizes::Imix &&
+        (config.min_size < MIN_FRAME || config.max_size > MAX_FRAME ||
+         config.min_size > config.max_size)) {
+        std::cerr << "[!] Generator frame sizes must be between " << MIN_FRAME << " and "
+                  << MAX_FRAME << " bytes\n";
+        return false;
+    }
+
+    m_config = config;
+    m_generated = 0;
+    m_elapsed_ns = 0;
+    if (!build_pool()) {
+        return false;
+    }
+    m_batch.resize(m_config.batch_size);
+    return true;
+}
+
+bool TrafficGenerator::build_pool() {
+    std::mt19937_64 rng(m_config.seed);
+    std::discrete_distribution<int> kinds({static_cast<double>(m_config.arp_weight),
+                                           static_cast<double>(m_config.icmp_weight),
+                                           static_cast<double>(m_config.udp_weight),
+                                           static_cast<double>(m_config.tcp_weight)});
+    std::discrete_distribution<int> imix({7.0, 4.0, 1.0});
+    std::uniform_int_distribution<uint32_t> uniform(m_config.min_size, m_config.max_size);
+    std::uniform_int_distribution<uint32_t> flows(0, m_config.flow_count - 1);
+
+    const uint32_t imix_sizes[3] = {60, 590, 1514};
+
+    // frames are drawn first so the pool is allocated once, at its final size
+    std::vector<FrameKind> frame_kinds;
+    std::vector<uint32_t> frame_flows;
+    std::vector<size_t> offsets;
+    std::vector<size_t> lengths;
+    size_t pool_bytes = 0;
+    for (uint32_t i = 0; i < m_config.pool_size; ++i) {
+        const auto kind = static_cast<FrameKind>(kinds(rng));
+        const uint32_t flow = flows(rng);
+
+        size_t len = 42;
+        if (kind != FrameKind::Arp) {
+            switch (m_config.sizes) {
+                case FrameSizes::Imix:
+                    len = imix_sizes[imix(rng)];
+                    break;
+                case FrameSizes::Fixed:
+                    len = m_config.min_size;
+                    break;
+                case FrameSizes::Uniform:
+                    len = uniform(rng);
+                    break;
+            }
+        }
+
+        frame_kinds.push_back(kind);
+        frame_flows.push_back(flow);
+        offsets.push_back(pool_bytes);
+        lengths.push_back(len);
+        pool_bytes += len;
+    }
+
+    if (!m_pool.allocate(pool_bytes, m_config.huge_pages)) {
+        return false;
+    }
+
+    m_frames.resize(m_config.pool_size);
+    for (uint32_t i = 0; i < m_config.pool_size; ++i) {
+        uint8_t* frame = m_pool.data() + offsets[i];
+        if (frame_kinds[i] == FrameKind::Arp) {
+            write_arp(frame, frame_flows[i]);
+        } else {
+            write_ipv4(frame, frame_flows[i], frame_kinds[i], lengths[i],
+                       static_cast<uint16_t>(i));
+        }
+
+        PacketView& view = m_frames[i];
+        view.data = m_pool.data() + offsets[i];
+        view.len = lengths[i];
+        if (m_config.snaplen > 0 && view.len > m_config.snaplen) {
+            view.orig_len = view.len;
+            view.len = m_config.snaplen;
+        }
+    }
+    return true;
+}
+
+void TrafficGenerator::begin_run() {
+    if (m_frames.empty()) {
+        throw std::runtime_error("Generator not opened. Call open() first.");
+    }
+
+    m_start = std::chrono::steady_clock::now();
+    m_sent = 0;
+    m_next = 0;
+}
+
+void TrafficGenerator::end_run() {
+    m_elapsed_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             std::chrono::steady_clock::now() - m_start)
+                                             .count());
+}
+
+size_t TrafficGenerator::next_batch() {
+    size_t count = m_config.batch_size;
+
+    if (m_config.rate_pps > 0) {
+        // frames due by now, but never more than one batch at a time
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now() - m_start)
+                                 .count();
+        const uint64_t due = static_cast<uint64_t>(elapsed) / 1000 * m_config.rate_pps / 1000000;
+        if (due <= m_sent) {
+            // in slices, so a stop is noticed promptly even at a few frames per second
+            const uint64_t next_ns = (m_sent + 1) * 1000000000ULL / m_config.rate_pps;
+            std::this_thread::sleep_until(
+                std::min(m_start + std::chrono::nanoseconds(next_ns),
+                         std::chrono::steady_clock::now() + MAX_PACING_SLEEP));
+            return 0;
+        }
+        count = static_cast<size_t>(std::min<uint64_t>(due - m_sent, count));
+    }
+
+    const uint64_t ts = wall_clock_ns();
+    for (size_t i = 0; i < count; ++i) {
+        m_batch[i] = m_frames[m_next];
+        m_batch[i].ts_ns = ts;
+        m_next = m_next + 1 == m_frames.size() ? 0 : m_next + 1;
+    }
+    return count;
+}
@@ -0,0 +1,312 @@
+#include "gso.hpp"
+
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+// the IPv4 limits of BIG TCP, kernel 6.3; older headers do not name them
+#ifndef IFLA_GSO_IPV4_MAX_SIZE
+#define IFLA_GSO_IPV4_MAX_SIZE 63
+#endif
+#ifndef IFLA_GRO_IPV4_MAX_SIZE
+#define IFLA_GRO_IPV4_MAX_SIZE 64
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// the layout and constants of <linux/virtio_net.h>, which does not compile as C++
+struct VnetHeader {
+    uint8_t flags;
+    uint8_t gso_type;
+    uint16_t hdr_len;
+    uint16_t gso_size;
+    uint16_t csum_start;
+    uint16_t csum_offset;
+};
+static_assert(sizeof(VnetHeader) == VNET_HDR_LEN, "virtio-net header layout");
+
+constexpr uint8_t VIRTIO_NET_HDR_F_NEEDS_CSUM = 1;
+constexpr uint8_t VIRTIO_NET_HDR_GSO_NONE = 0;
+constexpr uint8_t VIRTIO_NET_HDR_GSO_TCPV4 = 1;
+constexpr uint8_t VIRTIO_NET_HDR_GSO_UDP = 3;
+constexpr uint8_t VIRTIO_NET_HDR_GSO_TCPV6 = 4;
+constexpr uint8_t VIRTIO_NET_HDR_GSO_UDP_L4 = 5;
+constexpr uint8_t VIRTIO_NET_HDR_GSO_ECN = 0x80;
+
+constexpr size_t ETH_HEADER = 14;
+constexpr size_t VLAN_TAGS = 2 * 4;
+constexpr size_t MAX_IP_PACKET = 65535;
+// GSO_MAX_SIZE with BIG TCP; a larger answer is not trusted
+constexpr uint32_t MAX_GSO_SIZE = 524280;
+constexpr size_t IPV6_HEADER = 40;
+constexpr size_t UDP_HEADER = 8;
+constexpr uint8_t PROTO_TCP = 6;
+constexpr uint8_t PROTO_UDP = 17;
+
+constexpr uint8_t TCP_FIN = 0x01;
+constexpr uint8_t TCP_PSH = 0x08;
+constexpr uint8_t TCP_CWR = 0x80;
+
+uint16_t get16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] << 8 | p[1]);
+}
+
+void put16(uint8_t* p, uint16_t value) {
+    p[0] = static_cast<uint8_t>(value >> 8);
+    p[1] = static_cast<uint8_t>(value);
+}
+
+uint32_t get32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 |
+           static_cast<uint32_t>(p[2]) << 8 | p[3];
+}
+
+void put32(uint8_t* p, uint32_t value) {
+    put16(p, static_cast<uint16_t>(value >> 16));
+    put16(p + 2, static_cast<uint16_t>(value));
+}
+
+// ones' complement sum of 16-bit words, an odd trailing byte padded with zero
+uint32_t sum_words(const uint8_t* data, size_t len, uint32_t sum) {
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        sum += get16(data + i);
+    }
+    if (len & 1) {
+        sum += static_cast<uint32_t>(data[len - 1]) << 8;
+    }
+    return sum;
+}
+
+uint16_t fold(uint32_t sum) {
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return static_cast<uint16_t>(~sum);
+}
+
+}  // namespace
+
+bool parse_gso_mode(const std::string& name, GsoMode& mode) {
+    if (name == "off") {
+        mode = GsoMode::Off;
+    } else if (name == "keep") {
+        mode = GsoMode::Keep;
+    } else if (name == "segment") {
+        mode = GsoMode::Segment;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* gso_type_name(uint8_t type) {
+    switch (type & ~VIRTIO_NET_HDR_GSO_ECN) {
+        case VIRTIO_NET_HDR_GSO_NONE:
+            return "none";
+        case VIRTIO_NET_HDR_GSO_TCPV4:
+            return "tcpv4";
+        case VIRTIO_NET_HDR_GSO_UDP:
+            return "ufo";
+        case VIRTIO_NET_HDR_GSO_TCPV6:
+            return "tcpv6";
+        case VIRTIO_NET_HDR_GSO_UDP_L4:
+            return "udp";
+    }
+    return "unknown";
+}
+
+size_t max_gso_frame_len(int ifindex) {
+    uint32_t limit = MAX_IP_PACKET;
+    if (ifindex <= 0) {
+        return ETH_HEADER + VLAN_TAGS + limit;
+    }
+
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) {
+        return ETH_HEADER + VLAN_TAGS + limit;
+    }
+    struct timeval timeout = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    struct {
+        struct nlmsghdr header;
+        struct ifinfomsg info;
+    } request;
+    std::memset(&request, 0, sizeof(request));
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    request.header.nlmsg_type = RTM_GETLINK;
+    request.header.nlmsg_flags = NLM_F_REQUEST;
+    request.info.ifi_family = AF_UNSPEC;
+    request.info.ifi_index = ifindex;
+
+    // one RTM_NEWLINK reply; statistics and VF details make it a few KB at most
+    std::vector<uint8_t> reply(1 << 16);
+    ssize_t len = -1;
+    if (send(fd, &request, request.header.nlmsg_len, 0) >= 0) {
+        len = recv(fd, reply.data(), reply.size(), 0);
+    }
+    close(fd);
+
+    const auto* header = reinterpret_cast<const struct nlmsghdr*>(reply.data());
+    if (len < 0 || !NLMSG_OK(header, static_cast<size_t>(len)) ||
+        header->nlmsg_type != RTM_NEWLINK) {
+        return ETH_HEADER + VLAN_TAGS + limit;
+    }
+
+    const auto* info = static_cast<const struct ifinfomsg*>(NLMSG_DATA(header));
+    int attr_len = static_cast<int>(IFLA_PAYLOAD(header));
+    for (const struct rtattr* attr = IFLA_RTA(info); RTA_OK(attr, attr_len);
+         attr = RTA_NEXT(attr, attr_len)) {
+        const bool size_limit =
+            attr->rta_type == IFLA_GRO_MAX_SIZE || attr->rta_type == IFLA_GSO_MAX_SIZE ||
+            attr->rta_type == IFLA_GRO_IPV4_MAX_SIZE || attr->rta_type == IFLA_GSO_IPV4_MAX_SIZE;
+        if (size_limit && RTA_PAYLOAD(attr) >= sizeof(uint32_t)) {
+            uint32_t size = 0;
+            std::memcpy(&size, RTA_DATA(attr), sizeof(size));
+            limit = std::max(limit, std::min(size, MAX_GSO_SIZE));
+        }
+    }
+    return ETH_HEADER + VLAN_TAGS + limit;
+}
+
+void read_vnet_header(const uint8_t* header, PacketView& packet) {
+    // the packet socket writes the fields in host byte order
+    VnetHeader vnet;
+    std::memcpy(&vnet, header, sizeof(vnet));
+
+    packet.gso.type = vnet.gso_type;
+    packet.gso.needs_csum = (vnet.flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) != 0;
+    packet.gso.size = vnet.gso_type != VIRTIO_NET_HDR_GSO_NONE ? vnet.gso_size : 0;
+    packet.gso.csum_start = vnet.csum_start;
+    packet.gso.csum_offset = vnet.csum_offset;
+}
+
+bool GsoSegmenter::begin(const PacketView& packet) {
+    m_index = 0;
+    m_offset = 0;
+    if (!packet.is_gso() || packet.orig_len > packet.len) {
+        return false;
+    }
+
+    const uint8_t* data = packet.data;
+    const size_t len = packet.len;
+    if (len < ETH_HEADER) {
+        return false;
+    }
+
+    uint8_t protocol = 0;
+    m_l3 = ETH_HEADER;
+    const uint16_t ethertype = get16(data + 12);
+    if (ethertype == 0x0800) {
+        if (len < m_l3 + 20 || (data[m_l3] >> 4) != 4) {
+            return false;
+        }
+        m_ipv6 = false;
+        m_l4 = m_l3 + static_cast<size_t>(data[m_l3] & 0x0f) * 4;
+        protocol = data[m_l3 + 9];
+    } else if (ethertype == 0x86DD) {
+        if (len < m_l3 + IPV6_HEADER || (data[m_l3] >> 4) != 6) {
+            return false;
+        }
+        m_ipv6 = true;
+        m_l4 = m_l3 + IPV6_HEADER;
+        protocol = data[m_l3 + 6];  // extension headers are not followed
+    } else {
+        return false;
+    }
+
+    const uint8_t type = packet.gso.type & ~VIRTIO_NET_HDR_GSO_ECN;
+    if (type == VIRTIO_NET_HDR_GSO_TCPV4 || type == VIRTIO_NET_HDR_GSO_TCPV6) {
+        if (protocol != PROTO_TCP || m_ipv6 != (type == VIRTIO_NET_HDR_GSO_TCPV6) ||
+            len < m_l4 + 20) {
+            return false;
+        }
+        m_tcp = true;
+        m_header = m_l4 + static_cast<size_t>(data[m_l4 + 12] >> 4) * 4;
+    } else if (type == VIRTIO_NET_HDR_GSO_UDP_L4) {
+        if (protocol != PROTO_UDP) {
+            return false;
+        }
+        m_tcp = false;
+        m_header = m_l4 + UDP_HEADER;
+    } else {
+        // UFO frames are IP fragments rather than segments
+        return false;
+    }
+
+    if (m_header >= len) {
+        return false;
+    }
+
+    m_packet = packet;
+    m_buffer.resize(m_header + packet.gso.size);
+    return true;
+}
+
+bool GsoSegmenter::next(PacketView& segment) {
+    const size_t payload = m_packet.len - m_header;
+    if (m_offset >= payload) {
+        return false;
+    }
+
+    const size_t share = std::min<size_t>(m_packet.gso.size, payload - m_offset);
+    const bool first = m_index == 0;
+    const bool last = m_offset + share == payload;
+    uint8_t* frame = m_buffer.data();
+    std::memcpy(frame, m_packet.data, m_header);
+    std::memcpy(frame + m_header, m_packet.data + m_header + m_offset, share);
+
+    uint8_t* ip = frame + m_l3;
+    uint8_t* l4 = frame + m_l4;
+    const size_t l4_len = m_header - m_l4 + share;
+    if (m_ipv6) {
+        put16(ip + 4, static_cast<uint16_t>(l4_len));
+    } else {
+        put16(ip + 2, static_cast<uint16_t>(m_l4 - m_l3 + l4_len));
+        put16(ip + 4, static_cast<uint16_t>(get16(ip + 4) + m_index));
+        put16(ip + 10, 0);
+        put16(ip + 10, fold(sum_words(ip, m_l4 - m_l3, 0)));
+    }
+
+    size_t csum_field = 0;
+    if (m_tcp) {
+        put32(l4 + 4, get32(l4 + 4) + static_cast<uint32_t>(m_offset));
+        if (!last) {
+            l4[13] &= static_cast<uint8_t>(~(TCP_FIN | TCP_PSH));
+        }
+        if (!first) {
+            l4[13] &= static_cast<uint8_t>(~TCP_CWR);
+        }
+        csum_field = 16;
+    } else {
+        put16(l4 + 4, static_cast<uint16_t>(l4_len));
+        csum_field = 6;
+    }
+
+    // pseudo-header: addresses, protocol and L4 length
+    put16(l4 + csum_field, 0);
+    uint32_t sum = m_ipv6 ? sum_words(ip + 8, 32, 0) : sum_words(ip + 12, 8, 0);
+    sum += m_tcp ? PROTO_TCP : PROTO_UDP;
+    sum += static_cast<uint32_t>(l4_len >> 16) + static_cast<uint32_t>(l4_len & 0xffff);
+    uint16_t checksum = fold(sum_words(l4, l4_len, sum));
+    if (!m_tcp && checksum == 0) {
+        checksum = 0xffff;
+    }
+    put16(l4 + csum_field, checksum);
+
+    segment = m_packet;
+    segment.data = frame;
+    segment.len = m_header + share;
+    segment.orig_len = 0;
+    segment.gso = GsoInfo{};
+
+    m_offset += share;
+    ++m_index;
+    return true;
+}
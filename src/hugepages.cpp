@@ -0,0 +1,132 @@
+#include "hugepages.hpp"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+namespace {
+
+constexpr size_t HUGE_2M = 2UL << 20;
+constexpr size_t HUGE_1G = 1UL << 30;
+
+}  // namespace
+
+bool parse_huge_page_mode(const std::string& name, HugePageMode& mode) {
+    if (name == "auto") {
+        mode = HugePageMode::Auto;
+    } else if (name == "off") {
+        mode = HugePageMode::Off;
+    } else if (name == "2m") {
+        mode = HugePageMode::Huge2M;
+    } else if (name == "1g") {
+        mode = HugePageMode::Huge1G;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* page_backing_name(PageBacking backing) {
+    switch (backing) {
+        case PageBacking::None:
+            return "no pages";
+        case PageBacking::Normal:
+            return "normal pages";
+        case PageBacking::Transparent:
+            return "normal pages advised for THP";
+        case PageBacking::Huge2M:
+            return "2 MB hugepages";
+        case PageBacking::Huge1G:
+            return "1 GB hugepages";
+    }
+    return "unknown pages";
+}
+
+HugeBuffer::~HugeBuffer() {
+    release();
+}
+
+bool HugeBuffer::map(size_t size, int flags, size_t page_size, PageBacking backing) {
+    const size_t mapped = (size + page_size - 1) / page_size * page_size;
+    // hugetlb mappings reserve their pages here and fail with ENOMEM when the pool is short
+    void* mem = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags,
+                     -1, 0);
+    if (mem == MAP_FAILED) {
+        return false;
+    }
+
+    m_data = static_cast<uint8_t*>(mem);
+    m_size = size;
+    m_mapped = mapped;
+    m_backing = backing;
+    return true;
+}
+
+bool HugeBuffer::allocate(size_t size, HugePageMode mode) {
+    release();
+    if (size == 0) {
+        return false;
+    }
+
+    if (mode == HugePageMode::Huge1G || (mode == HugePageMode::Auto && size >= HUGE_1G)) {
+        if (map(size, MAP_HUGETLB | MAP_HUGE_1GB | MAP_POPULATE, HUGE_1G, PageBacking::Huge1G)) {
+            return true;
+        }
+    }
+
+    if (mode == HugePageMode::Huge2M || mode == HugePageMode::Huge1G ||
+        (mode == HugePageMode::Auto && size >= HUGE_2M)) {
+        if (map(size, MAP_HUGETLB | MAP_HUGE_2MB | MAP_POPULATE, HUGE_2M, PageBacking::Huge2M)) {
+            if (mode == HugePageMode::Huge1G) {
+                std::cerr << "[!] Warning: no free 1 GB hugepages for " << size
+                          << " bytes, using 2 MB hugepages\n";
+            }
+            return true;
+        }
+    }
+
+    const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    if (!map(size, 0, page_size, PageBacking::Normal)) {
+        std::cerr << "[!] mmap() of " << size << " byte buffer failed: " << strerror(errno)
+                  << "\n";
+        return false;
+    }
+
+    // the advice has to come before the first touch for the fault path to use huge pages
+    if (mode != HugePageMode::Off && size >= HUGE_2M &&
+        madvise(m_data, m_mapped, MADV_HUGEPAGE) == 0) {
+        m_backing = PageBacking::Transparent;
+    }
+    if (mode == HugePageMode::Huge2M || mode == HugePageMode::Huge1G) {
+        std::cerr << "[!] Warning: no free hugepages for " << size << " bytes, using "
+                  << page_backing_name(m_backing) << "\n";
+    }
+
+    for (size_t offset = 0; offset < m_mapped; offset += page_size) {
+        m_data[offset] = 0;
+    }
+    return true;
+}
+
+void HugeBuffer::release() {
+    if (m_data) {
+        munmap(m_data, m_mapped);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = 0;
+    m_backing = PageBacking::None;
+}
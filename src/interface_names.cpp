@@ -0,0 +1,20 @@
+#include "interface_names.hpp"
+
+#include <net/if.h>
+
+void InterfaceNames::set(int ifindex, const std::string& name) {
+    m_names[ifindex] = name;
+}
+
+const std::string& InterfaceNames::lookup(int ifindex) {
+    auto it = m_names.find(ifindex);
+    if (it != m_names.end()) {
+        return it->second;
+    }
+
+    char name[IF_NAMESIZE] = {};
+    if (ifindex <= 0 || if_indextoname(static_cast<unsigned>(ifindex), name) == nullptr) {
+        name[0] = '\0';
+    }
+    return m_names.emplace(ifindex, name).first->second;
+}
@@ -0,0 +1,91 @@
+#include "latency.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+std::string format_ns(uint64_t ns) {
+    std::ostringstream out;
+    if (ns < 1000) {
+        out << ns << " ns";
+    } else if (ns < 1000000) {
+        out << std::fixed << std::setprecision(1) << static_cast<double>(ns) / 1e3 << " us";
+    } else {
+        out << std::fixed << std::setprecision(1) << static_cast<double>(ns) / 1e6 << " ms";
+    }
+    return out.str();
+}
+
+}  // namespace
+
+size_t LatencyHistogram::bucket_index(uint64_t ns) {
+    if (ns < SUB_BUCKETS) {
+        return static_cast<size_t>(ns);
+    }
+
+    // values in [2^msb, 2^(msb+1)) share one row of 16 buckets
+    const unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(ns));
+    const unsigned shift = msb - 4;
+    return (msb - 3) * SUB_BUCKETS + static_cast<size_t>((ns >> shift) - SUB_BUCKETS);
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+
+    const unsigned msb = static_cast<unsigned>(index / SUB_BUCKETS) + 3;
+    const uint64_t sub = index % SUB_BUCKETS;
+    const unsigned shift = msb - 4;
+    return ((SUB_BUCKETS + sub) << shift) + ((1ULL << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    ++m_buckets[bucket_index(ns)];
+    ++m_count;
+    m_max = std::max(m_max, ns);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        m_buckets[i] += other.m_buckets[i];
+    }
+    m_count += other.m_count;
+    m_max = std::max(m_max, other.m_max);
+}
+
+void LatencyHistogram::reset() {
+    m_buckets.fill(0);
+    m_count = 0;
+    m_max = 0;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    if (m_count == 0) {
+        return 0;
+    }
+
+    p = std::min(std::max(p, 0.0), 100.0);
+    auto rank = static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(m_count)));
+    rank = std::max<uint64_t>(rank, 1);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += m_buckets[i];
+        if (seen >= rank) {
+            return std::min(bucket_upper_bound(i), m_max);
+        }
+    }
+    return m_max;
+}
+
+std::string LatencyHistogram::summary() const {
+    std::ostringstream out;
+    out << "p50 " << format_ns(percentile(50)) << ", p90 " << format_ns(percentile(90))
+        << ", p99 " << format_ns(percentile(99)) << ", p99.9 " << format_ns(percentile(99.9))
+        << ", max " << format_ns(m_max) << " (" << m_count << " samples)";
+    return out.str();
+}
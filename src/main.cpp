@@ -1,134 +1,755 @@
+#include <unistd.h>
+
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <csignal>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 
+#include "affinity.hpp"
+#include "autosize.hpp"
 #include "capture.hpp"
 #include "cli.hpp"
 #include "export/pcap.hpp"
-#include "parsers/frame.hpp"
-#include "parsers/protocol_parser.hpp"
+#include "export/pcapng.hpp"
+#include "filter/bpf.hpp"
+#include "generator.hpp"
+#include "gso.hpp"
+#include "hugepages.hpp"
+#include "multi_capture.hpp"
+#include "pipeline.hpp"
+#include "replay.hpp"
+#include "status.hpp"
+#include "stop_signal.hpp"
+#include "tsc_clock.hpp"
 
-std::atomic<bool> g_running{true};
-std::atomic<int> g_packet_counter{0};
-PcapWriter* g_pcap_writer = nullptr;
+// ends every capture loop: signals, packet limits, worker errors and the -t deadline
+StopSignal g_stop;
 
 void signal_handler(int signum) {
     if (signum == SIGINT || signum == SIGTERM) {
         std::cerr << "\n[*] Caught signal " << signum << ", shutting down...\n";
-        g_running.store(false);
+        g_stop.request();
     }
 }
 
-void print_hex_dump(const uint8_t* data, size_t len) {
-    std::cout << "\n  HEX Dump:\n";
-    for (size_t i = 0; i < len; ++i) {
-        if (i % 16 == 0) {
-            if (i > 0)
-                std::cout << "\n";
-            std::cout << "  " << std::hex << std::setw(4) << std::setfill('0') << i << ":  ";
+static bool ends_with(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() &&
+           text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// capture.pcap -> capture.<worker>.pcap, capture.pcapng -> capture.<worker>.pcapng
+static std::string worker_output_file(const std::string& base, int worker) {
+    std::string stem = base;
+    std::string extension = ".pcap";
+    if (ends_with(stem, ".pcapng")) {
+        extension = ".pcapng";
+    }
+    if (ends_with(stem, extension)) {
+        stem.resize(stem.size() - extension.size());
+    }
+    return stem + "." + std::to_string(worker) + extension;
+}
+
+// a .pcapng file name selects pcapng, anything else classic PCAP with nanosecond timestamps;
+// null when the file cannot be opened
+static std::unique_ptr<PacketWriter> open_writer(const std::string& file,
+                                                 const CaptureConfig& capture_config) {
+    std::unique_ptr<PacketWriter> writer;
+    if (ends_with(file, ".pcapng")) {
+        auto pcapng = std::make_unique<PcapngWriter>();
+        if (!pcapng->open(file, capture_config.snaplen)) {
+            return nullptr;
+        }
+        writer = std::move(pcapng);
+    } else {
+        auto pcap = std::make_unique<PcapWriter>();
+        if (!pcap->open(file, PcapTimestampPrecision::Nano, capture_config.snaplen)) {
+            return nullptr;
         }
-        std::cout << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(data[i])
-                  << " ";
+        writer = std::move(pcap);
+    }
+
+    writer->set_segment_gso(capture_config.gso == GsoMode::Segment);
+    return writer;
+}
+
+static void print_capture_mode(const PacketCapturer& capturer,
+                               const CaptureConfig& capture_config) {
+    if (capturer.mode() == CaptureMode::Ring) {
+        // the kernel maps ring blocks into user space one base page at a time
+        std::cout << "[*] Using TPACKET_V3 ring: " << capture_config.ring.block_count << " x "
+                  << capture_config.ring.block_size << " bytes on normal pages\n";
+    } else if (capturer.mode() == CaptureMode::Batch) {
+        std::cout << "[*] Using recvmmsg() with batches of " << capturer.batch_size()
+                  << ", buffers on " << page_backing_name(capturer.buffer_backing()) << "\n";
+    } else if (capturer.mode() == CaptureMode::Xdp) {
+        std::cout << "[*] Using AF_XDP on queue " << capture_config.xdp.queue_id << ": "
+                  << (capturer.xdp().generic() ? "generic" : "native") << " XDP, "
+                  << (capturer.xdp().zero_copy() ? "zero-copy" : "copy") << " mode, "
+                  << capture_config.xdp.frame_count << " x " << capture_config.xdp.frame_size
+                  << " byte UMEM frames on " << page_backing_name(capturer.xdp().umem_backing())
+                  << "\n";
+    }
+
+    if (capture_config.direction == CaptureDirection::In && capturer.mode() != CaptureMode::Xdp) {
+        std::cout << "[*] Dropping outgoing frames "
+                  << (capturer.ignores_outgoing() ? "with PACKET_IGNORE_OUTGOING"
+                                                  : "in the kernel filter")
+                  << "\n";
+    } else if (capture_config.direction == CaptureDirection::Out) {
+        std::cout << "[*] Dropping incoming frames in the kernel filter\n";
+    }
+
+    if (capture_config.autosize.max_bytes > 0 && capturer.mode() == CaptureMode::Ring) {
+        std::cout << "[*] Auto-sizing logs the ring size to use, up to "
+                  << capture_config.autosize.max_bytes << " bytes\n";
+    } else if (capture_config.autosize.max_bytes > 0 && capturer.mode() != CaptureMode::Xdp) {
+        std::cout << "[*] Auto-sizing the receive buffer from " << capturer.receive_buffer_size()
+                  << " up to " << capture_config.autosize.max_bytes << " bytes\n";
+    }
+
+    if (capture_config.shed.enabled && capturer.mode() != CaptureMode::Xdp) {
+        const LoadShedConfig& shed = capture_config.shed;
+        std::cout << "[*] Load shedding: frames cut to " << shed.header_bytes << " bytes at "
+                  << static_cast<int>(shed.headers_at * 100) << "% full, 1 in "
+                  << shed.sample_rate << " kept at " << static_cast<int>(shed.sample_at * 100)
+                  << "%, all dropped at " << static_cast<int>(shed.drop_at * 100) << "%\n";
+    }
+
+    if (capturer.reads_vnet_headers()) {
+        std::cout << "[*] Reading virtio-net headers, GSO super-frames are "
+                  << (capture_config.gso == GsoMode::Segment ? "segmented on export"
+                                                             : "recorded whole")
+                  << "\n";
+    }
+}
+
+// CPUs given with --cpus, empty when threads are left to the scheduler
+static std::vector<int> capture_cpus(const CliOptions& opts) {
+    std::vector<int> cpus;
+    if (!opts.cpus.empty()) {
+        parse_cpu_list(opts.cpus, cpus);
+    }
+    return cpus;
+}
+
+// logs where a capture's memory went and which CPU serves it; cpu < 0 means not pinned
+static void print_layout(const std::string& thread, const PacketCapturer& capturer, int cpu) {
+    const int node = interface_numa_node(capturer.iface());
+    const std::vector<int> node_cpus = numa_node_cpus(node);
+
+    std::cout << "[*] " << thread << ": " << capturer.iface();
+    if (node >= 0) {
+        std::cout << " on NUMA node " << node << " (CPUs " << format_cpu_list(node_cpus) << ")";
+    } else {
+        std::cout << " without a NUMA node";
+    }
+    if (capturer.numa_node() >= 0) {
+        std::cout << ", memory on node " << capturer.numa_node();
+    } else {
+        std::cout << ", memory placed by the kernel";
+    }
+    if (cpu >= 0) {
+        std::cout << ", pinned to CPU " << cpu << "\n";
+    } else {
+        std::cout << ", not pinned\n";
+    }
+
+    if (cpu >= 0 && !node_cpus.empty() &&
+        std::find(node_cpus.begin(), node_cpus.end(), cpu) == node_cpus.end()) {
+        std::cerr << "[!] CPU " << cpu << " is not on NUMA node " << node << " of "
+                  << capturer.iface() << "\n";
     }
-    std::cout << std::dec << "\n";
 }
 
-void on_frame_captured(const uint8_t* data, size_t len, const CliOptions& opts) {
-    if (len < 14) {
-        if (opts.verbose) {
-            std::cerr << "[!] Frame too small: " << len << " bytes\n";
+// records each capturer's load shedding and final kernel counters in its writer (pcapng
+// statistics blocks) and returns their sum; call before the capturers are closed
+static CaptureStats finish_stats(const std::vector<PacketCapturer*>& capturers,
+                                 const std::vector<PacketWriter*>& writers) {
+    const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+
+    CaptureStats total;
+    for (size_t i = 0; i < capturers.size(); ++i) {
+        const CaptureStats stats = capturers[i]->poll_stats();
+        total += stats;
+        if (writers[i] != nullptr) {
+            for (const ShedInterval& interval : capturers[i]->shed_intervals()) {
+                writers[i]->write_shed_interval(capturers[i]->ifindex(), interval);
+            }
+            InterfaceStatistics record;
+            record.ts_ns = static_cast<uint64_t>(now);
+            record.received = stats.packets;
+            record.dropped = stats.drops;
+            record.delivered = capturers[i]->delivered();
+            writers[i]->write_statistics(capturers[i]->ifindex(), record);
         }
-        return;
     }
+    return total;
+}
+
+// frames of a capture on every interface are labelled with the interface they came in on, and
+// the socket's counters, which cover all of them, get an interface block of their own
+static void label_any_interface(Pipeline& pipeline, PacketWriter* writer) {
+    pipeline.label_interfaces();
+    if (writer != nullptr) {
+        writer->add_interface(ANY_INTERFACE, 0);
+    }
+}
+
+static int run_single(const CliOptions& opts, const CaptureConfig& capture_config) {
+    std::unique_ptr<PacketWriter> writer;
+    if (!opts.output_file.empty()) {
+        writer = open_writer(opts.output_file, capture_config);
+        if (writer) {
+            std::cout << "[*] Writing packets to " << opts.output_file << "\n";
+        } else {
+            std::cerr << "[!] Failed to open PCAP file, continuing without saving\n";
+        }
+    }
+
+    PacketCapturer capturer;
+    if (!capturer.open(opts.interface, opts.promiscuous, capture_config)) {
+        std::cerr << "[!] Failed to open capture on " << opts.interface << "\n";
+        return 1;
+    }
+
+    print_capture_mode(capturer, capture_config);
+    const std::vector<int> cpus = capture_cpus(opts);
+    print_layout("Capture thread", capturer, cpus.empty() ? -1 : cpus.front());
+
+    Pipeline pipeline(opts, writer.get());
+    if (opts.packet_count > 0) {
+        pipeline.set_packet_limit(static_cast<uint64_t>(opts.packet_count));
+    }
+    if (capturer.any_interface()) {
+        label_any_interface(pipeline, writer.get());
+    }
+
+    StatusReporter status({&capturer}, [&pipeline]() { return pipeline.packet_count(); },
+                          opts.stats_interval, std::cerr);
+
+    // pinned only now, so the status thread does not inherit the capture CPU
+    if (!cpus.empty()) {
+        pin_current_thread(cpus.front());
+    }
+
+    try {
+        capturer.run_batch(
+            [&pipeline](const PacketView* packets, size_t count) {
+                pipeline.on_batch(packets, count);
+                if (pipeline.limit_reached()) {
+                    g_stop.request();
+                }
+            },
+            g_stop);
+    } catch (const std::exception& e) {
+        std::cerr << "[!] Capture error: " << e.what() << "\n";
+        status.stop();
+        capturer.close();
+        return 1;
+    }
+
+    status.stop();
+    const CaptureStats kernel_stats = finish_stats({&capturer}, {writer.get()});
+    capturer.close();
 
-    int current_count = g_packet_counter.fetch_add(1) + 1;
+    if (writer) {
+        writer->close();
+        std::cout << "[*] PCAP file closed: " << opts.output_file << "\n";
+    }
 
-    if (g_pcap_writer && g_pcap_writer->is_open()) {
-        g_pcap_writer->write_packet(data, len);
+    std::cout << "\n[*] Capture stopped\n";
+    std::cout << "[*] Total packets captured: " << pipeline.packet_count() << "\n";
+    std::cout << "[*] Kernel: " << format_capture_stats(kernel_stats) << "\n";
+    if (capture_config.measure_latency) {
+        std::cout << "[*] Delivery latency: " << capturer.latency().summary() << "\n";
     }
 
-    EthernetFrame frame;
-    if (!parse_ethernet_frame(data, len, frame)) {
-        if (opts.verbose) {
-            std::cerr << "[!] Failed to parse Ethernet frame\n";
+    return 0;
+}
+
+static int run_multi(const CliOptions& opts, const CaptureConfig& capture_config,
+                     const std::vector<std::string>& interfaces) {
+    std::unique_ptr<PacketWriter> writer;
+    if (!opts.output_file.empty()) {
+        writer = open_writer(opts.output_file, capture_config);
+        if (writer) {
+            std::cout << "[*] Writing packets of all interfaces to " << opts.output_file << "\n";
+        } else {
+            std::cerr << "[!] Failed to open PCAP file, continuing without saving\n";
         }
-        return;
     }
 
-    std::cout << "\n[Packet #" << current_count << "] " << len << " bytes | " << frame.src_mac
-              << " -> " << frame.dst_mac << " | " << "EtherType: 0x" << std::hex << std::setw(4)
-              << std::setfill('0') << frame.ethertype << std::dec;
+    MultiCapturer capturer;
+    if (!capturer.open(interfaces, opts.promiscuous, capture_config)) {
+        return 1;
+    }
+    capturer.set_merge_window(static_cast<uint32_t>(opts.merge_window_ms));
 
-    if (opts.show_parsed) {
-        ProtocolParser* parser = ProtocolParser::get_parser(frame.ethertype);
+    Pipeline pipeline(opts, writer.get());
+    if (opts.packet_count > 0) {
+        pipeline.set_packet_limit(static_cast<uint64_t>(opts.packet_count));
+    }
+    for (size_t i = 0; i < capturer.size(); ++i) {
+        pipeline.set_interface_name(capturer.capturer(i).ifindex(), capturer.capturer(i).iface());
+    }
 
-        if (parser) {
-            std::cout << " (" << parser->protocol_name() << ")\n";
+    std::cout << "[*] Merging " << capturer.size() << " interfaces in timestamp order, "
+              << opts.merge_window_ms << " ms window\n";
+    print_capture_mode(capturer.capturer(0), capture_config);
 
-            if (parser->parse(frame.payload, frame.payload_len)) {
-                parser->print();
-            } else {
-                std::cerr << "[!] Failed to parse " << parser->protocol_name() << " packet\n";
-            }
+    const std::vector<int> cpus = capture_cpus(opts);
+    std::vector<PacketCapturer*> sources;
+    for (size_t i = 0; i < capturer.size(); ++i) {
+        sources.push_back(&capturer.capturer(i));
+        print_layout("Capture thread", capturer.capturer(i), cpus.empty() ? -1 : cpus.front());
+    }
+    StatusReporter status(sources, [&pipeline]() { return pipeline.packet_count(); },
+                          opts.stats_interval, std::cerr);
+
+    if (!cpus.empty()) {
+        pin_current_thread(cpus.front());
+    }
+
+    try {
+        capturer.run_batch(
+            [&pipeline](const PacketView* packets, size_t count) {
+                pipeline.on_batch(packets, count);
+                if (pipeline.limit_reached()) {
+                    g_stop.request();
+                }
+            },
+            g_stop);
+    } catch (const std::exception& e) {
+        std::cerr << "[!] Capture error: " << e.what() << "\n";
+        status.stop();
+        capturer.close();
+        return 1;
+    }
+
+    status.stop();
+    const CaptureStats kernel_stats =
+        finish_stats(sources, std::vector<PacketWriter*>(sources.size(), writer.get()));
+    capturer.close();
+
+    if (writer) {
+        writer->close();
+        std::cout << "[*] PCAP file closed: " << opts.output_file << "\n";
+    }
+
+    std::cout << "\n[*] Capture stopped\n";
+    std::cout << "[*] Total packets captured: " << pipeline.packet_count() << "\n";
+    std::cout << "[*] Kernel: " << format_capture_stats(kernel_stats) << "\n";
+    if (capture_config.measure_latency) {
+        std::cout << "[*] Delivery latency: " << capturer.latency().summary() << "\n";
+    }
+
+    return 0;
+}
+
+static int run_generator(const CliOptions& opts, const CaptureConfig& capture_config) {
+    GeneratorConfig config;
+    if (!parse_traffic_mix(opts.gen_mix, config) || !parse_frame_sizes(opts.gen_size, config) ||
+        opts.gen_rate < 0 || opts.gen_flows < 1) {
+        std::cerr << "[!] Error: invalid generator rate, flow count, mix or sizes\n";
+        return 1;
+    }
+    config.rate_pps = static_cast<uint64_t>(opts.gen_rate);
+    config.flow_count = static_cast<uint32_t>(opts.gen_flows);
+    config.batch_size = capture_config.batch_size > 1 ? capture_config.batch_size : 64;
+    config.snaplen = capture_config.snaplen;
+    config.huge_pages = capture_config.huge_pages;
+
+    TrafficGenerator generator;
+    if (!generator.open(config)) {
+        return 1;
+    }
+
+    std::unique_ptr<PacketWriter> writer;
+    if (!opts.output_file.empty()) {
+        writer = open_writer(opts.output_file, capture_config);
+        if (writer) {
+            std::cout << "[*] Writing packets to " << opts.output_file << "\n";
         } else {
-            std::cout << " (Unknown)\n";
+            std::cerr << "[!] Failed to open PCAP file, continuing without saving\n";
         }
+    }
+
+    std::cout << "[*] Generating " << opts.gen_mix << " over " << opts.gen_flows << " flows, "
+              << opts.gen_size << " sizes, ";
+    if (opts.gen_rate > 0) {
+        std::cout << opts.gen_rate << " pps\n";
     } else {
-        std::cout << "\n";
+        std::cout << "as fast as possible\n";
+    }
+    std::cout << "[*] Frame pool on " << page_backing_name(generator.pool_backing()) << "\n";
+
+    Pipeline pipeline(opts, writer.get());
+    if (opts.packet_count > 0) {
+        pipeline.set_packet_limit(static_cast<uint64_t>(opts.packet_count));
     }
 
-    if (opts.show_hex) {
-        print_hex_dump(data, len);
+    const std::vector<int> cpus = capture_cpus(opts);
+    if (!cpus.empty() && pin_current_thread(cpus.front())) {
+        std::cout << "[*] Generator thread pinned to CPU " << cpus.front() << "\n";
     }
 
-    if (opts.packet_count > 0 && current_count >= opts.packet_count) {
-        g_running.store(false);
+    generator.run_batch(
+        [&pipeline](const PacketView* packets, size_t count) {
+            pipeline.on_batch(packets, count);
+            if (pipeline.limit_reached()) {
+                g_stop.request();
+            }
+        },
+        g_stop);
+
+    if (writer) {
+        writer->close();
+        std::cout << "[*] PCAP file closed: " << opts.output_file << "\n";
     }
+
+    const double seconds = static_cast<double>(generator.elapsed_ns()) / 1e9;
+    std::cout << "\n[*] Generator stopped\n";
+    std::cout << "[*] Total packets processed: " << pipeline.packet_count() << " in " << seconds
+              << " s";
+    if (seconds > 0) {
+        std::cout << " (" << static_cast<uint64_t>(static_cast<double>(pipeline.packet_count()) /
+                                                    seconds)
+                  << " pps)";
+    }
+    std::cout << "\n";
+
+    return 0;
 }
 
-int main(int argc, char** argv) {
-    if (geteuid() != 0) {
-        std::cerr << "[!] Error: raw sockets require root privileges\n";
-        std::cerr << "    Run with sudo or grant CAP_NET_RAW capability\n";
+// sends the frames of a PCAP file out of one interface and reports the achieved rate
+static int run_replay(const CliOptions& opts) {
+    ReplayConfig config;
+    if (!parse_replay_speed(opts.replay_speed, config.speed)) {
+        std::cerr << "[!] Error: invalid replay speed " << opts.replay_speed << "\n";
+        return 1;
+    }
+    config.qdisc_bypass = opts.qdisc_bypass;
+
+    PcapReader reader;
+    if (!reader.open(opts.replay_file)) {
         return 1;
     }
+    size_t count = reader.frames().size();
+    if (opts.packet_count > 0 && static_cast<size_t>(opts.packet_count) < count) {
+        count = static_cast<size_t>(opts.packet_count);
+    }
 
+    PacketReplayer replayer;
+    if (!replayer.open(opts.interface, config)) {
+        std::cerr << "[!] Failed to set up the TX ring on " << opts.interface << "\n";
+        return 1;
+    }
+
+    std::cout << "\n[*] Replaying " << count << " frames from " << opts.replay_file << " on "
+              << opts.interface << " at ";
+    if (config.speed == 0) {
+        std::cout << "top speed";
+    } else if (config.speed == 1) {
+        std::cout << "original speed";
+    } else {
+        std::cout << config.speed << "x original speed";
+    }
+    std::cout << (config.qdisc_bypass ? ", bypassing the qdisc\n" : "\n");
+    std::cout << "[*] Press Ctrl+C to stop\n";
+
+    const std::vector<int> cpus = capture_cpus(opts);
+    if (!cpus.empty() && pin_current_thread(cpus.front())) {
+        std::cout << "[*] Replay thread pinned to CPU " << cpus.front() << "\n";
+    }
+
+    const bool ok = replayer.replay(reader.frames().data(), count, g_stop);
+    const ReplayStats& stats = replayer.stats();
+
+    std::cout << "\n[*] Replay " << (ok ? "finished" : "failed") << "\n";
+    std::cout << "[*] Sent " << stats.frames << " frames, " << stats.bytes << " bytes in "
+              << std::fixed << std::setprecision(3) << static_cast<double>(stats.elapsed_ns) / 1e9
+              << " s: " << std::setprecision(0) << stats.pps() << " pps, " << std::setprecision(3)
+              << stats.gbps() << " Gbps\n";
+    if (stats.skipped > 0) {
+        std::cout << "[*] Skipped " << stats.skipped
+                  << " frames shorter than an Ethernet header or longer than the MTU allows\n";
+    }
+
+    return ok ? 0 : 1;
+}
+
+static int run_workers(const CliOptions& opts, CaptureConfig capture_config) {
+    const auto worker_count = static_cast<size_t>(opts.workers);
+
+    if (!parse_fanout_mode(opts.fanout_mode, capture_config.fanout)) {
+        std::cerr << "[!] Unknown fanout mode: " << opts.fanout_mode << "\n";
+        return 1;
+    }
+    capture_config.fanout_group = static_cast<uint16_t>(getpid() & 0xffff);
+
+    std::vector<std::unique_ptr<PacketCapturer>> capturers;
+    std::vector<std::unique_ptr<PacketWriter>> writers;
+    std::vector<std::unique_ptr<Pipeline>> pipelines;
+
+    for (size_t i = 0; i < worker_count; ++i) {
+        auto capturer = std::make_unique<PacketCapturer>();
+        if (!capturer->open(opts.interface, opts.promiscuous, capture_config)) {
+            std::cerr << "[!] Failed to open capture socket " << i << " on " << opts.interface
+                      << "\n";
+            return 1;
+        }
+        capturers.push_back(std::move(capturer));
+
+        std::unique_ptr<PacketWriter> writer;
+        if (!opts.output_file.empty()) {
+            std::string file = worker_output_file(opts.output_file, static_cast<int>(i));
+            writer = open_writer(file, capture_config);
+            if (writer) {
+                std::cout << "[*] Worker " << i << " writing packets to " << file << "\n";
+            } else {
+                std::cerr << "[!] Failed to open " << file << ", worker " << i
+                          << " continues without saving\n";
+            }
+        }
+        pipelines.push_back(std::make_unique<Pipeline>(opts, writer.get(), static_cast<int>(i)));
+        if (capturers.back()->any_interface()) {
+            label_any_interface(*pipelines.back(), writer.get());
+        }
+        writers.push_back(std::move(writer));
+    }
+
+    std::cout << "[*] " << worker_count << " workers in fanout group "
+              << capture_config.fanout_group << " (" << opts.fanout_mode << ")\n";
+    print_capture_mode(*capturers.front(), capture_config);
+
+    // worker i takes entry i of the CPU list, wrapping around when there are more workers
+    const std::vector<int> cpus = capture_cpus(opts);
+    auto worker_cpu = [&cpus](size_t worker) {
+        return cpus.empty() ? -1 : cpus[worker % cpus.size()];
+    };
+    for (size_t i = 0; i < worker_count; ++i) {
+        print_layout("Worker " + std::to_string(i), *capturers[i], worker_cpu(i));
+    }
+
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < worker_count; ++i) {
+        threads.emplace_back([&, i]() {
+            if (worker_cpu(i) >= 0) {
+                pin_current_thread(worker_cpu(i));
+            }
+            Pipeline& pipeline = *pipelines[i];
+            try {
+                capturers[i]->run_batch(
+                    [&pipeline](const PacketView* packets, size_t count) {
+                        pipeline.on_batch(packets, count);
+                    },
+                    g_stop);
+            } catch (const std::exception& e) {
+                std::cerr << "[!] Worker " << i << " capture error: " << e.what() << "\n";
+                failed.store(true);
+                g_stop.request();
+            }
+        });
+    }
+
+    // workers count independently; the packet limit is enforced here from their totals
+    auto total_packets = [&pipelines]() {
+        uint64_t total = 0;
+        for (const auto& pipeline : pipelines) {
+            total += pipeline->packet_count();
+        }
+        return total;
+    };
+
+    std::vector<PacketCapturer*> sources;
+    std::vector<PacketWriter*> sinks;
+    for (size_t i = 0; i < worker_count; ++i) {
+        sources.push_back(capturers[i].get());
+        sinks.push_back(writers[i].get());
+    }
+    StatusReporter status(sources, total_packets, opts.stats_interval, std::cerr);
+
+    // the workers stop themselves on signals and the deadline; only the shared limit is checked
+    while (!g_stop.wait(10)) {
+        if (opts.packet_count > 0 && total_packets() >= static_cast<uint64_t>(opts.packet_count)) {
+            g_stop.request();
+        }
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    status.stop();
+
+    std::vector<CaptureStats> worker_stats;
+    for (size_t i = 0; i < worker_count; ++i) {
+        worker_stats.push_back(finish_stats({sources[i]}, {sinks[i]}));
+    }
+
+    for (auto& capturer : capturers) {
+        capturer->close();
+    }
+    for (auto& writer : writers) {
+        if (writer) {
+            writer->close();
+        }
+    }
+
+    std::cout << "\n[*] Capture stopped\n";
+    CaptureStats kernel_stats;
+    for (size_t i = 0; i < worker_count; ++i) {
+        std::cout << "[*] Worker " << i << ": " << pipelines[i]->packet_count()
+                  << " packets, kernel " << format_capture_stats(worker_stats[i]) << "\n";
+        kernel_stats += worker_stats[i];
+    }
+    std::cout << "[*] Total packets captured: " << total_packets() << "\n";
+    std::cout << "[*] Kernel: " << format_capture_stats(kernel_stats) << "\n";
+
+    if (capture_config.measure_latency) {
+        LatencyHistogram latency;
+        for (const auto& capturer : capturers) {
+            latency.merge(capturer->latency());
+        }
+        std::cout << "[*] Delivery latency: " << latency.summary() << "\n";
+    }
+
+    return failed.load() ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
     CliOptions opts;
 
     if (!handle_cli(argc, argv, opts)) {
         return 1;
     }
 
+    // anything shorter than an Ethernet header would be dropped as a runt
+    if (opts.snaplen != 0 &&
+        (opts.snaplen < 14 || static_cast<uint32_t>(opts.snaplen) > DEFAULT_SNAPLEN)) {
+        std::cerr << "[!] Error: snap length must be between 14 and " << DEFAULT_SNAPLEN
+                  << " bytes\n";
+        return 1;
+    }
+
+    CaptureConfig capture_config;
+    capture_config.snaplen = static_cast<uint32_t>(opts.snaplen);
+    if (!opts.filter.empty() || opts.filter_dump) {
+        std::string error;
+        uint32_t accept_len = opts.snaplen > 0 ? capture_config.snaplen : DEFAULT_SNAPLEN;
+        if (!compile_filter(opts.filter, capture_config.filter, error, accept_len)) {
+            std::cerr << "[!] Invalid filter: " << error << "\n";
+            return 1;
+        }
+        if (opts.filter_dump) {
+            std::cout << dump_filter(capture_config.filter);
+            return 0;
+        }
+    }
+
+    if (opts.generate && (opts.use_ring || opts.use_xdp || opts.workers > 1 ||
+                          !opts.filter.empty() ||
+                          opts.interface.find(',') != std::string::npos)) {
+        std::cerr << "[!] Error: --generate replaces the capture source and cannot be combined "
+                     "with --ring, --xdp, --workers, --filter or several interfaces\n";
+        return 1;
+    }
+
+    if (!opts.generate && geteuid() != 0) {
+        std::cerr << "[!] Error: raw sockets require root privileges\n";
+        std::cerr << "    Run with sudo or grant CAP_NET_RAW capability\n";
+        return 1;
+    }
+
     std::signal(SIGINT, signal_handler);
     std::signal(SIGTERM, signal_handler);
 
-    PcapWriter pcap_writer;
-    if (!opts.output_file.empty()) {
-        if (pcap_writer.open(opts.output_file)) {
-            g_pcap_writer = &pcap_writer;
-            std::cout << "[*] Writing packets to " << opts.output_file << "\n";
-        } else {
-            std::cerr << "[!] Failed to open PCAP file, continuing without saving\n";
+    if (opts.workers < 1) {
+        std::cerr << "[!] Error: worker count must be at least 1\n";
+        return 1;
+    }
+
+    const std::vector<std::string> interfaces = split_interfaces(opts.interface);
+    if (interfaces.empty()) {
+        std::cerr << "[!] Error: no interface given\n";
+        return 1;
+    }
+    if (interfaces.size() > 1 && opts.workers > 1) {
+        std::cerr << "[!] Error: several interfaces cannot be combined with --workers\n";
+        return 1;
+    }
+    if (interfaces.size() == 1) {
+        opts.interface = interfaces.front();
+    } else if (std::find(interfaces.begin(), interfaces.end(), ANY_INTERFACE) !=
+               interfaces.end()) {
+        std::cerr << "[!] Error: " << ANY_INTERFACE
+                  << " already captures every interface and cannot be part of a list\n";
+        return 1;
+    }
+    if (opts.interface == ANY_INTERFACE && !opts.output_file.empty() &&
+        !ends_with(opts.output_file, ".pcapng")) {
+        std::cerr << "[!] Warning: PCAP files do not record the interface of a frame, write a "
+                     ".pcapng file to keep it\n";
+    }
+    if (opts.stats_interval < 0) {
+        std::cerr << "[!] Error: status interval must not be negative\n";
+        return 1;
+    }
+    if (opts.merge_window_ms < 0) {
+        std::cerr << "[!] Error: merge window must not be negative\n";
+        return 1;
+    }
+
+    if (!opts.replay_file.empty()) {
+        if (opts.generate || interfaces.size() > 1 || opts.workers > 1 || opts.use_ring ||
+            opts.use_xdp || !opts.filter.empty()) {
+            std::cerr << "[!] Error: --replay sends from one interface and cannot be combined "
+                         "with --generate, --ring, --xdp, --workers, --filter or an interface "
+                         "list\n";
+            return 1;
         }
+        if (opts.capture_duration > 0) {
+            g_stop.set_deadline_in(static_cast<uint64_t>(opts.capture_duration) * 1000);
+        }
+        return run_replay(opts);
     }
 
-    std::cout << "\n[*] Starting traffic capture on " << opts.interface << "\n";
+    if (opts.generate) {
+        std::cout << "\n[*] Starting synthetic traffic\n";
+    } else {
+        std::cout << "\n[*] Starting traffic capture on " << opts.interface << "\n";
+    }
     std::cout << "[*] Press Ctrl+C to stop\n";
     if (opts.promiscuous) {
         std::cout << "[*] Promiscuous mode enabled\n";
     }
 
-    std::cout << "[*] Display mode: ";
-    if (opts.show_parsed && opts.show_hex) {
-        std::cout << "Parsed + HEX\n";
-    } else if (opts.show_parsed) {
-        std::cout << "Parsed only\n";
+    if (opts.record_only) {
+        if (opts.output_file.empty()) {
+            std::cerr << "[!] Error: --record needs an output file (-o)\n";
+            return 1;
+        }
+        std::cout << "[*] Recording only: frames go to " << opts.output_file
+                  << " without being parsed or printed\n";
     } else {
-        std::cout << "HEX only\n";
+        std::cout << "[*] Display mode: ";
+        if (opts.show_parsed && opts.show_hex) {
+            std::cout << "Parsed + HEX\n";
+        } else if (opts.show_parsed) {
+            std::cout << "Parsed only\n";
+        } else {
+            std::cout << "HEX only\n";
+        }
     }
 
     if (opts.packet_count > 0) {
@@ -137,46 +758,113 @@ int main(int argc, char** argv) {
         std::cout << "[*] Will capture for " << opts.capture_duration << " seconds\n";
     }
 
-    PacketCapturer capturer;
-    if (!capturer.open(opts.interface, opts.promiscuous)) {
-        std::cerr << "[!] Failed to open capture on " << opts.interface << "\n";
-        return 1;
+    if (opts.snaplen > 0) {
+        std::cout << "[*] Snap length: " << opts.snaplen << " bytes\n";
     }
 
-    std::thread timer_thread;
-    if (opts.capture_duration > 0) {
-        timer_thread = std::thread([&opts]() {
-            std::this_thread::sleep_for(std::chrono::seconds(opts.capture_duration));
-            g_running.store(false);
-        });
+    if (!opts.filter.empty()) {
+        std::cout << "[*] Kernel filter: " << opts.filter << " (" << capture_config.filter.size()
+                  << " BPF instructions)\n";
     }
 
-    try {
-        capturer.run(
-            [&opts](const uint8_t* data, size_t len) { on_frame_captured(data, len, opts); },
-            g_running);
-    } catch (const std::exception& e) {
-        std::cerr << "[!] Capture error: " << e.what() << "\n";
-        capturer.close();
-        if (timer_thread.joinable()) {
-            timer_thread.join();
+    if (opts.use_ring) {
+        if (opts.ring_block_size <= 0 || opts.ring_block_count <= 0 ||
+            opts.ring_block_timeout < 0) {
+            std::cerr << "[!] Error: ring block size and count must be positive\n";
+            return 1;
         }
+        capture_config.mode = CaptureMode::Ring;
+        capture_config.ring.block_size = static_cast<uint32_t>(opts.ring_block_size);
+        capture_config.ring.block_count = static_cast<uint32_t>(opts.ring_block_count);
+        capture_config.ring.block_timeout_ms = static_cast<uint32_t>(opts.ring_block_timeout);
+    }
+
+    if (opts.use_xdp) {
+        if (opts.use_ring || opts.workers > 1) {
+            std::cerr << "[!] Error: --xdp cannot be combined with --ring or --workers\n";
+            return 1;
+        }
+        if (opts.xdp_queue < 0 || !parse_xdp_bind_mode(opts.xdp_bind, capture_config.xdp.bind)) {
+            std::cerr << "[!] Error: invalid AF_XDP queue or bind mode\n";
+            return 1;
+        }
+        capture_config.mode = CaptureMode::Xdp;
+        capture_config.xdp.queue_id = static_cast<uint32_t>(opts.xdp_queue);
+        capture_config.xdp.generic = opts.xdp_generic;
+    }
+
+    if (opts.busy_poll_us < 0) {
+        std::cerr << "[!] Error: busy-poll budget must not be negative\n";
+        return 1;
+    }
+    capture_config.busy_poll_us = static_cast<uint32_t>(opts.busy_poll_us);
+    if (!parse_numa_node(opts.numa, capture_config.numa_node)) {
+        std::cerr << "[!] Error: invalid NUMA node " << opts.numa << "\n";
+        return 1;
+    }
+    if (!parse_capture_direction(opts.direction, capture_config.direction)) {
+        std::cerr << "[!] Error: invalid direction " << opts.direction << "\n";
+        return 1;
+    }
+    if (!parse_huge_page_mode(opts.hugepages, capture_config.huge_pages)) {
+        std::cerr << "[!] Error: invalid hugepage mode " << opts.hugepages << "\n";
+        return 1;
+    }
+    capture_config.xdp.huge_pages = capture_config.huge_pages;
+    if (!parse_gso_mode(opts.gso, capture_config.gso)) {
+        std::cerr << "[!] Error: invalid GSO mode " << opts.gso << "\n";
         return 1;
     }
+    if (!opts.autosize.empty() &&
+        !parse_byte_size(opts.autosize, capture_config.autosize.max_bytes)) {
+        std::cerr << "[!] Error: invalid buffer cap " << opts.autosize << "\n";
+        return 1;
+    }
+    if (opts.shed_bytes < 0 || (opts.shed_bytes > 0 && opts.shed_bytes < 14)) {
+        std::cerr << "[!] Error: load shedding has to keep at least the 14-byte Ethernet header\n";
+        return 1;
+    }
+    capture_config.shed.enabled = opts.shed_bytes > 0;
+    if (capture_config.shed.enabled) {
+        capture_config.shed.header_bytes = static_cast<uint32_t>(opts.shed_bytes);
+    }
+    capture_config.measure_latency = opts.report_latency;
+    if (opts.busy_poll_us > 0) {
+        std::cout << "[*] Busy polling for " << opts.busy_poll_us << " us before sleeping\n";
+    }
 
-    capturer.close();
+    if (opts.batch_size < 1) {
+        std::cerr << "[!] Error: batch size must be at least 1\n";
+        return 1;
+    }
+    capture_config.batch_size = static_cast<uint32_t>(opts.batch_size);
 
-    if (timer_thread.joinable()) {
-        timer_thread.join();
+    // frames are stamped once per batch as they are read, from the TSC once it is calibrated
+    if (opts.timestamps == "tsc") {
+        capture_config.kernel_timestamps = false;
+        if (calibrate_tsc_clock()) {
+            std::cout << "[*] Stamping frames from the TSC at " << tsc_clock_hz() / 1000000
+                      << " MHz, re-synced with CLOCK_REALTIME every second\n";
+        } else {
+            std::cerr << "[!] Warning: no invariant TSC, frames are stamped with clock_gettime()\n";
+        }
     }
+    TscResync tsc_resync(tsc_clock_active() ? 1000 : 0);
 
-    if (g_pcap_writer) {
-        pcap_writer.close();
-        std::cout << "[*] PCAP file closed: " << opts.output_file << "\n";
+    if (opts.capture_duration > 0) {
+        g_stop.set_deadline_in(static_cast<uint64_t>(opts.capture_duration) * 1000);
     }
 
-    std::cout << "\n[*] Capture stopped\n";
-    std::cout << "[*] Total packets captured: " << g_packet_counter.load() << "\n";
+    int rc = 0;
+    if (opts.generate) {
+        rc = run_generator(opts, capture_config);
+    } else if (interfaces.size() > 1) {
+        rc = run_multi(opts, capture_config, interfaces);
+    } else if (opts.workers > 1) {
+        rc = run_workers(opts, capture_config);
+    } else {
+        rc = run_single(opts, capture_config);
+    }
 
-    return 0;
+    return rc;
 }
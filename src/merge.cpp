@@ -0,0 +1,62 @@
+#include "merge.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+void FrameMerger::push(const PacketView* packets, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const PacketView& packet = packets[i];
+        m_frames.push_back({m_data.size(), packet});
+        m_data.insert(m_data.end(), packet.data, packet.data + packet.len);
+    }
+}
+
+size_t FrameMerger::flush(uint64_t watermark_ns,
+                          const std::function<void(const PacketView*, size_t)>& fn) {
+    if (m_frames.empty()) {
+        return 0;
+    }
+
+    // each capture delivers in order already, so this is mostly merging sorted runs
+    std::stable_sort(m_frames.begin(), m_frames.end(),
+                     [](const Frame& a, const Frame& b) { return a.view.ts_ns < b.view.ts_ns; });
+
+    auto ready = std::upper_bound(
+        m_frames.begin(), m_frames.end(), watermark_ns,
+        [](uint64_t watermark, const Frame& frame) { return watermark < frame.view.ts_ns; });
+    const auto count = static_cast<size_t>(ready - m_frames.begin());
+    if (count == 0) {
+        return 0;
+    }
+
+    m_views.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        m_views[i] = m_frames[i].view;
+        m_views[i].data = m_data.data() + m_frames[i].offset;
+    }
+    fn(m_views.data(), count);
+
+    // compact what is still held into the spare arena and swap the two
+    m_spare.clear();
+    for (size_t i = count; i < m_frames.size(); ++i) {
+        Frame& frame = m_frames[i];
+        const size_t offset = m_spare.size();
+        const auto begin = m_data.begin() + static_cast<std::ptrdiff_t>(frame.offset);
+        m_spare.insert(m_spare.end(), begin, begin + static_cast<std::ptrdiff_t>(frame.view.len));
+        frame.offset = offset;
+    }
+    m_data.swap(m_spare);
+    m_frames.erase(m_frames.begin(), ready);
+    return count;
+}
+
+size_t FrameMerger::flush_all(const std::function<void(const PacketView*, size_t)>& fn) {
+    return flush(UINT64_MAX, fn);
+}
+
+void FrameMerger::clear() {
+    m_frames.clear();
+    m_data.clear();
+    m_spare.clear();
+    m_views.clear();
+}
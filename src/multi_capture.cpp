@@ -0,0 +1,159 @@
+#include "multi_capture.hpp"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "tsc_clock.hpp"
+
+namespace {
+
+constexpr uint32_t MIN_DRAIN_BATCH = 64;
+constexpr int IDLE_TIMEOUT_MS = 100;
+
+}  // namespace
+
+MultiCapturer::~MultiCapturer() {
+    close();
+}
+
+bool MultiCapturer::open(const std::vector<std::string>& ifaces, bool promisc,
+                         const CaptureConfig& config) {
+    if (ifaces.empty()) {
+        std::cerr << "[!] No interfaces to capture on\n";
+        return false;
+    }
+
+    CaptureConfig capture_config = config;
+    if (capture_config.batch_size < MIN_DRAIN_BATCH) {
+        capture_config.batch_size = MIN_DRAIN_BATCH;
+    }
+
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll_fd < 0) {
+        std::cerr << "[!] epoll_create1() failed: " << strerror(errno) << "\n";
+        return false;
+    }
+
+    for (const auto& iface : ifaces) {
+        auto capturer = std::make_unique<PacketCapturer>();
+        if (!capturer->open(iface, promisc, capture_config)) {
+            std::cerr << "[!] Failed to open capture on " << iface << "\n";
+            close();
+            return false;
+        }
+
+        struct epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.u64 = m_capturers.size();
+        if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, capturer->get_fd(), &event) < 0) {
+            std::cerr << "[!] epoll_ctl() failed for " << iface << ": " << strerror(errno) << "\n";
+            close();
+            return false;
+        }
+
+        m_capturers.push_back(std::move(capturer));
+    }
+
+    return true;
+}
+
+void MultiCapturer::run_batch(const std::function<void(const PacketView*, size_t)>& callback,
+                              std::atomic<bool>& running) {
+    run_loop(callback, &running, nullptr);
+}
+
+void MultiCapturer::run_batch(const std::function<void(const PacketView*, size_t)>& callback,
+                              const StopSignal& stop) {
+    run_loop(callback, nullptr, &stop);
+}
+
+void MultiCapturer::run_loop(const std::function<void(const PacketView*, size_t)>& callback,
+                             const std::atomic<bool>* running, const StopSignal* stop) {
+    if (m_epoll_fd < 0) {
+        throw std::runtime_error("Sockets not opened. Call open() first.");
+    }
+
+    // tagged past the last capturer index so it is never drained
+    const uint64_t stop_tag = m_capturers.size();
+    const bool watch_stop = stop != nullptr && stop->fd() >= 0;
+    if (watch_stop) {
+        struct epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.u64 = stop_tag;
+        if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, stop->fd(), &event) < 0) {
+            throw std::runtime_error(std::string("epoll_ctl() failed: ") + strerror(errno));
+        }
+    }
+    auto stopped = [running, stop]() {
+        return running != nullptr ? !running->load() : stop->requested();
+    };
+
+    std::vector<struct epoll_event> events(m_capturers.size() + 1);
+    const auto push = [this](const PacketView* packets, size_t count) {
+        m_merger.push(packets, count);
+    };
+
+    // while frames are held, wake once per window so they leave even if every interface idles
+    const int window_ms = std::max(1, static_cast<int>(m_window_ns / 1000000ULL));
+
+    while (!stopped()) {
+        int timeout = m_merger.pending() > 0 ? window_ms : IDLE_TIMEOUT_MS;
+        if (stop != nullptr) {
+            timeout = stop->timeout_ms(timeout);
+        }
+
+        int ready = epoll_wait(m_epoll_fd, events.data(), static_cast<int>(events.size()), timeout);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("epoll_wait() failed: ") + strerror(errno));
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            if (events[i].data.u64 != stop_tag) {
+                m_capturers[events[i].data.u64]->drain(push);
+            }
+        }
+
+        if (m_merger.pending() > 0) {
+            const uint64_t now = wall_clock_ns();
+            m_merger.flush(now > m_window_ns ? now - m_window_ns : 0, callback);
+        }
+    }
+
+    m_merger.flush_all(callback);
+
+    if (watch_stop) {
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, stop->fd(), nullptr);
+    }
+}
+
+LatencyHistogram MultiCapturer::latency() const {
+    LatencyHistogram latency;
+    for (const auto& capturer : m_capturers) {
+        latency.merge(capturer->latency());
+    }
+    return latency;
+}
+
+void MultiCapturer::close() {
+    for (auto& capturer : m_capturers) {
+        capturer->close();
+    }
+    m_capturers.clear();
+    m_merger.clear();
+
+    if (m_epoll_fd >= 0) {
+        ::close(m_epoll_fd);
+        m_epoll_fd = -1;
+    }
+}
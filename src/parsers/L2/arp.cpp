@@ -1,11 +1,8 @@
 #include "parsers/L2/arp.hpp"
 
-#include <arpa/inet.h>
 #include <linux/if_ether.h>
 
-#include <iomanip>
 #include <iostream>
-#include <sstream>
 
 bool ArpParser::parse(const uint8_t* data, size_t len) {
     if (!data || len < 28) {
@@ -19,50 +16,26 @@ bool ArpParser::parse(const uint8_t* data, size_t len) {
     m_packet.proto_addr_len = data[5];
     m_packet.opcode = (data[6] << 8) | data[7];
 
-    // sender MAC (8-13)
-    std::ostringstream sender_mac;
-    sender_mac << std::hex << std::setfill('0');
-    for (int i = 0; i < 6; ++i) {
-        if (i > 0)
-            sender_mac << ":";
-        sender_mac << std::setw(2) << static_cast<int>(data[8 + i]);
-    }
-    m_packet.sender_mac = sender_mac.str();
-
-    // sender IP (14-17)
-    char ip_buf[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, data + 14, ip_buf, INET_ADDRSTRLEN);
-    m_packet.sender_ip = ip_buf;
-
-    // target MAC (18-23)
-    std::ostringstream target_mac;
-    target_mac << std::hex << std::setfill('0');
-    for (int i = 0; i < 6; ++i) {
-        if (i > 0)
-            target_mac << ":";
-        target_mac << std::setw(2) << static_cast<int>(data[18 + i]);
-    }
-    m_packet.target_mac = target_mac.str();
-
-    // target IP (24-27)
-    inet_ntop(AF_INET, data + 24, ip_buf, INET_ADDRSTRLEN);
-    m_packet.target_ip = ip_buf;
+    m_packet.sender_mac = MacAddress::from(data + 8);
+    m_packet.sender_ip = Ipv4Address::from(data + 14);
+    m_packet.target_mac = MacAddress::from(data + 18);
+    m_packet.target_ip = Ipv4Address::from(data + 24);
 
     return true;
 }
 
-void ArpParser::print() const {
-    std::cout << "  Hardware Type: " << m_packet.hw_type
-              << (m_packet.hw_type == 1 ? " (Ethernet)" : "") << "\n";
-    std::cout << "  Protocol Type: 0x" << std::hex << m_packet.proto_type << std::dec
-              << (m_packet.proto_type == ETH_P_IP ? " (IPv4)" : "") << "\n";
-    std::cout << "  Opcode: " << m_packet.opcode
-              << (m_packet.opcode == 1   ? " (Request)"
-                  : m_packet.opcode == 2 ? " (Reply)"
-                                         : " (Unknown)")
-              << "\n";
-    std::cout << "  Sender MAC: " << m_packet.sender_mac << "\n";
-    std::cout << "  Sender IP:  " << m_packet.sender_ip << "\n";
-    std::cout << "  Target MAC: " << m_packet.target_mac << "\n";
-    std::cout << "  Target IP:  " << m_packet.target_ip << "\n";
+void ArpParser::print(std::ostream& os) const {
+    os << "  Hardware Type: " << m_packet.hw_type << (m_packet.hw_type == 1 ? " (Ethernet)" : "")
+       << "\n";
+    os << "  Protocol Type: 0x" << std::hex << m_packet.proto_type << std::dec
+       << (m_packet.proto_type == ETH_P_IP ? " (IPv4)" : "") << "\n";
+    os << "  Opcode: " << m_packet.opcode
+       << (m_packet.opcode == 1   ? " (Request)"
+           : m_packet.opcode == 2 ? " (Reply)"
+                                  : " (Unknown)")
+       << "\n";
+    os << "  Sender MAC: " << m_packet.sender_mac << "\n";
+    os << "  Sender IP:  " << m_packet.sender_ip << "\n";
+    os << "  Target MAC: " << m_packet.target_mac << "\n";
+    os << "  Target IP:  " << m_packet.target_ip << "\n";
 }
@@ -1,9 +1,7 @@
 #include "parsers/L3/ipv4.hpp"
 
-#include <arpa/inet.h>
 #include <netinet/in.h>
 
-#include <cstring>
 #include <iostream>
 
 bool Ipv4Parser::parse(const uint8_t* data, size_t len) {
@@ -27,27 +25,21 @@ bool Ipv4Parser::parse(const uint8_t* data, size_t len) {
     m_packet.protocol = data[9];
     m_packet.checksum = (data[10] << 8) | data[11];
 
-    // src IP
-    char ip_buf[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, data + 12, ip_buf, INET_ADDRSTRLEN);
-    m_packet.src_ip = ip_buf;
-
-    // dst IP
-    inet_ntop(AF_INET, data + 16, ip_buf, INET_ADDRSTRLEN);
-    m_packet.dst_ip = ip_buf;
+    m_packet.src_ip = Ipv4Address::from(data + 12);
+    m_packet.dst_ip = Ipv4Address::from(data + 16);
 
     return true;
 }
 
-void Ipv4Parser::print() const {
-    std::cout << "  Version: " << static_cast<int>(m_packet.version) << "\n";
-    std::cout << "  Header Length: " << static_cast<int>(m_packet.header_length) << " bytes\n";
-    std::cout << "  Total Length: " << m_packet.total_length << " bytes\n";
-    std::cout << "  TTL: " << static_cast<int>(m_packet.ttl) << "\n";
-    std::cout << "  Protocol: " << static_cast<int>(m_packet.protocol) << " ("
-              << get_protocol_name(m_packet.protocol) << ")\n";
-    std::cout << "  Source IP: " << m_packet.src_ip << "\n";
-    std::cout << "  Destination IP: " << m_packet.dst_ip << "\n";
+void Ipv4Parser::print(std::ostream& os) const {
+    os << "  Version: " << static_cast<int>(m_packet.version) << "\n";
+    os << "  Header Length: " << static_cast<int>(m_packet.header_length) << " bytes\n";
+    os << "  Total Length: " << m_packet.total_length << " bytes\n";
+    os << "  TTL: " << static_cast<int>(m_packet.ttl) << "\n";
+    os << "  Protocol: " << static_cast<int>(m_packet.protocol) << " ("
+       << get_protocol_name(m_packet.protocol) << ")\n";
+    os << "  Source IP: " << m_packet.src_ip << "\n";
+    os << "  Destination IP: " << m_packet.dst_ip << "\n";
 }
 
 const char* Ipv4Parser::get_protocol_name(uint8_t protocol) const {
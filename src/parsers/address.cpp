@@ -0,0 +1,73 @@
+#include "parsers/address.hpp"
+
+#include <cstring>
+
+namespace {
+
+constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+}  // namespace
+
+MacAddress MacAddress::from(const uint8_t* data) {
+    MacAddress mac;
+    std::memcpy(mac.bytes.data(), data, mac.bytes.size());
+    return mac;
+}
+
+Ipv4Address Ipv4Address::from(const uint8_t* data) {
+    Ipv4Address ip;
+    std::memcpy(ip.bytes.data(), data, ip.bytes.size());
+    return ip;
+}
+
+size_t format_address(const MacAddress& mac, char (&out)[MAC_TEXT_LEN + 1]) {
+    size_t pos = 0;
+    for (size_t i = 0; i < mac.bytes.size(); ++i) {
+        if (i > 0) {
+            out[pos++] = ':';
+        }
+        out[pos++] = HEX_DIGITS[mac.bytes[i] >> 4];
+        out[pos++] = HEX_DIGITS[mac.bytes[i] & 0x0f];
+    }
+    out[pos] = '\0';
+    return pos;
+}
+
+size_t format_address(const Ipv4Address& ip, char (&out)[IPV4_TEXT_LEN + 1]) {
+    size_t pos = 0;
+    for (size_t i = 0; i < ip.bytes.size(); ++i) {
+        if (i > 0) {
+            out[pos++] = '.';
+        }
+        const unsigned value = ip.bytes[i];
+        if (value >= 100) {
+            out[pos++] = static_cast<char>('0' + value / 100);
+        }
+        if (value >= 10) {
+            out[pos++] = static_cast<char>('0' + value / 10 % 10);
+        }
+        out[pos++] = static_cast<char>('0' + value % 10);
+    }
+    out[pos] = '\0';
+    return pos;
+}
+
+std::ostream& operator<<(std::ostream& os, const MacAddress& mac) {
+    char text[MAC_TEXT_LEN + 1];
+    return os.write(text, static_cast<std::streamsize>(format_address(mac, text)));
+}
+
+std::ostream& operator<<(std::ostream& os, const Ipv4Address& ip) {
+    char text[IPV4_TEXT_LEN + 1];
+    return os.write(text, static_cast<std::streamsize>(format_address(ip, text)));
+}
+
+std::string to_string(const MacAddress& mac) {
+    char text[MAC_TEXT_LEN + 1];
+    return std::string(text, format_address(mac, text));
+}
+
+std::string to_string(const Ipv4Address& ip) {
+    char text[IPV4_TEXT_LEN + 1];
+    return std::string(text, format_address(ip, text));
+}
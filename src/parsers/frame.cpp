@@ -1,32 +1,12 @@
 #include "parsers/frame.hpp"
 
-#include <iomanip>
-#include <sstream>
-
 bool parse_ethernet_frame(const uint8_t* data, size_t len, EthernetFrame& frame) {
     if (!data || len < 14) {
         return false;
     }
 
-    // dst MAC
-    std::ostringstream dst_mac;
-    dst_mac << std::hex << std::setfill('0');
-    for (int i = 0; i < 6; ++i) {
-        if (i > 0)
-            dst_mac << ":";
-        dst_mac << std::setw(2) << static_cast<int>(data[i]);
-    }
-    frame.dst_mac = dst_mac.str();
-
-    // src MAC
-    std::ostringstream src_mac;
-    src_mac << std::hex << std::setfill('0');
-    for (int i = 0; i < 6; ++i) {
-        if (i > 0)
-            src_mac << ":";
-        src_mac << std::setw(2) << static_cast<int>(data[6 + i]);
-    }
-    frame.src_mac = src_mac.str();
+    frame.dst_mac = MacAddress::from(data);
+    frame.src_mac = MacAddress::from(data + 6);
 
     // EtherType
     frame.ethertype = (data[12] << 8) | data[13];
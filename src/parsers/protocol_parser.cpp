@@ -5,7 +5,8 @@
 #include "parsers/L2/arp.hpp"
 #include "parsers/L3/ipv4.hpp"
 
-std::unordered_map<uint16_t, std::unique_ptr<ProtocolParser>> ProtocolParser::s_parsers;
+thread_local std::unordered_map<uint16_t, std::unique_ptr<ProtocolParser>>
+    ProtocolParser::s_parsers;
 
 ProtocolParser* ProtocolParser::create_parser(uint16_t ethertype) {
     switch (ethertype) {
@@ -0,0 +1,182 @@
+#include "pipeline.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+#include "gso.hpp"
+#include "parsers/frame.hpp"
+#include "parsers/protocol_parser.hpp"
+
+namespace {
+
+std::mutex g_console_mutex;
+
+}  // namespace
+
+Pipeline::Pipeline(const CliOptions& opts, PacketWriter* writer, int worker_id)
+    : m_opts(opts), m_writer(writer), m_worker_id(worker_id) {}
+
+void Pipeline::print_hex_dump(const uint8_t* data, size_t len) {
+    m_out << "\n  HEX Dump:\n";
+    for (size_t i = 0; i < len; ++i) {
+        if (i % 16 == 0) {
+            if (i > 0)
+                m_out << "\n";
+            m_out << "  " << std::hex << std::setw(4) << std::setfill('0') << i << ":  ";
+        }
+        m_out << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(data[i]) << " ";
+    }
+    m_out << std::dec << "\n";
+}
+
+void Pipeline::flush_output() {
+    if (m_out.tellp() <= 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(g_console_mutex);
+    std::cout << m_out.str();
+    m_out.str(std::string());
+}
+
+void Pipeline::on_frame(const uint8_t* data, size_t len) {
+    PacketView packet;
+    packet.data = data;
+    packet.len = len;
+    on_batch(&packet, 1);
+}
+
+void Pipeline::on_batch(const PacketView* packets, size_t count) {
+    // clip the batch so a packet limit is honoured exactly
+    uint64_t remaining = UINT64_MAX;
+    if (m_packet_limit > 0) {
+        remaining = m_packet_limit - std::min(m_packet_limit, packet_count());
+    }
+
+    size_t accepted = 0;
+    while (accepted < count && remaining > 0) {
+        if (packets[accepted].len >= 14) {
+            --remaining;
+        }
+        ++accepted;
+    }
+
+    if (m_writer && m_writer->is_open()) {
+        // runt frames are not counted, so they are not exported either
+        size_t start = 0;
+        for (size_t i = 0; i < accepted; ++i) {
+            if (packets[i].len < 14) {
+                m_writer->write_packets(packets + start, i - start);
+                start = i + 1;
+            }
+        }
+        m_writer->write_packets(packets + start, accepted - start);
+    }
+
+    if (m_opts.record_only) {
+        // the frames counted here are exactly the ones exported above
+        uint64_t counted = 0;
+        for (size_t i = 0; i < accepted; ++i) {
+            counted += packets[i].len >= 14 ? 1 : 0;
+        }
+        m_packet_count.store(packet_count() + counted, std::memory_order_relaxed);
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        process(packets[i]);
+    }
+    flush_output();
+}
+
+void Pipeline::process(const PacketView& packet) {
+    const uint8_t* data = packet.data;
+    const size_t len = packet.len;
+
+    if (limit_reached()) {
+        return;
+    }
+
+    if (len < 14) {
+        if (m_opts.verbose) {
+            std::lock_guard<std::mutex> lock(g_console_mutex);
+            std::cerr << "[!] Frame too small: " << len << " bytes\n";
+        }
+        return;
+    }
+
+    uint64_t current_count = m_packet_count.load(std::memory_order_relaxed) + 1;
+    m_packet_count.store(current_count, std::memory_order_relaxed);
+
+    EthernetFrame frame;
+    if (!parse_ethernet_frame(data, len, frame)) {
+        if (m_opts.verbose) {
+            std::lock_guard<std::mutex> lock(g_console_mutex);
+            std::cerr << "[!] Failed to parse Ethernet frame\n";
+        }
+        return;
+    }
+
+    m_out << "\n[";
+    if (m_worker_id >= 0) {
+        m_out << "W" << m_worker_id << " ";
+    }
+    m_out << "Packet #" << current_count << "] ";
+    if (m_label_interfaces && packet.ifindex > 0) {
+        const std::string& name = m_interface_names.lookup(packet.ifindex);
+        if (!name.empty()) {
+            m_out << name << " | ";
+        } else {
+            m_out << "if" << packet.ifindex << " | ";
+        }
+    }
+    if (packet.direction != PacketDirection::Unknown) {
+        m_out << (packet.direction == PacketDirection::Outbound ? "out" : "in");
+        // unicast to the host and the host's own frames need no more than the direction
+        if (packet.type != PacketType::Unknown && packet.type != PacketType::Host &&
+            packet.type != PacketType::Outgoing) {
+            m_out << " " << packet_type_name(packet.type);
+        }
+        m_out << " | ";
+    }
+    m_out << len << " bytes";
+    if (packet.wire_len() > len) {
+        m_out << " of " << packet.wire_len();
+    }
+    if (packet.is_gso()) {
+        m_out << " (GSO " << gso_type_name(packet.gso.type) << ", " << packet.gso.size
+              << "-byte segments)";
+    }
+    m_out << " | " << frame.src_mac << " -> " << frame.dst_mac;
+    if (packet.has_vlan()) {
+        m_out << " | VLAN " << packet.vlan_id();
+    }
+    m_out << " | " << "EtherType: 0x"
+          << std::hex << std::setw(4) << std::setfill('0') << frame.ethertype << std::dec;
+
+    if (m_opts.show_parsed) {
+        ProtocolParser* parser = ProtocolParser::get_parser(frame.ethertype);
+
+        if (parser) {
+            m_out << " (" << parser->protocol_name() << ")\n";
+
+            if (parser->parse(frame.payload, frame.payload_len)) {
+                parser->print(m_out);
+            } else {
+                std::lock_guard<std::mutex> lock(g_console_mutex);
+                std::cerr << "[!] Failed to parse " << parser->protocol_name() << " packet\n";
+            }
+        } else {
+            m_out << " (Unknown)\n";
+        }
+    } else {
+        m_out << "\n";
+    }
+
+    if (m_opts.show_hex) {
+        print_hex_dump(data, len);
+    }
+}
@@ -0,0 +1,389 @@
+#include "replay.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
+
+#include "export/pcap.hpp"
+
+namespace {
+
+constexpr uint32_t PCAP_MAGIC_MICRO = 0xa1b2c3d4;
+constexpr uint32_t PCAP_MAGIC_NANO = 0xa1b23c4d;
+constexpr uint32_t PCAPNG_MAGIC = 0x0a0d0d0a;
+constexpr uint32_t LINKTYPE_ETHERNET = 1;
+
+// a frame's bytes start here in a TPACKET_V2 TX slot when PACKET_TX_HAS_OFF is not set
+constexpr size_t TX_DATA_OFFSET = TPACKET2_HDRLEN - sizeof(struct sockaddr_ll);
+
+// slots filled between two kicks of the kernel at top speed
+constexpr uint32_t KICK_BATCH = 64;
+
+// how long a full ring is waited on before the stop signal is checked again
+constexpr int POLL_TIMEOUT_MS = 100;
+
+// the last stretch before a paced frame is due is spun instead of slept
+constexpr uint64_t SPIN_NS = 200000;
+
+uint64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// returns early when the stop signal fires
+void wait_until(uint64_t due_ns, const StopSignal& stop) {
+    while (!stop.requested()) {
+        const uint64_t now = monotonic_ns();
+        if (now >= due_ns) {
+            return;
+        }
+        if (due_ns - now > SPIN_NS) {
+            stop.wait(static_cast<int>((due_ns - now - SPIN_NS) / 1000000));
+        }
+    }
+}
+
+}  // namespace
+
+PcapReader::~PcapReader() {
+    close();
+}
+
+bool PcapReader::open(const std::string& filename) {
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "[!] Failed to open " << filename << ": " << strerror(errno) << "\n";
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(PcapGlobalHeader)) {
+        std::cerr << "[!] " << filename << " is not a PCAP file\n";
+        ::close(fd);
+        return false;
+    }
+
+    void* map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "[!] mmap() of " << filename << " failed: " << strerror(errno) << "\n";
+        return false;
+    }
+    m_map = static_cast<uint8_t*>(map);
+    m_map_size = static_cast<size_t>(st.st_size);
+    madvise(m_map, m_map_size, MADV_SEQUENTIAL);
+
+    PcapGlobalHeader header;
+    std::memcpy(&header, m_map, sizeof(header));
+
+    const bool swapped = header.magic_number == __builtin_bswap32(PCAP_MAGIC_MICRO) ||
+                         header.magic_number == __builtin_bswap32(PCAP_MAGIC_NANO);
+    const uint32_t magic = swapped ? __builtin_bswap32(header.magic_number) : header.magic_number;
+    auto field = [swapped](uint32_t value) { return swapped ? __builtin_bswap32(value) : value; };
+
+    if (magic == PCAPNG_MAGIC) {
+        std::cerr << "[!] " << filename << " is a pcapng file, replay reads classic PCAP only\n";
+        close();
+        return false;
+    }
+    if (magic != PCAP_MAGIC_MICRO && magic != PCAP_MAGIC_NANO) {
+        std::cerr << "[!] " << filename << " is not a PCAP file\n";
+        close();
+        return false;
+    }
+    if (field(header.network) != LINKTYPE_ETHERNET) {
+        std::cerr << "[!] " << filename << " has link type " << field(header.network)
+                  << ", only Ethernet captures can be replayed\n";
+        close();
+        return false;
+    }
+
+    const uint64_t fraction_ns = magic == PCAP_MAGIC_NANO ? 1 : 1000;
+    size_t offset = sizeof(PcapGlobalHeader);
+    while (offset + sizeof(PcapPacketHeader) <= m_map_size) {
+        PcapPacketHeader record;
+        std::memcpy(&record, m_map + offset, sizeof(record));
+        offset += sizeof(record);
+
+        const size_t incl_len = field(record.incl_len);
+        if (incl_len > m_map_size - offset) {
+            std::cerr << "[!] Warning: " << filename << " ends inside a record, "
+                      << m_frames.size() << " frames read\n";
+            break;
+        }
+
+        PacketView frame;
+        frame.data = m_map + offset;
+        frame.len = incl_len;
+        frame.ts_ns = static_cast<uint64_t>(field(record.ts_sec)) * 1000000000ULL +
+                      static_cast<uint64_t>(field(record.ts_usec)) * fraction_ns;
+        frame.orig_len = field(record.orig_len);
+        m_frames.push_back(frame);
+        offset += incl_len;
+    }
+
+    return true;
+}
+
+void PcapReader::close() {
+    if (m_map != nullptr) {
+        munmap(m_map, m_map_size);
+        m_map = nullptr;
+        m_map_size = 0;
+    }
+    m_frames.clear();
+}
+
+bool parse_replay_speed(const std::string& text, double& speed) {
+    if (text == "max") {
+        speed = 0.0;
+        return true;
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    const double value = std::strtod(text.c_str(), &end);
+    if (text.empty() || errno != 0 || end != text.c_str() + text.size() || !(value > 0.0) ||
+        value > 1e6) {
+        return false;
+    }
+    speed = value;
+    return true;
+}
+
+PacketReplayer::~PacketReplayer() {
+    close();
+}
+
+bool PacketReplayer::open(const std::string& iface, const ReplayConfig& config) {
+    close();
+    m_speed = config.speed;
+
+    // protocol 0: the socket only transmits, nothing is queued to it for reading
+    m_fd = socket(AF_PACKET, SOCK_RAW, 0);
+    if (m_fd < 0) {
+        std::cerr << "[!] socket(AF_PACKET) failed: " << strerror(errno) << "\n";
+        return false;
+    }
+
+    struct ifreq ifr;
+    std::memset(&ifr, 0, sizeof(ifr));
+    std::strncpy(ifr.ifr_name, iface.c_str(), IFNAMSIZ - 1);
+    if (ioctl(m_fd, SIOCGIFINDEX, &ifr) < 0) {
+        std::cerr << "[!] ioctl(SIOCGIFINDEX) failed for " << iface << ": " << strerror(errno)
+                  << "\n";
+        close();
+        return false;
+    }
+    const int ifindex = ifr.ifr_ifindex;
+
+    if (ioctl(m_fd, SIOCGIFMTU, &ifr) < 0) {
+        std::cerr << "[!] ioctl(SIOCGIFMTU) failed for " << iface << ": " << strerror(errno)
+                  << "\n";
+        close();
+        return false;
+    }
+    // the kernel's own limit for SOCK_RAW: MTU plus the link header and one VLAN tag
+    const size_t max_len = static_cast<size_t>(ifr.ifr_mtu) + ETH_HLEN + 4;
+
+    int version = TPACKET_V2;
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        std::cerr << "[!] setsockopt(PACKET_VERSION) failed: " << strerror(errno) << "\n";
+        close();
+        return false;
+    }
+
+    // a slot the kernel rejects is skipped instead of stalling the ring
+    int enable = 1;
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_LOSS, &enable, sizeof(enable)) < 0) {
+        std::cerr << "[!] Warning: failed to set PACKET_LOSS: " << strerror(errno) << "\n";
+    }
+    if (config.qdisc_bypass &&
+        setsockopt(m_fd, SOL_PACKET, PACKET_QDISC_BYPASS, &enable, sizeof(enable)) < 0) {
+        std::cerr << "[!] Warning: failed to set PACKET_QDISC_BYPASS: " << strerror(errno)
+                  << "\n";
+    }
+
+    if (!setup_ring(max_len, config.frame_count > 0 ? config.frame_count : 1)) {
+        close();
+        return false;
+    }
+
+    struct sockaddr_ll sll;
+    std::memset(&sll, 0, sizeof(sll));
+    sll.sll_family = AF_PACKET;
+    sll.sll_ifindex = ifindex;
+    if (bind(m_fd, reinterpret_cast<struct sockaddr*>(&sll), sizeof(sll)) < 0) {
+        std::cerr << "[!] bind() failed: " << strerror(errno) << "\n";
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool PacketReplayer::setup_ring(size_t max_len, uint32_t frame_count) {
+    // power-of-two slots keep them dividing the block; one block holds at least one slot
+    uint32_t frame_size = 2048;
+    while (frame_size < TX_DATA_OFFSET + max_len) {
+        frame_size <<= 1;
+    }
+    const auto page_size = static_cast<uint32_t>(sysconf(_SC_PAGESIZE));
+    const uint32_t block_size = frame_size > page_size ? frame_size : page_size;
+    const uint32_t frames_per_block = block_size / frame_size;
+
+    struct tpacket_req req;
+    std::memset(&req, 0, sizeof(req));
+    req.tp_block_size = block_size;
+    req.tp_block_nr = (frame_count + frames_per_block - 1) / frames_per_block;
+    req.tp_frame_size = frame_size;
+    req.tp_frame_nr = req.tp_block_nr * frames_per_block;
+
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_TX_RING, &req, sizeof(req)) < 0) {
+        std::cerr << "[!] setsockopt(PACKET_TX_RING) failed: " << strerror(errno) << "\n";
+        return false;
+    }
+
+    const size_t ring_size = static_cast<size_t>(req.tp_block_size) * req.tp_block_nr;
+    void* mem = mmap(nullptr, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (mem == MAP_FAILED) {
+        std::cerr << "[!] mmap() of TX ring failed: " << strerror(errno) << "\n";
+        return false;
+    }
+
+    m_ring = static_cast<uint8_t*>(mem);
+    m_ring_size = ring_size;
+    m_frame_size = frame_size;
+    m_frame_count = req.tp_frame_nr;
+    m_slot = 0;
+    m_max_len = max_len;
+    return true;
+}
+
+bool PacketReplayer::replay(const PacketView* frames, size_t count, const StopSignal& stop) {
+    if (m_fd < 0) {
+        throw std::runtime_error("Replay socket not opened. Call open() first.");
+    }
+
+    m_stats = ReplayStats();
+    m_failed = false;
+    const uint64_t start = monotonic_ns();
+    const uint64_t first_ts = count > 0 ? frames[0].ts_ns : 0;
+    uint32_t queued = 0;
+
+    for (size_t i = 0; i < count && !m_failed && !stop.requested(); ++i) {
+        const PacketView& frame = frames[i];
+        if (frame.len < ETH_HLEN || frame.len > m_max_len) {
+            ++m_stats.skipped;
+            continue;
+        }
+
+        if (m_speed > 0 && frame.ts_ns > first_ts) {
+            const uint64_t due =
+                start + static_cast<uint64_t>(static_cast<double>(frame.ts_ns - first_ts) /
+                                              m_speed);
+            if (monotonic_ns() < due) {
+                // what is queued leaves now rather than after the gap
+                if (queued > 0) {
+                    kick(false);
+                    queued = 0;
+                }
+                wait_until(due, stop);
+                if (stop.requested()) {
+                    break;
+                }
+            }
+        }
+
+        uint8_t* slot = next_slot(stop);
+        if (slot == nullptr) {
+            break;
+        }
+        std::memcpy(slot + TX_DATA_OFFSET, frame.data, frame.len);
+        auto* hdr = reinterpret_cast<struct tpacket2_hdr*>(slot);
+        hdr->tp_len = static_cast<uint32_t>(frame.len);
+        // the kernel may pick the slot up as soon as the status flips, so the data goes first
+        __atomic_store_n(&hdr->tp_status, TP_STATUS_SEND_REQUEST, __ATOMIC_RELEASE);
+        m_slot = m_slot + 1 == m_frame_count ? 0 : m_slot + 1;
+
+        ++m_stats.frames;
+        m_stats.bytes += frame.len;
+        if (++queued == KICK_BATCH) {
+            kick(false);
+            queued = 0;
+        }
+    }
+
+    // blocks until every queued slot is sent, so the rate covers the last frames too
+    kick(true);
+    m_stats.elapsed_ns = monotonic_ns() - start;
+    return !m_failed;
+}
+
+uint8_t* PacketReplayer::next_slot(const StopSignal& stop) {
+    uint8_t* slot = m_ring + static_cast<size_t>(m_slot) * m_frame_size;
+    auto* hdr = reinterpret_cast<struct tpacket2_hdr*>(slot);
+
+    while (true) {
+        const uint32_t status = __atomic_load_n(&hdr->tp_status, __ATOMIC_ACQUIRE);
+        if (status == TP_STATUS_AVAILABLE || status == TP_STATUS_WRONG_FORMAT) {
+            return slot;
+        }
+        if (stop.requested() || !kick(false)) {
+            return nullptr;
+        }
+
+        // the ring is full; the kernel frees slots as the device completes them
+        struct pollfd pfds[2];
+        std::memset(pfds, 0, sizeof(pfds));
+        pfds[0].fd = m_fd;
+        pfds[0].events = POLLOUT;
+        pfds[1].fd = stop.fd();
+        pfds[1].events = POLLIN;
+        if (poll(pfds, 2, stop.timeout_ms(POLL_TIMEOUT_MS)) < 0 && errno != EINTR) {
+            std::cerr << "[!] poll() on the TX ring failed: " << strerror(errno) << "\n";
+            m_failed = true;
+            return nullptr;
+        }
+    }
+}
+
+bool PacketReplayer::kick(bool wait) {
+    if (send(m_fd, nullptr, 0, wait ? 0 : MSG_DONTWAIT) < 0 && errno != EAGAIN &&
+        errno != ENOBUFS && errno != EINTR) {
+        std::cerr << "[!] send() on the TX ring failed: " << strerror(errno) << "\n";
+        m_failed = true;
+        return false;
+    }
+    return true;
+}
+
+void PacketReplayer::close() {
+    if (m_ring != nullptr) {
+        munmap(m_ring, m_ring_size);
+        m_ring = nullptr;
+        m_ring_size = 0;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
@@ -0,0 +1,148 @@
+#include "shed.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+const char* shed_level_name(ShedLevel level) {
+    switch (level) {
+        case ShedLevel::None:
+            return "none";
+        case ShedLevel::Headers:
+            return "headers";
+        case ShedLevel::Sample:
+            return "sample";
+        case ShedLevel::Drop:
+            return "drop";
+    }
+    return "unknown";
+}
+
+std::string describe_shed_interval(const ShedInterval& interval) {
+    std::ostringstream out;
+    switch (interval.level) {
+        case ShedLevel::None:
+            out << "full frames";
+            break;
+        case ShedLevel::Headers:
+            out << "frames cut to " << interval.header_bytes << " bytes";
+            break;
+        case ShedLevel::Sample:
+            out << "frames cut to " << interval.header_bytes << " bytes, 1 in "
+                << interval.sample_rate << " kept";
+            break;
+        case ShedLevel::Drop:
+            out << "all frames dropped";
+            break;
+    }
+    if (interval.end_ns >= interval.start_ns && interval.end_ns > 0) {
+        out << ", " << std::fixed << std::setprecision(2)
+            << static_cast<double>(interval.end_ns - interval.start_ns) / 1e9 << " s";
+    }
+    out << ": " << interval.frames << " frames, " << interval.cut << " cut, " << interval.skipped
+        << " skipped, " << static_cast<int>(interval.peak_fill * 100) << "% full";
+    return out.str();
+}
+
+LoadShedder::LoadShedder(const LoadShedConfig& config) : m_config(config) {
+    if (m_config.sample_rate == 0) {
+        m_config.sample_rate = 1;
+    }
+}
+
+ShedLevel LoadShedder::level_for(double fill) const {
+    if (fill >= m_config.drop_at) {
+        return ShedLevel::Drop;
+    }
+    if (fill >= m_config.sample_at) {
+        return ShedLevel::Sample;
+    }
+    if (fill >= m_config.headers_at) {
+        return ShedLevel::Headers;
+    }
+    return ShedLevel::None;
+}
+
+void LoadShedder::enter(ShedLevel level, uint64_t now_ns) {
+    if (m_current.level != ShedLevel::None) {
+        m_current.end_ns = now_ns;
+        m_finished.push_back(m_current);
+    }
+    m_current = ShedInterval();
+    m_current.level = level;
+    m_current.header_bytes = m_config.header_bytes;
+    m_current.sample_rate = m_config.sample_rate;
+    m_current.start_ns = now_ns;
+    m_level = level;
+    m_calm_since = 0;
+}
+
+bool LoadShedder::update(double fill, uint64_t now_ns) {
+    const ShedLevel target = level_for(fill);
+    if (target > m_level) {
+        enter(target, now_ns);
+        m_current.peak_fill = fill;
+        return true;
+    }
+    if (m_level == ShedLevel::None) {
+        return false;
+    }
+
+    m_current.peak_fill = std::max(m_current.peak_fill, fill);
+    if (target == m_level) {
+        m_calm_since = 0;
+        return false;
+    }
+    if (m_calm_since == 0) {
+        m_calm_since = now_ns;
+        return false;
+    }
+    if (now_ns - m_calm_since < static_cast<uint64_t>(m_config.recover_ms) * 1000000) {
+        return false;
+    }
+    enter(static_cast<ShedLevel>(static_cast<uint8_t>(m_level) - 1), now_ns);
+    return true;
+}
+
+size_t LoadShedder::apply(PacketView* packets, size_t count) {
+    if (m_level == ShedLevel::None) {
+        return count;
+    }
+
+    m_current.frames += count;
+    if (m_level == ShedLevel::Drop) {
+        m_current.skipped += count;
+        m_total_skipped += count;
+        return 0;
+    }
+
+    size_t kept = 0;
+    uint64_t cut = 0;
+    for (size_t i = 0; i < count; ++i) {
+        // the first frame of every sample_rate is kept, the phase runs on across batches
+        if (m_level == ShedLevel::Sample) {
+            const bool keep = m_sample_phase == 0;
+            m_sample_phase = m_sample_phase + 1 == m_config.sample_rate ? 0 : m_sample_phase + 1;
+            if (!keep) {
+                continue;
+            }
+        }
+
+        PacketView& packet = packets[i];
+        if (packet.len > m_config.header_bytes) {
+            packet.orig_len = packet.wire_len();
+            packet.len = m_config.header_bytes;
+            ++cut;
+        }
+        if (kept != i) {
+            packets[kept] = packet;
+        }
+        ++kept;
+    }
+
+    m_current.cut += cut;
+    m_current.skipped += count - kept;
+    m_total_cut += cut;
+    m_total_skipped += count - kept;
+    return kept;
+}
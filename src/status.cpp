@@ -0,0 +1,81 @@
+#include "status.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+std::string format_capture_stats(const CaptureStats& stats) {
+    std::ostringstream out;
+    out << stats.packets << " received, " << stats.drops << " dropped (" << std::fixed
+        << std::setprecision(2) << stats.drop_rate() * 100.0 << "%)";
+    if (stats.freezes > 0) {
+        out << ", " << stats.freezes << " ring freezes";
+    }
+    if (stats.cut > 0 || stats.shed > 0) {
+        out << ", " << stats.cut << " cut to headers, " << stats.shed << " shed";
+    }
+    return out.str();
+}
+
+CaptureStats poll_capture_stats(const std::vector<PacketCapturer*>& capturers) {
+    CaptureStats total;
+    for (PacketCapturer* capturer : capturers) {
+        total += capturer->poll_stats();
+    }
+    return total;
+}
+
+StatusReporter::StatusReporter(std::vector<PacketCapturer*> capturers,
+                               std::function<uint64_t()> captured, int interval_s,
+                               std::ostream& out)
+    : m_capturers(std::move(capturers)), m_captured(std::move(captured)), m_out(out) {
+    if (interval_s > 0) {
+        m_thread = std::thread([this, interval_s]() { run(interval_s); });
+    }
+}
+
+StatusReporter::~StatusReporter() {
+    stop();
+}
+
+void StatusReporter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_wakeup.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void StatusReporter::run(int interval_s) {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const auto interval = std::chrono::seconds(interval_s);
+    auto next = start + interval;
+    uint64_t last_captured = 0;
+
+    while (true) {
+        // ticks stay on the start + n * interval grid; stop() cuts the wait short
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_wakeup.wait_until(lock, next, [this]() { return !m_running; })) {
+                return;
+            }
+        }
+        next += interval;
+
+        const CaptureStats stats = poll_capture_stats(m_capturers);
+        const uint64_t captured = m_captured();
+        const auto elapsed =
+            std::chrono::duration_cast<std::chrono::seconds>(Clock::now() - start).count();
+
+        std::ostringstream line;
+        line << "[*] " << elapsed << " s: " << captured << " captured ("
+             << (captured - last_captured) / static_cast<uint64_t>(interval_s) << "/s), kernel "
+             << format_capture_stats(stats) << "\n";
+        m_out << line.str() << std::flush;
+        last_captured = captured;
+    }
+}
@@ -0,0 +1,86 @@
+#include "stop_signal.hpp"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <ctime>
+
+namespace {
+
+uint64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+}  // namespace
+
+StopSignal::StopSignal() : m_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {}
+
+StopSignal::~StopSignal() {
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+}
+
+void StopSignal::request() {
+    m_requested.store(true);
+    if (m_fd >= 0) {
+        // the counter is never read back, so it stays readable for every poller
+        const uint64_t one = 1;
+        ssize_t written = write(m_fd, &one, sizeof(one));
+        (void) written;
+    }
+}
+
+bool StopSignal::requested() const {
+    if (m_requested.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    const uint64_t deadline = m_deadline_ns.load(std::memory_order_relaxed);
+    return deadline != 0 && monotonic_ns() >= deadline;
+}
+
+void StopSignal::set_deadline_in(uint64_t duration_ms) {
+    m_deadline_ns.store(duration_ms > 0 ? monotonic_ns() + duration_ms * 1000000ULL : 0);
+}
+
+int StopSignal::timeout_ms(int max_ms) const {
+    if (m_requested.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+    const uint64_t deadline = m_deadline_ns.load(std::memory_order_relaxed);
+    if (deadline == 0) {
+        return max_ms;
+    }
+
+    const uint64_t now = monotonic_ns();
+    if (now >= deadline) {
+        return 0;
+    }
+    const uint64_t left_ms = (deadline - now + 999999) / 1000000;
+    return left_ms < static_cast<uint64_t>(max_ms) ? static_cast<int>(left_ms) : max_ms;
+}
+
+bool StopSignal::wait(int max_ms) const {
+    struct pollfd pfd;
+    std::memset(&pfd, 0, sizeof(pfd));
+    pfd.fd = m_fd;
+    pfd.events = POLLIN;
+
+    // a negative fd is skipped by poll(), which then just sleeps out the timeout
+    poll(&pfd, 1, timeout_ms(max_ms));
+    return requested();
+}
+
+void StopSignal::reset() {
+    m_requested.store(false);
+    m_deadline_ns.store(0);
+    if (m_fd >= 0) {
+        uint64_t value;
+        ssize_t drained = read(m_fd, &value, sizeof(value));
+        (void) drained;
+    }
+}
@@ -0,0 +1,197 @@
+#include "tsc_clock.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace {
+
+// clock readings bracketed by two counter reads; the narrowest bracket wins
+constexpr int PAIR_TRIES = 8;
+
+// time between the two readings the first rate is measured over
+constexpr auto CALIBRATION_SPAN = std::chrono::milliseconds(20);
+
+// a resync whose rate is further off than this saw the clock being stepped, not drift; it keeps
+// the rate it had
+constexpr uint64_t MAX_RATE_CHANGE_PPM = 1000;
+
+// how much faster or slower than the counter's rate a resync lets the clock run to catch up
+// with CLOCK_REALTIME, the bound adjtime() slews at
+constexpr uint64_t MAX_SLEW_PPM = 500;
+
+// an offset past this is the system clock being set rather than drift, ntpd's step threshold;
+// the clock follows it at once, as kernel timestamps do
+constexpr int64_t STEP_THRESHOLD_NS = 128000000;
+
+struct ClockPair {
+    uint64_t ticks = 0;
+    uint64_t ns = 0;
+};
+
+// serializes calibration and resyncs; last is the reading the next rate is measured from,
+// rate the counter's measured rate, which the published one only differs from while slewing
+std::mutex g_update_mutex;
+ClockPair g_last;
+uint64_t g_rate = 0;
+
+bool has_invariant_counter() {
+#if defined(__x86_64__) || defined(__i386__)
+    // CPUID.80000007H:EDX[8], the TSC runs at a constant rate through P-, C- and T-states
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+    return __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) != 0 && (edx & (1U << 8)) != 0;
+#elif defined(__aarch64__)
+    // the generic timer counts at a fixed frequency by definition
+    return true;
+#else
+    return false;
+#endif
+}
+
+ClockPair read_pair() {
+    ClockPair best;
+    uint64_t best_window = std::numeric_limits<uint64_t>::max();
+    for (int i = 0; i < PAIR_TRIES; ++i) {
+        const uint64_t start = tsc_detail::ticks();
+        const uint64_t ns = tsc_detail::realtime_ns();
+        const uint64_t end = tsc_detail::ticks();
+        if (end - start < best_window) {
+            best_window = end - start;
+            best.ticks = start + (end - start) / 2;
+            best.ns = ns;
+        }
+    }
+    return best;
+}
+
+// nanoseconds per tick in 32.32 fixed point, 0 if the readings do not move forward together
+uint64_t rate_between(const ClockPair& from, const ClockPair& to) {
+    if (to.ticks <= from.ticks || to.ns <= from.ns) {
+        return 0;
+    }
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(to.ns - from.ns) << 32) /
+                                 (to.ticks - from.ticks));
+}
+
+// the published clock's reading at ticks, to be called by the only writer
+uint64_t published_ns(uint64_t ticks) {
+    using namespace tsc_detail;
+    const auto delta = static_cast<int64_t>(ticks - base_ticks.load(std::memory_order_relaxed));
+    const auto rate = static_cast<__int128>(mult.load(std::memory_order_relaxed));
+    return base_ns.load(std::memory_order_relaxed) +
+           static_cast<uint64_t>(static_cast<int64_t>((delta * rate) >> 32));
+}
+
+void publish(const ClockPair& base, uint64_t rate) {
+    using namespace tsc_detail;
+    const uint32_t before = seq.load(std::memory_order_relaxed);
+    seq.store(before + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    base_ticks.store(base.ticks, std::memory_order_relaxed);
+    base_ns.store(base.ns, std::memory_order_relaxed);
+    mult.store(rate, std::memory_order_relaxed);
+    seq.store(before + 2, std::memory_order_release);
+}
+
+}  // namespace
+
+bool calibrate_tsc_clock() {
+    if (!has_invariant_counter()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(g_update_mutex);
+    const ClockPair first = read_pair();
+    std::this_thread::sleep_for(CALIBRATION_SPAN);
+    const ClockPair second = read_pair();
+
+    const uint64_t rate = rate_between(first, second);
+    if (rate == 0) {
+        return false;
+    }
+    publish(second, rate);
+    g_last = second;
+    g_rate = rate;
+    return true;
+}
+
+void resync_tsc_clock() {
+    std::lock_guard<std::mutex> lock(g_update_mutex);
+    const uint64_t current = tsc_detail::mult.load(std::memory_order_relaxed);
+    if (current == 0) {
+        return;
+    }
+
+    const ClockPair now = read_pair();
+    const uint64_t measured = rate_between(g_last, now);
+    const uint64_t change = measured > g_rate ? measured - g_rate : g_rate - measured;
+    if (measured != 0 && change <= g_rate / 1000000 * MAX_RATE_CHANGE_PPM) {
+        g_rate = measured;
+    }
+
+    // a new base taken straight from CLOCK_REALTIME would step the clock, backwards as often as
+    // not; instead it continues from where it is and runs faster or slower until the offset
+    // is made up over the next interval
+    const uint64_t continued = published_ns(now.ticks);
+    const auto offset = static_cast<int64_t>(now.ns - continued);
+    if (offset > STEP_THRESHOLD_NS || offset < -STEP_THRESHOLD_NS) {
+        publish(now, g_rate);
+        g_last = now;
+        return;
+    }
+
+    const auto interval = static_cast<__int128>(now.ticks - g_last.ticks);
+    const auto max_slew = static_cast<__int128>(g_rate / 1000000 * MAX_SLEW_PPM);
+    __int128 slew = interval > 0 ? (static_cast<__int128>(offset) << 32) / interval : 0;
+    slew = std::max(-max_slew, std::min(slew, max_slew));
+    publish({now.ticks, continued}, static_cast<uint64_t>(static_cast<__int128>(g_rate) + slew));
+    g_last = now;
+}
+
+bool tsc_clock_active() {
+    return tsc_detail::mult.load(std::memory_order_relaxed) != 0;
+}
+
+uint64_t tsc_clock_hz() {
+    const uint64_t rate = tsc_detail::mult.load(std::memory_order_relaxed);
+    if (rate == 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(1000000000ULL) << 32) / rate);
+}
+
+TscResync::TscResync(int interval_ms) {
+    if (interval_ms > 0) {
+        m_thread = std::thread([this, interval_ms]() { run(interval_ms); });
+    }
+}
+
+TscResync::~TscResync() {
+    stop();
+}
+
+void TscResync::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_wakeup.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void TscResync::run(int interval_ms) {
+    const auto interval = std::chrono::milliseconds(interval_ms);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_wakeup.wait_for(lock, interval, [this]() { return !m_running; })) {
+        resync_tsc_clock();
+    }
+}
@@ -0,0 +1,385 @@
+#include "xdp.hpp"
+
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+#include "tsc_clock.hpp"
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+XdpSocket::~XdpSocket() {
+    close();
+}
+
+namespace {
+
+int sys_bpf(int cmd, union bpf_attr* attr) {
+    return static_cast<int>(syscall(__NR_bpf, cmd, attr, sizeof(*attr)));
+}
+
+struct bpf_insn make_insn(uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm) {
+    struct bpf_insn insn;
+    std::memset(&insn, 0, sizeof(insn));
+    insn.code = code;
+    insn.dst_reg = dst & 0xf;
+    insn.src_reg = src & 0xf;
+    insn.off = off;
+    insn.imm = imm;
+    return insn;
+}
+
+bool is_power_of_two(uint32_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+}  // namespace
+
+bool parse_xdp_bind_mode(const std::string& name, XdpBindMode& mode) {
+    if (name == "auto") {
+        mode = XdpBindMode::Auto;
+    } else if (name == "copy") {
+        mode = XdpBindMode::Copy;
+    } else if (name == "zerocopy") {
+        mode = XdpBindMode::ZeroCopy;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool XdpSocket::open(int ifindex, const XdpConfig& config) {
+    const long page_size = sysconf(_SC_PAGESIZE);
+    if (!is_power_of_two(config.frame_size) || config.frame_size < 2048 ||
+        config.frame_size > static_cast<uint32_t>(page_size) ||
+        !is_power_of_two(config.frame_count)) {
+        std::cerr << "[!] Invalid AF_XDP geometry: frame size must be a power of two between 2048 "
+                  << "and " << page_size << " bytes and the frame count a power of two\n";
+        return false;
+    }
+    m_config = config;
+
+    if (!attach_program(ifindex)) {
+        close();
+        return false;
+    }
+
+    bool bound = false;
+    if (config.bind != XdpBindMode::Copy) {
+        bound = create_socket(ifindex, XDP_ZEROCOPY);
+        if (bound) {
+            m_zero_copy = true;
+        } else if (config.bind == XdpBindMode::ZeroCopy) {
+            close();
+            return false;
+        }
+    }
+    if (!bound && !create_socket(ifindex, XDP_COPY)) {
+        close();
+        return false;
+    }
+
+    // frames of this queue are redirected only once the socket is in the map
+    union bpf_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    uint32_t key = config.queue_id;
+    uint32_t value = static_cast<uint32_t>(m_fd);
+    attr.map_fd = static_cast<uint32_t>(m_map_fd);
+    attr.key = reinterpret_cast<uint64_t>(&key);
+    attr.value = reinterpret_cast<uint64_t>(&value);
+    attr.flags = BPF_ANY;
+
+    if (sys_bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0) {
+        std::cerr << "[!] Failed to insert AF_XDP socket into XSKMAP: " << strerror(errno) << "\n";
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool XdpSocket::attach_program(int ifindex) {
+    union bpf_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = sizeof(uint32_t);
+    attr.max_entries = m_config.queue_id + 1;
+
+    m_map_fd = sys_bpf(BPF_MAP_CREATE, &attr);
+    if (m_map_fd < 0) {
+        std::cerr << "[!] bpf(BPF_MAP_CREATE) for XSKMAP failed: " << strerror(errno) << "\n";
+        return false;
+    }
+
+    // return bpf_redirect_map(&xsks, ctx->rx_queue_index, XDP_PASS);
+    // the flags argument is the action for queues without a socket, so other traffic still
+    // reaches the stack
+    struct bpf_insn program[] = {
+        make_insn(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_1,
+                  offsetof(struct xdp_md, rx_queue_index), 0),
+        make_insn(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, m_map_fd),
+        make_insn(0, 0, 0, 0, 0),
+        make_insn(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS),
+        make_insn(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map),
+        make_insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0),
+    };
+    static const char license[] = "Dual MIT/GPL";
+    char log[4096] = {0};
+
+    std::memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.expected_attach_type = BPF_XDP;
+    attr.insns = reinterpret_cast<uint64_t>(program);
+    attr.insn_cnt = sizeof(program) / sizeof(program[0]);
+    attr.license = reinterpret_cast<uint64_t>(license);
+    attr.log_buf = reinterpret_cast<uint64_t>(log);
+    attr.log_size = sizeof(log);
+    attr.log_level = 1;
+
+    m_prog_fd = sys_bpf(BPF_PROG_LOAD, &attr);
+    if (m_prog_fd < 0) {
+        std::cerr << "[!] bpf(BPF_PROG_LOAD) of XDP redirect program failed: " << strerror(errno)
+                  << "\n";
+        if (log[0] != '\0') {
+            std::cerr << log;
+        }
+        return false;
+    }
+
+    // a link detaches the program by itself when the descriptor is closed, even on a crash
+    for (uint32_t flags : {XDP_FLAGS_DRV_MODE, XDP_FLAGS_SKB_MODE}) {
+        if (flags == XDP_FLAGS_DRV_MODE && m_config.generic) {
+            continue;
+        }
+
+        std::memset(&attr, 0, sizeof(attr));
+        attr.link_create.prog_fd = static_cast<uint32_t>(m_prog_fd);
+        attr.link_create.target_ifindex = static_cast<uint32_t>(ifindex);
+        attr.link_create.attach_type = BPF_XDP;
+        attr.link_create.flags = flags;
+
+        m_link_fd = sys_bpf(BPF_LINK_CREATE, &attr);
+        if (m_link_fd >= 0) {
+            m_generic = flags == XDP_FLAGS_SKB_MODE;
+            return true;
+        }
+
+        if (flags == XDP_FLAGS_DRV_MODE) {
+            std::cerr << "[!] Warning: native XDP unavailable (" << strerror(errno)
+                      << "), using generic mode\n";
+        }
+    }
+
+    std::cerr << "[!] Failed to attach XDP program: " << strerror(errno) << "\n";
+    return false;
+}
+
+bool XdpSocket::map_ring(Ring& ring, uint64_t pgoff, const struct xdp_ring_offset& offsets,
+                         size_t entry_size, uint32_t entries) {
+    size_t size = offsets.desc + entry_size * entries;
+    void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+                     static_cast<off_t>(pgoff));
+    if (mem == MAP_FAILED) {
+        std::cerr << "[!] mmap() of AF_XDP ring failed: " << strerror(errno) << "\n";
+        return false;
+    }
+
+    auto* base = static_cast<uint8_t*>(mem);
+    ring.producer = reinterpret_cast<uint32_t*>(base + offsets.producer);
+    ring.consumer = reinterpret_cast<uint32_t*>(base + offsets.consumer);
+    ring.flags = reinterpret_cast<uint32_t*>(base + offsets.flags);
+    ring.descs = base + offsets.desc;
+    ring.mask = entries - 1;
+    ring.map = mem;
+    ring.map_size = size;
+    return true;
+}
+
+bool XdpSocket::create_socket(int ifindex, uint16_t bind_flags) {
+    m_fd = socket(AF_XDP, SOCK_RAW, 0);
+    if (m_fd < 0) {
+        std::cerr << "[!] socket(AF_XDP) failed: " << strerror(errno) << "\n";
+        return false;
+    }
+
+    const uint32_t frames = m_config.frame_count;
+    if (!m_umem.allocate(static_cast<size_t>(m_config.frame_size) * frames,
+                         m_config.huge_pages)) {
+        destroy_socket();
+        return false;
+    }
+
+    struct xdp_umem_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.addr = reinterpret_cast<uint64_t>(m_umem.data());
+    reg.len = m_umem.size();
+    reg.chunk_size = m_config.frame_size;
+
+    if (setsockopt(m_fd, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) < 0) {
+        std::cerr << "[!] setsockopt(XDP_UMEM_REG) failed: " << strerror(errno) << "\n";
+        destroy_socket();
+        return false;
+    }
+
+    // capture never transmits, but the kernel refuses to bind a UMEM without a completion ring
+    if (setsockopt(m_fd, SOL_XDP, XDP_UMEM_FILL_RING, &frames, sizeof(frames)) < 0 ||
+        setsockopt(m_fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &frames, sizeof(frames)) < 0 ||
+        setsockopt(m_fd, SOL_XDP, XDP_RX_RING, &frames, sizeof(frames)) < 0) {
+        std::cerr << "[!] setsockopt() of AF_XDP ring size failed: " << strerror(errno) << "\n";
+        destroy_socket();
+        return false;
+    }
+
+    struct xdp_mmap_offsets offsets;
+    socklen_t optlen = sizeof(offsets);
+    if (getsockopt(m_fd, SOL_XDP, XDP_MMAP_OFFSETS, &offsets, &optlen) < 0) {
+        std::cerr << "[!] getsockopt(XDP_MMAP_OFFSETS) failed: " << strerror(errno) << "\n";
+        destroy_socket();
+        return false;
+    }
+
+    if (!map_ring(m_fill, XDP_UMEM_PGOFF_FILL_RING, offsets.fr, sizeof(uint64_t), frames) ||
+        !map_ring(m_completion, XDP_UMEM_PGOFF_COMPLETION_RING, offsets.cr, sizeof(uint64_t),
+                  frames) ||
+        !map_ring(m_rx, XDP_PGOFF_RX_RING, offsets.rx, sizeof(struct xdp_desc), frames)) {
+        destroy_socket();
+        return false;
+    }
+
+    // every frame starts out with the kernel
+    auto* fill = static_cast<uint64_t*>(m_fill.descs);
+    for (uint32_t i = 0; i < frames; ++i) {
+        fill[i] = static_cast<uint64_t>(i) * m_config.frame_size;
+    }
+    __atomic_store_n(m_fill.producer, frames, __ATOMIC_RELEASE);
+
+    struct sockaddr_xdp sxdp;
+    std::memset(&sxdp, 0, sizeof(sxdp));
+    sxdp.sxdp_family = AF_XDP;
+    sxdp.sxdp_flags = bind_flags | XDP_USE_NEED_WAKEUP;
+    sxdp.sxdp_ifindex = static_cast<uint32_t>(ifindex);
+    sxdp.sxdp_queue_id = m_config.queue_id;
+
+    if (bind(m_fd, reinterpret_cast<struct sockaddr*>(&sxdp), sizeof(sxdp)) < 0) {
+        if (bind_flags == XDP_COPY || m_config.bind == XdpBindMode::ZeroCopy) {
+            std::cerr << "[!] bind() of AF_XDP socket to queue " << m_config.queue_id
+                      << " failed: " << strerror(errno) << "\n";
+        }
+        destroy_socket();
+        return false;
+    }
+
+    m_pending = 0;
+    return true;
+}
+
+void XdpSocket::destroy_socket() {
+    for (Ring* ring : {&m_fill, &m_completion, &m_rx}) {
+        if (ring->map) {
+            munmap(ring->map, ring->map_size);
+        }
+        *ring = Ring();
+    }
+
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    // the kernel keeps its own reference to the pages until the socket is released
+    m_umem.release();
+}
+
+size_t XdpSocket::receive(PacketView* packets, size_t max) {
+    uint32_t consumer = *m_rx.consumer;
+    uint32_t available = __atomic_load_n(m_rx.producer, __ATOMIC_ACQUIRE) - consumer;
+    auto count = static_cast<uint32_t>(available < max ? available : max);
+    if (count == 0) {
+        return 0;
+    }
+
+    // AF_XDP descriptors carry no receive time, one clock read covers the batch
+    const uint64_t ts_ns = wall_clock_ns();
+    const auto* descs = static_cast<const struct xdp_desc*>(m_rx.descs);
+    for (uint32_t i = 0; i < count; ++i) {
+        const struct xdp_desc& desc = descs[(consumer + i) & m_rx.mask];
+        packets[i].data = m_umem.data() + desc.addr;
+        packets[i].len = desc.len;
+        packets[i].ts_ns = ts_ns;
+        packets[i].orig_len = 0;
+    }
+
+    m_pending = count;
+    return count;
+}
+
+void XdpSocket::release() {
+    if (m_pending == 0) {
+        return;
+    }
+
+    // the fill ring holds every frame, so there is always room for the ones coming back
+    const uint32_t rx_consumer = *m_rx.consumer;
+    const uint32_t fill_producer = *m_fill.producer;
+    const auto* descs = static_cast<const struct xdp_desc*>(m_rx.descs);
+    auto* fill = static_cast<uint64_t*>(m_fill.descs);
+    const uint64_t frame_mask = ~static_cast<uint64_t>(m_config.frame_size - 1);
+
+    for (uint32_t i = 0; i < m_pending; ++i) {
+        uint64_t addr = descs[(rx_consumer + i) & m_rx.mask].addr;
+        fill[(fill_producer + i) & m_fill.mask] = addr & frame_mask;
+    }
+
+    __atomic_store_n(m_fill.producer, fill_producer + m_pending, __ATOMIC_RELEASE);
+    __atomic_store_n(m_rx.consumer, rx_consumer + m_pending, __ATOMIC_RELEASE);
+    m_pending = 0;
+
+    if (__atomic_load_n(m_fill.flags, __ATOMIC_RELAXED) & XDP_RING_NEED_WAKEUP) {
+        recvfrom(m_fd, nullptr, 0, MSG_DONTWAIT, nullptr, nullptr);
+    }
+}
+
+bool XdpSocket::wait(int timeout_ms) {
+    struct pollfd pfd;
+    std::memset(&pfd, 0, sizeof(pfd));
+    pfd.fd = m_fd;
+    pfd.events = POLLIN;
+
+    return poll(&pfd, 1, timeout_ms) >= 0 || errno == EINTR;
+}
+
+bool XdpSocket::statistics(struct xdp_statistics& stats) const {
+    std::memset(&stats, 0, sizeof(stats));
+    socklen_t optlen = sizeof(stats);
+    return m_fd >= 0 && getsockopt(m_fd, SOL_XDP, XDP_STATISTICS, &stats, &optlen) == 0;
+}
+
+void XdpSocket::close() {
+    destroy_socket();
+
+    for (int* fd : {&m_link_fd, &m_prog_fd, &m_map_fd}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+
+    m_zero_copy = false;
+    m_generic = false;
+    m_pending = 0;
+}
@@ -0,0 +1,152 @@
+// Per-frame dispatch cost of a templated sink against the std::function callback path.
+//
+// Frames come from TrafficGenerator, so no root or NIC is needed. The std::function case is
+// what run() did before sinks were templates: a per-frame std::function called from a
+// per-batch std::function. The template case hands the same work to run_batch() as a lambda.
+//
+//   sink_benchmark [seconds per case]
+
+#include <time.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "generator.hpp"
+#include "packet.hpp"
+#include "parsers/frame.hpp"
+
+namespace {
+
+uint64_t g_checksum = 0;
+
+struct Result {
+    double pps;
+    double cpu_ns_per_frame;
+};
+
+uint64_t thread_cpu_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// light per-frame work, where the dispatch is a large share of the cost
+struct CountSink {
+    uint64_t bytes = 0;
+    uint64_t ipv4 = 0;
+
+    void operator()(const uint8_t* data, size_t len) {
+        bytes += len;
+        if (len >= 14 && data[12] == 0x08 && data[13] == 0x00) {
+            ++ipv4;
+        }
+    }
+
+    uint64_t result() const {
+        return bytes + ipv4;
+    }
+};
+
+// the console pipeline's first step; the decode allocates nothing, so the gap to the other
+// sinks is parsing work rather than the allocator
+struct ParseSink {
+    uint64_t parsed = 0;
+
+    void operator()(const uint8_t* data, size_t len) {
+        EthernetFrame frame;
+        if (parse_ethernet_frame(data, len, frame)) {
+            parsed += frame.ethertype;
+        }
+    }
+
+    uint64_t result() const {
+        return parsed;
+    }
+};
+
+// runs the generator for the given time on this thread and stops it from a timer thread
+template <typename BatchSink>
+Result measure(const GeneratorConfig& config, double seconds, BatchSink&& sink) {
+    TrafficGenerator generator;
+    if (!generator.open(config)) {
+        std::exit(1);
+    }
+
+    std::atomic<bool> running{true};
+    std::thread timer([&running, seconds]() {
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        running.store(false);
+    });
+
+    const uint64_t cpu_start = thread_cpu_ns();
+    generator.run_batch(sink, running);
+    const uint64_t cpu_ns = thread_cpu_ns() - cpu_start;
+    timer.join();
+
+    const double frames = static_cast<double>(generator.generated());
+    return {frames * 1e9 / static_cast<double>(generator.elapsed_ns()),
+            frames > 0 ? static_cast<double>(cpu_ns) / frames : 0.0};
+}
+
+template <typename FrameSink>
+void compare(const char* workload, uint64_t rate_pps, double seconds) {
+    GeneratorConfig config;
+    config.rate_pps = rate_pps;
+
+    FrameSink function_sink;
+    const std::function<void(const uint8_t*, size_t)> per_frame = std::ref(function_sink);
+    const std::function<void(const PacketView*, size_t)> per_batch =
+        [&per_frame](const PacketView* packets, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                per_frame(packets[i].data, packets[i].len);
+            }
+        };
+    const Result function_result = measure(config, seconds, per_batch);
+
+    FrameSink template_sink;
+    const Result template_result =
+        measure(config, seconds, [&template_sink](const PacketView* packets, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                template_sink(packets[i].data, packets[i].len);
+            }
+        });
+
+    const std::string rate = rate_pps > 0 ? std::to_string(rate_pps) : "max";
+    for (int i = 0; i < 2; ++i) {
+        const Result& result = i == 0 ? function_result : template_result;
+        std::cout << std::left << std::setw(10) << rate << std::setw(8) << workload
+                  << std::setw(15) << (i == 0 ? "std::function" : "template") << std::right
+                  << std::setw(14) << std::fixed << std::setprecision(0) << result.pps
+                  << std::setw(12) << std::setprecision(1) << result.cpu_ns_per_frame << "\n";
+    }
+
+    // printed at the end so the sinks' work cannot be optimized away
+    g_checksum += function_sink.result() + template_sink.result();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 1.0;
+    if (seconds <= 0) {
+        std::cerr << "usage: " << argv[0] << " [seconds per case]\n";
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(10) << "rate" << std::setw(8) << "sink" << std::setw(15)
+              << "dispatch" << std::right << std::setw(14) << "frames/s" << std::setw(12)
+              << "cpu ns/fr" << "\n";
+
+    for (uint64_t rate : {100000ULL, 1000000ULL, 0ULL}) {
+        compare<CountSink>("count", rate, seconds);
+        compare<ParseSink>("parse", rate, seconds);
+    }
+    std::cout << "checksum " << g_checksum << "\n";
+    return 0;
+}
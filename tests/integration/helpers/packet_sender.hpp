@@ -195,6 +195,92 @@ public:
         return true;
     }
 
+    // send a prebuilt Ethernet frame as is
+    bool send_frame(const std::vector<uint8_t>& frame) {
+        sockaddr_ll addr{};
+        addr.sll_family = AF_PACKET;
+        addr.sll_protocol = htons(ETH_P_ALL);
+        addr.sll_ifindex = ifindex;
+        addr.sll_halen = ETH_ALEN;
+        memcpy(addr.sll_addr, frame.data() + 6, 6);
+
+        ssize_t sent =
+            sendto(sockfd, frame.data(), frame.size(), 0, (struct sockaddr*) &addr, sizeof(addr));
+        if (sent < 0) {
+            std::cerr << "Failed to send frame" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // send one IPv4/TCP super-frame of payload_len bytes that the stack treats as TSO, to be
+    // cut into gso_size segments; goes through a second socket with PACKET_VNET_HDR set
+    bool send_tcp_super_frame(size_t payload_len, uint16_t gso_size) {
+        std::vector<uint8_t> frame(14 + 20 + 20 + payload_len, 0);
+        const uint8_t macs[12] = {2, 0, 0, 0, 0, 2, 2, 0, 0, 0, 0, 1};
+        memcpy(frame.data(), macs, sizeof(macs));
+        frame[12] = 0x08;
+
+        uint8_t* ip = frame.data() + 14;
+        const uint16_t ip_len = static_cast<uint16_t>(40 + payload_len);
+        const uint8_t ip_header[20] = {0x45, 0, static_cast<uint8_t>(ip_len >> 8),
+                                       static_cast<uint8_t>(ip_len), 0, 7, 0x40, 0, 64, 6, 0, 0,
+                                       10, 0, 0, 1, 10, 0, 0, 2};
+        memcpy(ip, ip_header, sizeof(ip_header));
+        uint32_t sum = 0;
+        for (size_t i = 0; i < 20; i += 2) {
+            sum += static_cast<uint32_t>(ip[i] << 8 | ip[i + 1]);
+        }
+        while (sum >> 16) {
+            sum = (sum & 0xffff) + (sum >> 16);
+        }
+        ip[10] = static_cast<uint8_t>(~sum >> 8);
+        ip[11] = static_cast<uint8_t>(~sum);
+
+        // checksum over the pseudo-header only, the rest is left to segmentation
+        uint8_t* tcp = ip + 20;
+        const uint8_t tcp_header[14] = {0x9c, 0x40, 0, 80, 0, 0, 0x03, 0xe8, 0, 0, 0, 0, 0x50,
+                                        0x18};
+        memcpy(tcp, tcp_header, sizeof(tcp_header));
+        sum = 0x0a00 + 0x0001 + 0x0a00 + 0x0002 + 6 + 20 + static_cast<uint32_t>(payload_len);
+        while (sum >> 16) {
+            sum = (sum & 0xffff) + (sum >> 16);
+        }
+        tcp[16] = static_cast<uint8_t>(sum >> 8);
+        tcp[17] = static_cast<uint8_t>(sum);
+        for (size_t i = 0; i < payload_len; ++i) {
+            tcp[20 + i] = static_cast<uint8_t>(i);
+        }
+
+        // struct virtio_net_hdr in host byte order: NEEDS_CSUM, GSO_TCPV4
+        const uint16_t vnet[5] = {1 | 1 << 8, 54, gso_size, 34, 16};
+        std::vector<uint8_t> message(sizeof(vnet) + frame.size());
+        memcpy(message.data(), vnet, sizeof(vnet));
+        memcpy(message.data() + sizeof(vnet), frame.data(), frame.size());
+
+        int fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+        int enable = 1;
+        if (fd < 0 || setsockopt(fd, SOL_PACKET, PACKET_VNET_HDR, &enable, sizeof(enable)) < 0) {
+            std::cerr << "Failed to set up a PACKET_VNET_HDR socket" << std::endl;
+            if (fd >= 0) {
+                close(fd);
+            }
+            return false;
+        }
+        sockaddr_ll addr{};
+        addr.sll_family = AF_PACKET;
+        addr.sll_protocol = htons(ETH_P_ALL);
+        addr.sll_ifindex = ifindex;
+        ssize_t sent = sendto(fd, message.data(), message.size(), 0, (struct sockaddr*) &addr,
+                              sizeof(addr));
+        close(fd);
+        if (sent < 0) {
+            std::cerr << "Failed to send super-frame" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
 private:
     std::string iface;
     int sockfd;
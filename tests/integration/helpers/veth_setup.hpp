@@ -1,5 +1,12 @@
 #pragma once
+#include <linux/if_link.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 
@@ -27,6 +34,50 @@ public:
         return veth2;
     }
 
+    // lets an interface send GSO frames of up to size bytes, IPv4 and IPv6 alike (BIG TCP);
+    // goes over rtnetlink since older iproute2 has no gso_ipv4_max_size
+    static bool set_gso_max_size(const std::string& iface, uint32_t size) {
+        // the attribute numbers of kernel 6.3, which older headers do not have
+        const unsigned short gso_ipv4_max_size = 63;
+
+        struct {
+            nlmsghdr header;
+            ifinfomsg info;
+            char attrs[2 * RTA_SPACE(sizeof(uint32_t))];
+        } request{};
+        request.header.nlmsg_len = NLMSG_LENGTH(sizeof(ifinfomsg));
+        request.header.nlmsg_type = RTM_NEWLINK;
+        request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+        request.info.ifi_family = AF_UNSPEC;
+        request.info.ifi_index = static_cast<int>(if_nametoindex(iface.c_str()));
+        for (unsigned short type : {static_cast<unsigned short>(IFLA_GSO_MAX_SIZE),
+                                    gso_ipv4_max_size}) {
+            auto* attr = reinterpret_cast<rtattr*>(reinterpret_cast<char*>(&request) +
+                                                   NLMSG_ALIGN(request.header.nlmsg_len));
+            attr->rta_type = type;
+            attr->rta_len = RTA_LENGTH(sizeof(size));
+            memcpy(RTA_DATA(attr), &size, sizeof(size));
+            request.header.nlmsg_len = NLMSG_ALIGN(request.header.nlmsg_len) + attr->rta_len;
+        }
+
+        int fd = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+        if (fd < 0) {
+            return false;
+        }
+        struct {
+            nlmsghdr header;
+            nlmsgerr error;
+        } reply{};
+        bool ok = send(fd, &request, request.header.nlmsg_len, 0) >= 0 &&
+                  recv(fd, &reply, sizeof(reply), 0) > 0 &&
+                  reply.header.nlmsg_type == NLMSG_ERROR && reply.error.error == 0;
+        close(fd);
+        if (!ok) {
+            std::cerr << "Failed to set the GSO size limit of " << iface << std::endl;
+        }
+        return ok;
+    }
+
 private:
     std::string veth1;
     std::string veth2;
@@ -1,15 +1,26 @@
 #include <gtest/gtest.h>
+#include <net/if.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <thread>
+#include <vector>
 
 #include "capture.hpp"
+#include "export/pcap.hpp"
+#include "filter/bpf.hpp"
+#include "gso.hpp"
 #include "helpers/packet_sender.hpp"
 #include "helpers/veth_setup.hpp"
+#include "multi_capture.hpp"
 #include "parsers/frame.hpp"
 #include "parsers/L2/arp.hpp"
+#include "replay.hpp"
+#include "tsc_clock.hpp"
 
 class VethCaptureTest : public ::testing::Test {
 protected:
@@ -197,3 +208,1367 @@ TEST_F(VethCaptureTest, CaptureWithPromiscuousMode) {
 
     EXPECT_GT(packets_received.load(), 0);
 }
+
+TEST_F(VethCaptureTest, CaptureArpThroughRing) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_ring0", "veth_ring1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    CaptureConfig config;
+    config.mode = CaptureMode::Ring;
+    config.ring.block_size = 1 << 16;
+    config.ring.block_count = 4;
+    config.ring.block_timeout_ms = 10;
+
+    bool arp_captured = false;
+    capture_running = true;
+    std::thread capture_thread([this, &veth, &config, &arp_captured]() {
+        try {
+            PacketCapturer capturer;
+            if (!capturer.open(veth.get_veth1(), false, config)) {
+                return;
+            }
+            EXPECT_EQ(capturer.mode(), CaptureMode::Ring);
+
+            capturer.run(
+                [this, &arp_captured](const uint8_t* data, size_t len) {
+                    packets_received++;
+                    EthernetFrame frame;
+                    if (parse_ethernet_frame(data, len, frame) && frame.ethertype == 0x0806) {
+                        arp_captured = true;
+                    }
+                },
+                capture_running);
+        } catch (...) {
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    RawPacketSender sender(veth.get_veth2());
+    ASSERT_TRUE(sender.is_valid());
+
+    for (int i = 0; i < 3; ++i) {
+        sender.send_arp_request("aa:bb:cc:dd:ee:ff", "10.0.0.1", "10.0.0.2");
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    capture_running = false;
+    capture_thread.join();
+
+    EXPECT_TRUE(arp_captured);
+}
+
+TEST_F(VethCaptureTest, InvalidRingGeometryFallsBackToRecv) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_rfb0", "veth_rfb1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    CaptureConfig config;
+    config.mode = CaptureMode::Ring;
+    config.ring.block_size = 1000;  // not a multiple of the page size
+
+    PacketCapturer capturer;
+    ASSERT_TRUE(capturer.open(veth.get_veth1(), false, config));
+    EXPECT_EQ(capturer.mode(), CaptureMode::Recv);
+}
+
+TEST_F(VethCaptureTest, FanoutGroupSplitsTraffic) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_fan0", "veth_fan1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    CaptureConfig config;
+    config.fanout = FanoutMode::LoadBalance;
+    config.fanout_group = static_cast<uint16_t>(getpid() & 0xffff);
+
+    PacketCapturer first;
+    PacketCapturer second;
+    ASSERT_TRUE(first.open(veth.get_veth1(), false, config));
+    ASSERT_TRUE(second.open(veth.get_veth1(), false, config));
+
+    std::atomic<int> first_count{0};
+    std::atomic<int> second_count{0};
+    capture_running = true;
+
+    std::thread t1([&]() {
+        try {
+            first.run([&](const uint8_t*, size_t) { first_count++; }, capture_running);
+        } catch (...) {
+        }
+    });
+    std::thread t2([&]() {
+        try {
+            second.run([&](const uint8_t*, size_t) { second_count++; }, capture_running);
+        } catch (...) {
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    RawPacketSender sender(veth.get_veth2());
+    ASSERT_TRUE(sender.is_valid());
+    for (int i = 0; i < 20; ++i) {
+        sender.send_arp_request("aa:bb:cc:dd:ee:ff", "10.0.0.1", "10.0.0.2");
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    capture_running = false;
+
+    // wake both blocked recv() calls
+    for (int i = 0; i < 4; ++i) {
+        sender.send_arp_request("aa:bb:cc:dd:ee:ff", "10.0.0.1", "10.0.0.2");
+    }
+    t1.join();
+    t2.join();
+
+    EXPECT_GT(first_count.load(), 0);
+    EXPECT_GT(second_count.load(), 0);
+}
+
+TEST_F(VethCaptureTest, CaptureThroughRecvmmsgBatches) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_mmsg0", "veth_mmsg1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    CaptureConfig config;
+    config.batch_size = 16;
+
+    PacketCapturer capturer;
+    ASSERT_TRUE(capturer.open(veth.get_veth1(), false, config));
+    EXPECT_EQ(capturer.mode(), CaptureMode::Batch);
+
+    RawPacketSender sender(veth.get_veth2());
+    ASSERT_TRUE(sender.is_valid());
+    for (int i = 0; i < 8; ++i) {
+        sender.send_arp_request("aa:bb:cc:dd:ee:ff", "10.0.0.1", "10.0.0.2");
+    }
+
+    size_t largest_batch = 0;
+    capture_running = true;
+    capturer.run_batch(
+        [this, &largest_batch](const PacketView* packets, size_t count) {
+            largest_batch = std::max(largest_batch, count);
+            for (size_t i = 0; i < count; ++i) {
+                EXPECT_GE(packets[i].len, 42u);
+            }
+            packets_received += static_cast<int>(count);
+            if (packets_received >= 8) {
+                capture_running = false;
+            }
+        },
+        capture_running);
+
+    EXPECT_GE(packets_received.load(), 8);
+    EXPECT_GT(largest_batch, 1u);
+}
+
+TEST_F(VethCaptureTest, InvalidRingFallsBackToBatch) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_bfb0", "veth_bfb1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    CaptureConfig config;
+    config.mode = CaptureMode::Ring;
+    config.ring.block_count = 0;
+    config.batch_size = 8;
+
+    PacketCapturer capturer;
+    ASSERT_TRUE(capturer.open(veth.get_veth1(), false, config));
+    EXPECT_EQ(capturer.mode(), CaptureMode::Batch);
+}
+
+TEST_F(VethCaptureTest, KernelTimestampsInEveryMode) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_ts0", "veth_ts1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    CaptureConfig recv_config;
+    CaptureConfig batch_config;
+    batch_config.batch_size = 8;
+    CaptureConfig ring_config;
+    ring_config.mode = CaptureMode::Ring;
+    ring_config.ring.block_size = 1 << 16;
+    ring_config.ring.block_count = 4;
+    ring_config.ring.block_timeout_ms = 10;
+
+    for (const CaptureConfig& config : {recv_config, batch_config, ring_config}) {
+        PacketCapturer capturer;
+        ASSERT_TRUE(capturer.open(veth.get_veth1(), false, config));
+
+        auto before = std::chrono::system_clock::now().time_since_epoch();
+        RawPacketSender sender(veth.get_veth2());
+        ASSERT_TRUE(sender.is_valid());
+        sender.send_arp_request("aa:bb:cc:dd:ee:ff", "10.0.0.1", "10.0.0.2");
+
+        uint64_t ts_ns = 0;
+        capture_running = true;
+        capturer.run_batch(
+            [this, &ts_ns](const PacketView* packets, size_t count) {
+                ts_ns = packets[count - 1].ts_ns;
+                capture_running = false;
+            },
+            capture_running);
+        auto after = std::chrono::system_clock::now().time_since_epoch();
+
+        EXPECT_GE(ts_ns, static_cast<uint64_t>(
+                             std::chrono::duration_cast<std::chrono::nanoseconds>(before).count()));
+        EXPECT_LE(ts_ns, static_cast<uint64_t>(
+                             std::chrono::duration_cast<std::chrono::nanoseconds>(after).count()));
+    }
+}
+
+TEST_F(VethCaptureTest, UserSpaceTimestampsWithoutKernelStamps) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_us0", "veth_us1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+    RawPacketSender sender(veth.get_veth2());
+    ASSERT_TRUE(sender.is_valid());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    // the TSC clock where the CPU has one, CLOCK_REALTIME otherwise
+    calibrate_tsc_clock();
+
+    CaptureConfig recv_config;
+    recv_config.kernel_timestamps = false;
+    CaptureConfig batch_config = recv_config;
+    batch_config.batch_size = 8;
+
+    for (const CaptureConfig& config : {recv_config, batch_config}) {
+        PacketCapturer capturer;
+        ASSERT_TRUE(capturer.open(veth.get_veth1(), false, config));
+
+        const auto before = std::chrono::system_clock::now().time_since_epoch();
+        sender.send_arp_request("aa:bb:cc:dd:ee:ff", "10.0.0.1", "10.0.0.2");
+
+        uint64_t ts_ns = 0;
+        capture_running = true;
+        capturer.run_batch(
+            [this, &ts_ns](const PacketView* packets, size_t count) {
+                ts_ns = packets[count - 1].ts_ns;
+                capture_running = false;
+            },
+            capture_running);
+        const auto after = std::chrono::system_clock::now().time_since_epoch();
+
+        // stamped on read, after the frame was sent; the TSC clock may be off by a little
+        const auto slack = std::chrono::milliseconds(1);
+        EXPECT_GE(ts_ns, static_cast<uint64_t>(
+                             std::chrono::duration_cast<std::chrono::nanoseconds>(before - slack)
+                                 .count()));
+        EXPECT_LE(ts_ns, static_cast<uint64_t>(
+                             std::chrono::duration_cast<std::chrono::nanoseconds>(after + slack)
+                                 .count()));
+    }
+}
+
+TEST_F(VethCaptureTest, KernelFilterDropsNonMatchingFrames) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_bpf0", "veth_bpf1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    // the ring loop polls with a timeout, so it notices the stop flag even when the filter
+    // leaves nothing to wake it up
+    CaptureConfig config;
+    config.mode = CaptureMode::Ring;
+    config.ring.block_size = 1 << 16;
+    config.ring.block_count = 4;
+    config.ring.block_timeout_ms = 10;
+    std::string error;
+    ASSERT_TRUE(compile_filter("icmp", config.filter, error)) << error;
+
+    std::atomic<int> arp_seen{0};
+    std::atomic<int> icmp_seen{0};
+    capture_running = true;
+    std::thread capture_thread([this, &veth, &config, &arp_seen, &icmp_seen]() {
+        try {
+            PacketCapturer capturer;
+            if (!capturer.open(veth.get_veth1(), false, config)) {
+                return;
+            }
+
+            capturer.run(
+                [&arp_seen, &icmp_seen](const uint8_t* data, size_t len) {
+                    EthernetFrame frame;
+                    if (!parse_ethernet_frame(data, len, frame)) {
+                        return;
+                    }
+                    if (frame.ethertype == 0x0806) {
+                        arp_seen++;
+                    } else if (frame.ethertype == 0x0800) {
+                        icmp_seen++;
+                    }
+                },
+                capture_running);
+        } catch (...) {
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    RawPacketSender sender(veth.get_veth2());
+    ASSERT_TRUE(sender.is_valid());
+
+    for (int i = 0; i < 3; ++i) {
+        sender.send_arp_request("aa:bb:cc:dd:ee:ff", "10.0.0.1", "10.0.0.2");
+        sender.send_icmp_ping("aa:bb:cc:dd:ee:ff", "11:22:33:44:55:66", "10.0.0.1", "10.0.0.2");
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    capture_running = false;
+    capture_thread.join();
+
+    EXPECT_EQ(arp_seen, 0);
+    EXPECT_EQ(icmp_seen, 3);
+}
+
+TEST_F(VethCaptureTest, CaptureArpThroughXdp) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    for (bool generic : {false, true}) {
+        VethPair veth("veth_xdp0", "veth_xdp1");
+        if (!veth.is_created()) {
+            GTEST_SKIP() << "Failed to create veth pair";
+        }
+
+        CaptureConfig config;
+        config.mode = CaptureMode::Xdp;
+        config.xdp.frame_count = 256;
+        config.xdp.generic = generic;
+
+        PacketCapturer capturer;
+        ASSERT_TRUE(capturer.open(veth.get_veth1(), false, config));
+        if (capturer.mode() != CaptureMode::Xdp) {
+            GTEST_SKIP() << "AF_XDP unavailable";
+        }
+        EXPECT_EQ(capturer.xdp().generic(), generic);
+        EXPECT_FALSE(capturer.xdp().zero_copy());
+
+        std::atomic<int> arp_seen{0};
+        capture_running = true;
+        std::thread capture_thread([this, &capturer, &arp_seen]() {
+            try {
+                capturer.run_batch(
+                    [&arp_seen](const PacketView* packets, size_t count) {
+                        for (size_t i = 0; i < count; ++i) {
+                            EthernetFrame frame;
+                            if (parse_ethernet_frame(packets[i].data, packets[i].len, frame) &&
+                                frame.ethertype == 0x0806 && packets[i].ts_ns > 0) {
+                                arp_seen++;
+                            }
+                        }
+                    },
+                    capture_running);
+            } catch (...) {
+            }
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        RawPacketSender sender(veth.get_veth2());
+        ASSERT_TRUE(sender.is_valid());
+
+        // more frames than UMEM holds, so released frames have to be reused; paced so that
+        // native veth XDP, which has no backlog queue, does not drop on a full RX ring
+        for (int i = 0; i < 300; ++i) {
+            sender.send_arp_request("aa:bb:cc:dd:ee:ff", "10.0.0.1", "10.0.0.2");
+            if (i % 50 == 49) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        capture_running = false;
+        capture_thread.join();
+
+        EXPECT_EQ(arp_seen, 300) << (generic ? "generic" : "native") << " XDP";
+    }
+}
+
+TEST_F(VethCaptureTest, XdpZeroCopyOnVethFallsBackToRecv) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_xzc0", "veth_xzc1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    // veth has no zero-copy support, so requiring it must not leave a program attached
+    CaptureConfig config;
+    config.mode = CaptureMode::Xdp;
+    config.xdp.bind = XdpBindMode::ZeroCopy;
+
+    PacketCapturer capturer;
+    ASSERT_TRUE(capturer.open(veth.get_veth1(), false, config));
+    EXPECT_EQ(capturer.mode(), CaptureMode::Recv);
+    EXPECT_FALSE(capturer.xdp().is_open());
+}
+
+TEST_F(VethCaptureTest, SnaplenTruncatesInKernelInEveryMode) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_snap0", "veth_snap1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    CaptureConfig recv_config;
+    CaptureConfig batch_config;
+    batch_config.batch_size = 8;
+    CaptureConfig ring_config;
+    ring_config.mode = CaptureMode::Ring;
+    ring_config.ring.block_size = 1 << 16;
+    ring_config.ring.block_count = 4;
+    ring_config.ring.block_timeout_ms = 10;
+    // the filter's accept length must be clamped as well
+    CaptureConfig filter_config;
+    std::string error;
+    ASSERT_TRUE(compile_filter("arp", filter_config.filter, error)) << error;
+
+    for (CaptureConfig config : {recv_config, batch_config, ring_config, filter_config}) {
+        config.snaplen = 20;
+
+        PacketCapturer capturer;
+        ASSERT_TRUE(capturer.open(veth.get_veth1(), false, config));
+
+        size_t len = 0;
+        size_t wire_len = 0;
+        std::atomic<bool> running{true};
+        std::thread capture_thread([&capturer, &running, &len, &wire_len]() {
+            try {
+                capturer.run_batch(
+                    [&running, &len, &wire_len](const PacketView* packets, size_t count) {
+                        for (size_t i = 0; i < count; ++i) {
+                            if (packets[i].wire_len() == 42) {
+                                len = packets[i].len;
+                                wire_len = packets[i].wire_len();
+                                running = false;
+                            }
+                        }
+                    },
+                    running);
+            } catch (...) {
+            }
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        RawPacketSender sender(veth.get_veth2());
+        ASSERT_TRUE(sender.is_valid());
+        for (int i = 0; i < 20 && running; ++i) {
+            sender.send_arp_request("aa:bb:cc:dd:ee:ff", "10.0.0.1", "10.0.0.2");
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+
+        running = false;
+        capture_thread.join();
+
+        EXPECT_EQ(len, 20u) << "mode " << static_cast<int>(capturer.mode());
+        EXPECT_EQ(wire_len, 42u) << "mode " << static_cast<int>(capturer.mode());
+    }
+}
+
+TEST_F(VethCaptureTest, BusyPollCapturesAndMeasuresLatency) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_busy0", "veth_busy1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    CaptureConfig recv_config;
+    CaptureConfig batch_config;
+    batch_config.batch_size = 8;
+    CaptureConfig ring_config;
+    ring_config.mode = CaptureMode::Ring;
+    ring_config.ring.block_size = 1 << 16;
+    ring_config.ring.block_count = 4;
+    ring_config.ring.block_timeout_ms = 1;
+
+    for (CaptureConfig config : {recv_config, batch_config, ring_config}) {
+        config.busy_poll_us = 200;
+        config.measure_latency = true;
+
+        PacketCapturer capturer;
+        ASSERT_TRUE(capturer.open(veth.get_veth1(), false, config));
+
+        std::atomic<int> arp_seen{0};
+        std::atomic<bool> running{true};
+        std::thread capture_thread([&capturer, &running, &arp_seen]() {
+            try {
+                capturer.run_batch(
+                    [&running, &arp_seen](const PacketView* packets, size_t count) {
+                        for (size_t i = 0; i < count; ++i) {
+                            EthernetFrame frame;
+                            if (parse_ethernet_frame(packets[i].data, packets[i].len, frame) &&
+                                frame.ethertype == 0x0806 && ++arp_seen == 5) {
+                                running = false;
+                            }
+                        }
+                    },
+                    running);
+            } catch (...) {
+            }
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        RawPacketSender sender(veth.get_veth2());
+        ASSERT_TRUE(sender.is_valid());
+        for (int i = 0; i < 50 && running; ++i) {
+            sender.send_arp_request("aa:bb:cc:dd:ee:ff", "10.0.0.1", "10.0.0.2");
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        running = false;
+        capture_thread.join();
+
+        EXPECT_GE(arp_seen, 5) << "mode " << static_cast<int>(capturer.mode());
+        EXPECT_GE(capturer.latency().count(), 5u);
+        // a frame takes well under a second from the kernel timestamp to the callback
+        EXPECT_LT(capturer.latency().percentile(50), 1000000000u);
+    }
+}
+
+TEST_F(VethCaptureTest, MultiCaptureMergesInterfacesInTimestampOrder) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair first("veth_mux0", "veth_mux1");
+    VethPair second("veth_mux2", "veth_mux3");
+    if (!first.is_created() || !second.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pairs";
+    }
+
+    CaptureConfig recv_config;
+    CaptureConfig ring_config;
+    ring_config.mode = CaptureMode::Ring;
+    ring_config.ring.block_size = 1 << 16;
+    ring_config.ring.block_count = 4;
+    ring_config.ring.block_timeout_ms = 1;
+
+    for (const CaptureConfig& config : {recv_config, ring_config}) {
+        MultiCapturer capturer;
+        ASSERT_TRUE(capturer.open({first.get_veth1(), second.get_veth1()}, false, config));
+        capturer.set_merge_window(5);
+        ASSERT_EQ(capturer.size(), 2u);
+        const int first_ifindex = capturer.capturer(0).ifindex();
+        const int second_ifindex = capturer.capturer(1).ifindex();
+
+        struct Seen {
+            uint64_t ts_ns;
+            int ifindex;
+            uint8_t source;  // last byte of the sender MAC
+        };
+        std::vector<Seen> seen;
+        std::atomic<bool> running{true};
+        std::thread capture_thread([&capturer, &running, &seen]() {
+            try {
+                capturer.run_batch(
+                    [&seen](const PacketView* packets, size_t count) {
+                        for (size_t i = 0; i < count; ++i) {
+                            EthernetFrame frame;
+                            if (parse_ethernet_frame(packets[i].data, packets[i].len, frame) &&
+                                frame.ethertype == 0x0806) {
+                                seen.push_back(
+                                    {packets[i].ts_ns, packets[i].ifindex, packets[i].data[11]});
+                            }
+                        }
+                    },
+                    running);
+            } catch (...) {
+            }
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        RawPacketSender sender_a(first.get_veth2());
+        RawPacketSender sender_b(second.get_veth2());
+        ASSERT_TRUE(sender_a.is_valid() && sender_b.is_valid());
+        for (int i = 0; i < 10; ++i) {
+            sender_a.send_arp_request("aa:bb:cc:dd:ee:01", "10.0.0.1", "10.0.0.2");
+            sender_b.send_arp_request("aa:bb:cc:dd:ee:02", "10.0.1.1", "10.0.1.2");
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        running = false;
+        capture_thread.join();
+        capturer.close();
+
+        ASSERT_EQ(seen.size(), 20u) << "mode " << static_cast<int>(config.mode);
+        for (size_t i = 0; i < seen.size(); ++i) {
+            EXPECT_EQ(seen[i].ifindex, seen[i].source == 0x01 ? first_ifindex : second_ifindex);
+            if (i > 0) {
+                EXPECT_LE(seen[i - 1].ts_ns, seen[i].ts_ns);
+            }
+        }
+        EXPECT_EQ(std::count_if(seen.begin(), seen.end(),
+                                [](const Seen& frame) { return frame.source == 0x01; }),
+                  10);
+    }
+}
+
+TEST_F(VethCaptureTest, KernelStatisticsCountReceivedAndDroppedFrames) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_stat0", "veth_stat1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    CaptureConfig recv_config;
+    CaptureConfig ring_config;
+    ring_config.mode = CaptureMode::Ring;
+    ring_config.ring.block_size = 1 << 16;
+    ring_config.ring.block_count = 2;
+
+    for (const CaptureConfig& config : {recv_config, ring_config}) {
+        // nobody reads, so the socket queue or the two ring blocks fill up and the rest is dropped
+        PacketCapturer capturer;
+        ASSERT_TRUE(capturer.open(veth.get_veth1(), false, config));
+        capturer.poll_stats();
+
+        RawPacketSender sender(veth.get_veth2());
+        ASSERT_TRUE(sender.is_valid());
+        for (int i = 0; i < 2000; ++i) {
+            sender.send_arp_request("aa:bb:cc:dd:ee:ff", "10.0.0.1", "10.0.0.2");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        CaptureStats stats = capturer.poll_stats();
+        EXPECT_GE(stats.packets, 2000u) << "mode " << static_cast<int>(config.mode);
+        EXPECT_GT(stats.drops, 0u);
+        EXPECT_LT(stats.drops, stats.packets);
+        if (config.mode == CaptureMode::Ring) {
+            EXPECT_GT(stats.freezes, 0u);
+        }
+
+        // totals keep growing across reads although the kernel resets its counters
+        sender.send_arp_request("aa:bb:cc:dd:ee:ff", "10.0.0.1", "10.0.0.2");
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_GE(capturer.poll_stats().packets, stats.packets + 1);
+        EXPECT_EQ(capturer.delivered(), 0u);
+    }
+}
+
+TEST_F(VethCaptureTest, StopSignalEndsQuietCapturePromptly) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_stop0", "veth_stop1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    CaptureConfig recv_config;
+    CaptureConfig batch_config;
+    batch_config.batch_size = 16;
+    CaptureConfig ring_config;
+    ring_config.mode = CaptureMode::Ring;
+
+    using Clock = std::chrono::steady_clock;
+    for (const CaptureConfig& config : {recv_config, batch_config, ring_config}) {
+        const int mode = static_cast<int>(config.mode);
+        PacketCapturer capturer;
+        ASSERT_TRUE(capturer.open(veth.get_veth1(), false, config));
+
+        // no frame arrives, so only the deadline can end the loop
+        StopSignal stop;
+        stop.set_deadline_in(150);
+        auto start = Clock::now();
+        capturer.run_batch([](const PacketView*, size_t) {}, stop);
+        auto elapsed = Clock::now() - start;
+        EXPECT_GE(elapsed, std::chrono::milliseconds(149)) << "mode " << mode;
+        EXPECT_LT(elapsed, std::chrono::milliseconds(250)) << "mode " << mode;
+
+        // and a request from another thread wakes it long before the 100 ms poll interval
+        stop.reset();
+        std::thread requester([&stop]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            stop.request();
+        });
+        start = Clock::now();
+        capturer.run_batch([](const PacketView*, size_t) {}, stop);
+        elapsed = Clock::now() - start;
+        requester.join();
+        EXPECT_LT(elapsed, std::chrono::milliseconds(90)) << "mode " << mode;
+    }
+
+    MultiCapturer multi;
+    ASSERT_TRUE(multi.open({veth.get_veth1(), veth.get_veth2()}, false, CaptureConfig{}));
+    StopSignal stop;
+    stop.set_deadline_in(150);
+    const auto start = Clock::now();
+    multi.run_batch([](const PacketView*, size_t) {}, stop);
+    EXPECT_LT(Clock::now() - start, std::chrono::milliseconds(250));
+}
+
+TEST_F(VethCaptureTest, ReplaySendsPcapThroughTxRing) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_tx0", "veth_tx1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    // 200 frames 1 ms apart, each numbered in its payload; one is too long for the MTU
+    const std::string path = "/tmp/replay_test.pcap";
+    {
+        PcapWriter writer;
+        ASSERT_TRUE(writer.open(path));
+        for (uint32_t i = 0; i < 200; ++i) {
+            std::vector<uint8_t> frame(100 + i, 0);
+            std::memset(frame.data(), 0xFF, 6);
+            frame[6] = 0x02;
+            frame[12] = 0x88;
+            frame[13] = 0xB5;
+            std::memcpy(frame.data() + 14, &i, sizeof(i));
+            writer.write_packet(frame.data(), frame.size(), 1000000000ULL + i * 1000000ULL);
+        }
+        std::vector<uint8_t> jumbo(4000, 0);
+        writer.write_packet(jumbo.data(), jumbo.size(), 1000000000ULL + 200 * 1000000ULL);
+    }
+
+    PcapReader reader;
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_EQ(reader.frames().size(), 201u);
+
+    CaptureConfig config;
+    config.batch_size = 64;
+    for (double speed : {0.0, 1.0, 2.0}) {
+        PacketCapturer capturer;
+        ASSERT_TRUE(capturer.open(veth.get_veth1(), false, config));
+
+        std::vector<uint32_t> received;
+        StopSignal capture_stop;
+        std::thread capture_thread([&]() {
+            capturer.run_batch(
+                [&received](const PacketView* packets, size_t count) {
+                    for (size_t i = 0; i < count; ++i) {
+                        if (packets[i].len >= 18 && packets[i].data[12] == 0x88) {
+                            uint32_t index;
+                            std::memcpy(&index, packets[i].data + 14, sizeof(index));
+                            received.push_back(index);
+                        }
+                    }
+                },
+                capture_stop);
+        });
+
+        ReplayConfig replay_config;
+        replay_config.speed = speed;
+        PacketReplayer replayer;
+        ASSERT_TRUE(replayer.open(veth.get_veth2(), replay_config));
+
+        StopSignal stop;
+        ASSERT_TRUE(replayer.replay(reader.frames().data(), reader.frames().size(), stop));
+        const ReplayStats& stats = replayer.stats();
+        EXPECT_EQ(stats.frames, 200u);
+        EXPECT_EQ(stats.skipped, 1u);
+        EXPECT_EQ(stats.bytes, 200u * 100u + 199u * 200u / 2u);
+
+        // the file spans 199 ms between the first and the last frame that is sent
+        const double seconds = static_cast<double>(stats.elapsed_ns) / 1e9;
+        if (speed == 1.0) {
+            EXPECT_GE(seconds, 0.199);
+            EXPECT_LT(seconds, 0.4);
+        } else if (speed == 2.0) {
+            EXPECT_GE(seconds, 0.099);
+            EXPECT_LT(seconds, 0.199);
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        capture_stop.request();
+        capture_thread.join();
+
+        ASSERT_EQ(received.size(), 200u) << "speed " << speed;
+        for (uint32_t i = 0; i < 200; ++i) {
+            EXPECT_EQ(received[i], i);
+        }
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST_F(VethCaptureTest, DirectionDropsTheOtherWayInEveryMode) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_dir0", "veth_dir1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    // frames sent on veth1 leave the host there, frames sent on veth2 arrive on veth1
+    RawPacketSender outgoing(veth.get_veth1());
+    RawPacketSender incoming(veth.get_veth2());
+    ASSERT_TRUE(outgoing.is_valid());
+    ASSERT_TRUE(incoming.is_valid());
+    // a fresh pair drops what it is given until the link is up
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    const CaptureMode modes[] = {CaptureMode::Recv, CaptureMode::Batch, CaptureMode::Ring};
+    const CaptureDirection directions[] = {CaptureDirection::In, CaptureDirection::Out,
+                                           CaptureDirection::Both};
+    for (CaptureMode mode : modes) {
+        for (CaptureDirection direction : directions) {
+            CaptureConfig config;
+            config.mode = mode;
+            config.batch_size = mode == CaptureMode::Batch ? 16 : 1;
+            config.ring.block_size = 1 << 16;
+            config.ring.block_count = 4;
+            config.ring.block_timeout_ms = 10;
+            config.direction = direction;
+
+            PacketCapturer capturer;
+            ASSERT_TRUE(capturer.open(veth.get_veth1(), false, config));
+
+            int inbound = 0;
+            int outbound = 0;
+            StopSignal stop;
+            std::thread capture_thread([&]() {
+                capturer.run_batch(
+                    [&inbound, &outbound](const PacketView* packets, size_t count) {
+                        // a fresh veth sends IPv6 neighbour discovery of its own
+                        for (size_t i = 0; i < count; ++i) {
+                            if (packets[i].len < 14 || packets[i].data[12] != 0x08 ||
+                                packets[i].data[13] != 0x06) {
+                                continue;
+                            }
+                            if (packets[i].direction == PacketDirection::Inbound) {
+                                ++inbound;
+                            } else if (packets[i].direction == PacketDirection::Outbound) {
+                                ++outbound;
+                            }
+                        }
+                    },
+                    stop);
+            });
+
+            for (int i = 0; i < 3; ++i) {
+                outgoing.send_arp_request("aa:bb:cc:dd:ee:01", "10.0.0.1", "10.0.0.2");
+            }
+            for (int i = 0; i < 4; ++i) {
+                incoming.send_arp_request("aa:bb:cc:dd:ee:02", "10.0.0.2", "10.0.0.1");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            stop.request();
+            capture_thread.join();
+
+            const auto m = static_cast<int>(mode);
+            const auto d = static_cast<int>(direction);
+            EXPECT_EQ(inbound, direction == CaptureDirection::Out ? 0 : 4) << m << " " << d;
+            EXPECT_EQ(outbound, direction == CaptureDirection::In ? 0 : 3) << m << " " << d;
+        }
+    }
+}
+
+TEST_F(VethCaptureTest, StrippedVlanTagIsReportedInEveryMode) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_vlan0", "veth_vlan1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    // the receive path takes 802.1Q tags out of the frame before any packet socket sees it
+    const std::vector<uint8_t> tagged = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0x01, 0x81, 0x00,
+        0xA0, 0x0A, 0x08, 0x06, 0x00, 0x01, 0x08, 0x00, 0x06, 0x04, 0x00, 0x01, 0xAA, 0xBB,
+        0xCC, 0xDD, 0xEE, 0x01, 10,   0,    0,    1,    0,    0,    0,    0,    0,    0,
+        10,   0,    0,    2};
+    RawPacketSender sender(veth.get_veth2());
+    ASSERT_TRUE(sender.is_valid());
+    // a fresh pair drops what it is given until the link is up
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    const CaptureMode modes[] = {CaptureMode::Recv, CaptureMode::Batch, CaptureMode::Ring};
+    for (CaptureMode mode : modes) {
+        CaptureConfig config;
+        config.mode = mode;
+        config.batch_size = mode == CaptureMode::Batch ? 16 : 1;
+        config.ring.block_size = 1 << 16;
+        config.ring.block_count = 4;
+        config.ring.block_timeout_ms = 10;
+
+        PacketCapturer capturer;
+        ASSERT_TRUE(capturer.open(veth.get_veth1(), false, config));
+
+        std::vector<PacketView> seen;
+        std::vector<uint16_t> ethertypes;
+        StopSignal stop;
+        std::thread capture_thread([&]() {
+            capturer.run_batch(
+                [&seen, &ethertypes](const PacketView* packets, size_t count) {
+                    for (size_t i = 0; i < count; ++i) {
+                        if (packets[i].len >= 14 && packets[i].data[6] == 0xAA) {
+                            seen.push_back(packets[i]);
+                            ethertypes.push_back(static_cast<uint16_t>(packets[i].data[12] << 8 |
+                                                                       packets[i].data[13]));
+                        }
+                    }
+                },
+                stop);
+        });
+
+        for (int i = 0; i < 2; ++i) {
+            ASSERT_TRUE(sender.send_frame(tagged));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        stop.request();
+        capture_thread.join();
+
+        ASSERT_EQ(seen.size(), 2u) << static_cast<int>(mode);
+        for (size_t i = 0; i < seen.size(); ++i) {
+            EXPECT_TRUE(seen[i].has_vlan());
+            EXPECT_EQ(seen[i].vlan_tpid, 0x8100);
+            EXPECT_EQ(seen[i].vlan_tci, 0xA00A);
+            EXPECT_EQ(seen[i].vlan_id(), 10);
+            EXPECT_EQ(seen[i].len, tagged.size() - 4);
+            EXPECT_EQ(ethertypes[i], 0x0806);  // parsers see the untagged frame
+        }
+    }
+}
+
+TEST_F(VethCaptureTest, GsoSuperFramesComeWithTheirSegmentSize) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_gso0", "veth_gso1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    RawPacketSender sender(veth.get_veth2());
+    ASSERT_TRUE(sender.is_valid());
+    // a fresh pair drops what it is given until the link is up
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    // veth hands the super-frame to its peer whole, so the capture side sees it unsegmented
+    const CaptureMode modes[] = {CaptureMode::Recv, CaptureMode::Batch, CaptureMode::Ring};
+    for (CaptureMode mode : modes) {
+        CaptureConfig config;
+        config.mode = mode;
+        config.batch_size = mode == CaptureMode::Batch ? 16 : 1;
+        config.ring.block_size = 1 << 16;
+        config.ring.block_count = 4;
+        config.ring.block_timeout_ms = 10;
+        config.gso = GsoMode::Keep;
+
+        PacketCapturer capturer;
+        ASSERT_TRUE(capturer.open(veth.get_veth1(), false, config));
+        ASSERT_TRUE(capturer.reads_vnet_headers());
+
+        std::vector<PacketView> seen;
+        std::vector<std::vector<uint8_t>> segments;
+        StopSignal stop;
+        std::thread capture_thread([&]() {
+            GsoSegmenter segmenter;
+            capturer.run_batch(
+                [&](const PacketView* packets, size_t count) {
+                    for (size_t i = 0; i < count; ++i) {
+                        if (packets[i].len < 14 || packets[i].data[12] != 0x08 ||
+                            packets[i].data[13] != 0x00) {
+                            continue;
+                        }
+                        seen.push_back(packets[i]);
+                        PacketView segment;
+                        if (segmenter.begin(packets[i])) {
+                            while (segmenter.next(segment)) {
+                                segments.emplace_back(segment.data, segment.data + segment.len);
+                            }
+                        }
+                    }
+                },
+                stop);
+        });
+
+        ASSERT_TRUE(sender.send_tcp_super_frame(3000, 1000));
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        stop.request();
+        capture_thread.join();
+
+        const auto m = static_cast<int>(mode);
+        ASSERT_EQ(seen.size(), 1u) << m;
+        EXPECT_EQ(seen[0].len, 14u + 40u + 3000u) << m;
+        EXPECT_TRUE(seen[0].is_gso()) << m;
+        EXPECT_EQ(seen[0].gso.size, 1000) << m;
+        ASSERT_EQ(segments.size(), 3u) << m;
+        for (size_t i = 0; i < segments.size(); ++i) {
+            EXPECT_EQ(segments[i].size(), 14u + 40u + 1000u) << m;
+            const uint32_t seq = static_cast<uint32_t>(segments[i][38]) << 24 |
+                                 static_cast<uint32_t>(segments[i][39]) << 16 |
+                                 static_cast<uint32_t>(segments[i][40]) << 8 | segments[i][41];
+            EXPECT_EQ(seq, 1000u + 1000u * i) << m;
+        }
+    }
+}
+
+TEST_F(VethCaptureTest, FullSizeSuperFrameSurvivesCaptureAndSegments) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_gsf0", "veth_gsf1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    // by default the sender segments anything of 64 KB and up itself, Ethernet header included
+    if (!VethPair::set_gso_max_size(veth.get_veth2(), 1 << 17)) {
+        GTEST_SKIP() << "Kernel without BIG TCP";
+    }
+
+    RawPacketSender sender(veth.get_veth2());
+    ASSERT_TRUE(sender.is_valid());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    // a maximal IP packet: 65535 bytes behind the Ethernet header, more than a 64 KB slot holds
+    const size_t payload = 65535 - 40;
+    const uint16_t gso_size = 1448;
+    const size_t frame_len = 14 + 65535;
+    const size_t segment_count = (payload + gso_size - 1) / gso_size;
+    const std::string path = "/tmp/full_super_frame.pcap";
+
+    const CaptureMode modes[] = {CaptureMode::Recv, CaptureMode::Batch, CaptureMode::Ring};
+    for (CaptureMode mode : modes) {
+        CaptureConfig config;
+        config.mode = mode;
+        config.batch_size = mode == CaptureMode::Batch ? 16 : 1;
+        config.ring.block_size = 1 << 17;
+        config.ring.block_count = 4;
+        config.ring.block_timeout_ms = 10;
+        config.gso = GsoMode::Keep;
+
+        PacketCapturer capturer;
+        ASSERT_TRUE(capturer.open(veth.get_veth1(), false, config));
+        ASSERT_TRUE(capturer.reads_vnet_headers());
+
+        // written with the default snap length, which has to keep the super-frame whole
+        PcapWriter writer;
+        ASSERT_TRUE(writer.open(path));
+
+        std::vector<PacketView> seen;
+        std::vector<std::vector<uint8_t>> segments;
+        StopSignal stop;
+        std::thread capture_thread([&]() {
+            GsoSegmenter segmenter;
+            capturer.run_batch(
+                [&](const PacketView* packets, size_t count) {
+                    for (size_t i = 0; i < count; ++i) {
+                        if (packets[i].len < 14 || packets[i].data[12] != 0x08 ||
+                            packets[i].data[13] != 0x00) {
+                            continue;
+                        }
+                        seen.push_back(packets[i]);
+                        writer.write_packets(&packets[i], 1);
+                        PacketView segment;
+                        if (segmenter.begin(packets[i])) {
+                            while (segmenter.next(segment)) {
+                                segments.emplace_back(segment.data, segment.data + segment.len);
+                            }
+                        }
+                    }
+                },
+                stop);
+        });
+
+        ASSERT_TRUE(sender.send_tcp_super_frame(payload, gso_size));
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        stop.request();
+        capture_thread.join();
+        writer.close();
+
+        const auto m = static_cast<int>(mode);
+        ASSERT_EQ(seen.size(), 1u) << m;
+        EXPECT_EQ(seen[0].len, frame_len) << m;
+        EXPECT_LE(seen[0].orig_len, seen[0].len) << m;
+        EXPECT_EQ(seen[0].gso.size, gso_size) << m;
+        ASSERT_EQ(segments.size(), segment_count) << m;
+        size_t carried = 0;
+        for (size_t i = 0; i < segments.size(); ++i) {
+            const uint32_t seq = static_cast<uint32_t>(segments[i][38]) << 24 |
+                                 static_cast<uint32_t>(segments[i][39]) << 16 |
+                                 static_cast<uint32_t>(segments[i][40]) << 8 | segments[i][41];
+            EXPECT_EQ(seq, 1000u + gso_size * i) << m;
+            carried += segments[i].size() - 54;
+        }
+        EXPECT_EQ(carried, payload) << m;
+
+        std::ifstream file(path, std::ios::binary);
+        file.seekg(24);
+        PcapPacketHeader header;
+        ASSERT_TRUE(file.read(reinterpret_cast<char*>(&header), sizeof(header))) << m;
+        EXPECT_EQ(header.incl_len, frame_len) << m;
+        EXPECT_EQ(header.orig_len, frame_len) << m;
+    }
+    std::remove(path.c_str());
+}
+
+TEST_F(VethCaptureTest, AutoSizeGrowsTheReceiveBufferOnDrops) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_as0", "veth_as1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    RawPacketSender sender(veth.get_veth2());
+    ASSERT_TRUE(sender.is_valid());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    CaptureConfig config;
+    config.autosize.max_bytes = 16 << 20;
+    config.autosize.interval_ms = 50;
+
+    PacketCapturer capturer;
+    ASSERT_TRUE(capturer.open(veth.get_veth1(), false, config));
+    const size_t initial = capturer.receive_buffer_size();
+    ASSERT_GT(initial, 0u);
+
+    // a sink that falls behind, so a burst overflows the default buffer
+    StopSignal stop;
+    std::thread capture_thread([&]() {
+        capturer.run_batch(
+            [](const PacketView*, size_t) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            },
+            stop);
+    });
+
+    std::vector<uint8_t> frame(1000, 0);
+    std::memset(frame.data(), 0xff, 6);
+    frame[12] = 0x88;
+    frame[13] = 0xb5;  // local experimental ethertype
+    for (int i = 0; i < 2000; ++i) {
+        ASSERT_TRUE(sender.send_frame(frame));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    stop.request();
+    capture_thread.join();
+
+    EXPECT_GT(capturer.poll_stats().drops, 0u);
+    EXPECT_GT(capturer.receive_buffer_size(), initial);
+    EXPECT_LE(capturer.receive_buffer_size(), config.autosize.max_bytes);
+}
+
+TEST_F(VethCaptureTest, LoadSheddingCutsFramesWhenTheRingFillsUp) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_ls0", "veth_ls1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    RawPacketSender sender(veth.get_veth2());
+    ASSERT_TRUE(sender.is_valid());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    CaptureConfig config;
+    config.mode = CaptureMode::Ring;
+    config.ring.block_size = 1 << 16;
+    config.ring.block_count = 8;
+    config.ring.block_timeout_ms = 10;
+    config.shed.enabled = true;
+    config.shed.header_bytes = 64;
+    config.shed.recover_ms = 50;
+
+    PacketCapturer capturer;
+    ASSERT_TRUE(capturer.open(veth.get_veth1(), false, config));
+    ASSERT_EQ(capturer.mode(), CaptureMode::Ring);
+
+    // a sink slow enough for a burst to fill the ring
+    size_t cut = 0;
+    size_t whole = 0;
+    StopSignal stop;
+    std::thread capture_thread([&]() {
+        capturer.run_batch(
+            [&](const PacketView* packets, size_t count) {
+                for (size_t i = 0; i < count; ++i) {
+                    if (packets[i].wire_len() != 500) {
+                        continue;
+                    }
+                    if (packets[i].len == 64) {
+                        ++cut;
+                    } else {
+                        ++whole;
+                    }
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            },
+            stop);
+    });
+
+    std::vector<uint8_t> frame(500, 0);
+    std::memset(frame.data(), 0xff, 6);
+    frame[12] = 0x88;
+    frame[13] = 0xb5;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    // paced a little faster than the sink drains, so the ring fills gradually and passes the
+    // headers threshold before anything is dropped
+    for (int i = 0; i < 4000; ++i) {
+        ASSERT_TRUE(sender.send_frame(frame));
+        if (i % 20 == 19) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    stop.request();
+    capture_thread.join();
+
+    const CaptureStats stats = capturer.poll_stats();
+    EXPECT_GT(cut, 0u);
+    EXPECT_GE(stats.cut, cut);  // plus whatever else the kernel sent on the link
+    EXPECT_GT(whole, 0u);  // the first frames came before the ring filled up
+
+    const std::vector<ShedInterval> intervals = capturer.shed_intervals();
+    ASSERT_FALSE(intervals.empty());
+    EXPECT_NE(intervals.front().level, ShedLevel::None);
+    // calm again after the burst, so every interval was closed
+    EXPECT_EQ(intervals.back().level, ShedLevel::Headers);
+    for (const ShedInterval& interval : intervals) {
+        EXPECT_GE(interval.end_ns, interval.start_ns);
+    }
+}
+
+TEST_F(VethCaptureTest, AnyInterfaceAttributesFramesToTheirInterface) {
+    if (geteuid() != 0) {
+        GTEST_SKIP() << "Requires root privileges";
+    }
+
+    VethPair veth("veth_any0", "veth_any1");
+    if (!veth.is_created()) {
+        GTEST_SKIP() << "Failed to create veth pair";
+    }
+
+    RawPacketSender sender(veth.get_veth2());
+    ASSERT_TRUE(sender.is_valid());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    const int receiver = static_cast<int>(if_nametoindex(veth.get_veth1().c_str()));
+    const int transmitter = static_cast<int>(if_nametoindex(veth.get_veth2().c_str()));
+    ASSERT_GT(receiver, 0);
+    ASSERT_GT(transmitter, 0);
+
+    for (CaptureMode mode : {CaptureMode::Batch, CaptureMode::Ring}) {
+        CaptureConfig config;
+        config.mode = mode;
+        config.batch_size = 16;
+        config.ring.block_size = 1 << 16;
+        config.ring.block_count = 4;
+        config.ring.block_timeout_ms = 10;
+
+        PacketCapturer capturer;
+        ASSERT_TRUE(capturer.open(ANY_INTERFACE, false, config));
+        EXPECT_TRUE(capturer.any_interface());
+
+        int received = 0;
+        int sent = 0;
+        int misattributed = 0;
+        StopSignal stop;
+        std::thread capture_thread([&]() {
+            capturer.run_batch(
+                [&](const PacketView* packets, size_t count) {
+                    for (size_t i = 0; i < count; ++i) {
+                        const PacketView& packet = packets[i];
+                        if (packet.len < 14 || packet.data[12] != 0x88 ||
+                            packet.data[13] != 0xb5) {
+                            continue;
+                        }
+                        if (packet.ifindex == receiver &&
+                            packet.type == PacketType::Broadcast &&
+                            packet.direction == PacketDirection::Inbound) {
+                            ++received;
+                        } else if (packet.ifindex == transmitter &&
+                                   packet.type == PacketType::Outgoing &&
+                                   packet.direction == PacketDirection::Outbound) {
+                            ++sent;
+                        } else {
+                            ++misattributed;
+                        }
+                    }
+                },
+                stop);
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        std::vector<uint8_t> frame(64, 0);
+        std::memset(frame.data(), 0xff, 6);
+        frame[6] = 0x02;
+        frame[12] = 0x88;
+        frame[13] = 0xb5;
+        for (int i = 0; i < 20; ++i) {
+            ASSERT_TRUE(sender.send_frame(frame));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        stop.request();
+        capture_thread.join();
+
+        EXPECT_EQ(received, 20) << "mode " << static_cast<int>(mode);
+        EXPECT_EQ(sent, 20) << "mode " << static_cast<int>(mode);
+        EXPECT_EQ(misattributed, 0) << "mode " << static_cast<int>(mode);
+    }
+}
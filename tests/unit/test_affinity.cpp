@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <sched.h>
+
+#include <vector>
+
+#include "affinity.hpp"
+
+TEST(CpuListTest, ParsesRangesAndSingleCpus) {
+    std::vector<int> cpus;
+    ASSERT_TRUE(parse_cpu_list("0-3,8,10-11", cpus));
+    EXPECT_EQ(cpus, (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+}
+
+TEST(CpuListTest, FormatCollapsesRuns) {
+    EXPECT_EQ(format_cpu_list({0, 1, 2, 3, 8, 10, 11}), "0-3,8,10-11");
+    EXPECT_EQ(format_cpu_list({5}), "5");
+    EXPECT_EQ(format_cpu_list({}), "");
+
+    std::vector<int> cpus;
+    ASSERT_TRUE(parse_cpu_list(format_cpu_list({1, 2, 4}), cpus));
+    EXPECT_EQ(cpus, (std::vector<int>{1, 2, 4}));
+}
+
+TEST(CpuListTest, RejectsMalformedLists) {
+    const char* invalid[] = {"", "a", "3-1", "0-", ",1", "99999"};
+    for (const char* list : invalid) {
+        std::vector<int> cpus;
+        EXPECT_FALSE(parse_cpu_list(list, cpus)) << list;
+    }
+}
+
+TEST(NumaNodeTest, ParsesAutoOffAndNodeNumbers) {
+    int node = 0;
+    ASSERT_TRUE(parse_numa_node("auto", node));
+    EXPECT_EQ(node, NUMA_NODE_OF_INTERFACE);
+    ASSERT_TRUE(parse_numa_node("off", node));
+    EXPECT_EQ(node, -1);
+    ASSERT_TRUE(parse_numa_node("1", node));
+    EXPECT_EQ(node, 1);
+    EXPECT_FALSE(parse_numa_node("-1", node));
+    EXPECT_FALSE(parse_numa_node("near", node));
+}
+
+TEST(NumaNodeTest, VirtualInterfaceHasNoNode) {
+    EXPECT_EQ(interface_numa_node("lo"), -1);
+    EXPECT_EQ(interface_numa_node("no-such-iface0"), -1);
+}
+
+TEST(NumaNodeTest, NodeZeroListsItsCpus) {
+    EXPECT_FALSE(numa_node_cpus(0).empty());
+    EXPECT_TRUE(numa_node_cpus(-1).empty());
+}
+
+TEST(AffinityTest, PinsCurrentThread) {
+    cpu_set_t saved;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(saved), &saved), 0);
+
+    ASSERT_TRUE(pin_current_thread(0));
+    EXPECT_EQ(sched_getcpu(), 0);
+
+    sched_setaffinity(0, sizeof(saved), &saved);
+}
+
+TEST(AffinityTest, ScopedNumaPolicy) {
+    EXPECT_FALSE(ScopedNumaPolicy(-1).active());
+    EXPECT_TRUE(ScopedNumaPolicy(0).active());
+}
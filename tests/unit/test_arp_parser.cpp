@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 
 #include <cstring>
+#include <sstream>
+#include <string>
 
 #include "parsers/L2/arp.hpp"
 
@@ -225,3 +227,22 @@ TEST_F(ArpParserTest, ManyArpPacketsInSequence) {
 TEST_F(ArpParserTest, ProtocolNameCheck) {
     EXPECT_STREQ(parser.protocol_name(), "ARP");
 }
+
+TEST_F(ArpParserTest, DecodesAddressesAndPrintsThem) {
+    uint8_t data[] = {0x00, 0x01, 0x08, 0x00, 0x06, 0x04, 0x00, 0x02, 0x11, 0x22,
+                      0x33, 0x44, 0x55, 0x66, 10,   0,    0,    1,    0xAA, 0xBB,
+                      0xCC, 0xDD, 0xEE, 0x0F, 192,  168,  100,  20};
+
+    ASSERT_TRUE(parser.parse(data, sizeof(data)));
+    EXPECT_EQ(parser.packet().opcode, 2);
+    EXPECT_EQ(parser.packet().sender_mac, MacAddress::from(data + 8));
+    EXPECT_EQ(to_string(parser.packet().target_mac), "aa:bb:cc:dd:ee:0f");
+    EXPECT_EQ(to_string(parser.packet().target_ip), "192.168.100.20");
+
+    std::ostringstream out;
+    parser.print(out);
+    EXPECT_NE(out.str().find("  Sender MAC: 11:22:33:44:55:66\n"), std::string::npos);
+    EXPECT_NE(out.str().find("  Sender IP:  10.0.0.1\n"), std::string::npos);
+    EXPECT_NE(out.str().find("  Target MAC: aa:bb:cc:dd:ee:0f\n"), std::string::npos);
+    EXPECT_NE(out.str().find("  Target IP:  192.168.100.20\n"), std::string::npos);
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include "autosize.hpp"
+
+namespace {
+
+AutoSizeConfig config(size_t max_bytes, uint32_t quiet_intervals = 3) {
+    AutoSizeConfig config;
+    config.max_bytes = max_bytes;
+    config.quiet_intervals = quiet_intervals;
+    return config;
+}
+
+}  // namespace
+
+TEST(AutoSizeTest, ParsesByteSizes) {
+    size_t bytes = 0;
+    ASSERT_TRUE(parse_byte_size("65536", bytes));
+    EXPECT_EQ(bytes, 65536u);
+    ASSERT_TRUE(parse_byte_size("512k", bytes));
+    EXPECT_EQ(bytes, 512u << 10);
+    ASSERT_TRUE(parse_byte_size("64M", bytes));
+    EXPECT_EQ(bytes, 64u << 20);
+    ASSERT_TRUE(parse_byte_size("1g", bytes));
+    EXPECT_EQ(bytes, 1u << 30);
+
+    EXPECT_FALSE(parse_byte_size("", bytes));
+    EXPECT_FALSE(parse_byte_size("m", bytes));
+    EXPECT_FALSE(parse_byte_size("64mb", bytes));
+    EXPECT_FALSE(parse_byte_size("-1", bytes));
+}
+
+TEST(AutoSizeTest, DisabledWithoutCap) {
+    EXPECT_FALSE(BufferAutoSizer().enabled());
+    EXPECT_FALSE(BufferAutoSizer(config(0), 1000).enabled());
+    EXPECT_TRUE(BufferAutoSizer(config(4000), 1000).enabled());
+}
+
+TEST(AutoSizeTest, GrowsOnDropsAndFillUpToTheCap) {
+    BufferAutoSizer sizer(config(3000), 1000);
+    size_t size = 0;
+
+    EXPECT_EQ(sizer.decide(5, size), SizeDecision::Grow);
+    EXPECT_EQ(size, 2000u);
+    sizer.applied(size);
+
+    // no drops yet, but the buffer came close to overflowing
+    sizer.sample_fill(0.2);
+    sizer.sample_fill(0.8);
+    EXPECT_EQ(sizer.decide(0, size), SizeDecision::Grow);
+    EXPECT_EQ(size, 3000u);
+    EXPECT_DOUBLE_EQ(sizer.last_peak_fill(), 0.8);
+    sizer.applied(size);
+
+    // the cap is reported once, then held quietly
+    EXPECT_EQ(sizer.decide(5, size), SizeDecision::AtCap);
+    EXPECT_EQ(size, 3000u);
+    EXPECT_EQ(sizer.decide(5, size), SizeDecision::Hold);
+}
+
+TEST(AutoSizeTest, ShrinksAfterQuietIntervalsDownToTheFloor) {
+    BufferAutoSizer sizer(config(8000), 1000);
+    size_t size = 0;
+    sizer.applied(4000);
+
+    sizer.sample_fill(0.1);
+    EXPECT_EQ(sizer.decide(0, size), SizeDecision::Hold);
+    EXPECT_EQ(sizer.decide(0, size), SizeDecision::Hold);
+    EXPECT_EQ(sizer.decide(0, size), SizeDecision::Shrink);
+    EXPECT_EQ(size, 2000u);
+    sizer.applied(size);
+
+    // a half full interval starts the count over
+    EXPECT_EQ(sizer.decide(0, size), SizeDecision::Hold);
+    sizer.sample_fill(0.5);
+    EXPECT_EQ(sizer.decide(0, size), SizeDecision::Hold);
+    EXPECT_EQ(sizer.decide(0, size), SizeDecision::Hold);
+    EXPECT_EQ(sizer.decide(0, size), SizeDecision::Hold);
+    EXPECT_EQ(sizer.decide(0, size), SizeDecision::Shrink);
+    EXPECT_EQ(size, 1000u);
+    sizer.applied(size);
+
+    // the size the socket started with is the floor
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(sizer.decide(0, size), SizeDecision::Hold);
+    }
+    EXPECT_EQ(size, 1000u);
+}
+
+TEST(AutoSizeTest, LimitTurnsGrowthIntoTheCap) {
+    BufferAutoSizer sizer(config(1 << 20), 1000);
+    size_t size = 0;
+    ASSERT_EQ(sizer.decide(1, size), SizeDecision::Grow);
+
+    // the kernel granted less than asked
+    sizer.applied(1500);
+    sizer.limit(1500);
+    EXPECT_EQ(sizer.decide(1, size), SizeDecision::AtCap);
+    EXPECT_EQ(size, 1500u);
+}
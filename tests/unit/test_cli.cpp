@@ -326,3 +326,210 @@ TEST_F(CliTest, CountAndTimeExclusive) {
     EXPECT_EQ(opts.packet_count, 50);
     EXPECT_EQ(opts.capture_duration, 30);
 }
+
+TEST_F(CliTest, RingDisabledByDefault) {
+    EXPECT_FALSE(opts.use_ring);
+    EXPECT_EQ(opts.ring_block_size, 1 << 22);
+    EXPECT_EQ(opts.ring_block_count, 64);
+    EXPECT_EQ(opts.ring_block_timeout, 64);
+}
+
+TEST_F(CliTest, ParseRingShort) {
+    const char* argv[] = {"prog", "-R"};
+    ASSERT_TRUE(parse_cli(2, (char**) argv, opts));
+    EXPECT_TRUE(opts.use_ring);
+}
+
+TEST_F(CliTest, ParseRingGeometry) {
+    const char* argv[] = {"prog",          "--ring", "--ring-block-size", "1048576",
+                          "--ring-blocks", "16",     "--ring-timeout",    "10"};
+    ASSERT_TRUE(parse_cli(8, (char**) argv, opts));
+    EXPECT_TRUE(opts.use_ring);
+    EXPECT_EQ(opts.ring_block_size, 1048576);
+    EXPECT_EQ(opts.ring_block_count, 16);
+    EXPECT_EQ(opts.ring_block_timeout, 10);
+}
+
+TEST_F(CliTest, MissingRingBlocksArgumentReturnsFalse) {
+    const char* argv[] = {"prog", "--ring-blocks"};
+    EXPECT_FALSE(parse_cli(2, (char**) argv, opts));
+}
+
+TEST_F(CliTest, ParseWorkersAndFanout) {
+    const char* argv[] = {"prog", "-w", "4", "--fanout", "cpu"};
+    ASSERT_TRUE(parse_cli(5, (char**) argv, opts));
+    EXPECT_EQ(opts.workers, 4);
+    EXPECT_EQ(opts.fanout_mode, "cpu");
+}
+
+TEST_F(CliTest, SingleWorkerHashFanoutByDefault) {
+    EXPECT_EQ(opts.workers, 1);
+    EXPECT_EQ(opts.fanout_mode, "hash");
+}
+
+TEST_F(CliTest, UnknownFanoutModeReturnsFalse) {
+    const char* argv[] = {"prog", "--fanout", "random"};
+    EXPECT_FALSE(parse_cli(3, (char**) argv, opts));
+}
+
+TEST_F(CliTest, ParseBatchSize) {
+    const char* argv[] = {"prog", "--batch", "32"};
+    ASSERT_TRUE(parse_cli(3, (char**) argv, opts));
+    EXPECT_EQ(opts.batch_size, 32);
+}
+
+TEST_F(CliTest, ParseFilter) {
+    const char* argv[] = {"prog", "-f", "arp or port 53", "--filter-dump"};
+    ASSERT_TRUE(parse_cli(4, (char**) argv, opts));
+    EXPECT_EQ(opts.filter, "arp or port 53");
+    EXPECT_TRUE(opts.filter_dump);
+}
+
+TEST_F(CliTest, FilterWithoutExpressionReturnsFalse) {
+    const char* argv[] = {"prog", "--filter"};
+    EXPECT_FALSE(parse_cli(2, (char**) argv, opts));
+}
+
+TEST_F(CliTest, ParseXdpOptions) {
+    const char* argv[] = {"prog", "-X", "--xdp-queue", "3", "--xdp-bind", "copy", "--xdp-generic"};
+    ASSERT_TRUE(parse_cli(7, (char**) argv, opts));
+    EXPECT_TRUE(opts.use_xdp);
+    EXPECT_EQ(opts.xdp_queue, 3);
+    EXPECT_EQ(opts.xdp_bind, "copy");
+    EXPECT_TRUE(opts.xdp_generic);
+}
+
+TEST_F(CliTest, UnknownXdpBindModeReturnsFalse) {
+    const char* argv[] = {"prog", "--xdp-bind", "fast"};
+    EXPECT_FALSE(parse_cli(3, (char**) argv, opts));
+}
+
+TEST_F(CliTest, ParseSnaplen) {
+    const char* argv[] = {"prog", "-s", "128"};
+    ASSERT_TRUE(parse_cli(3, (char**) argv, opts));
+    EXPECT_EQ(opts.snaplen, 128);
+}
+
+TEST_F(CliTest, ParseBusyPollAndLatency) {
+    const char* argv[] = {"prog", "--busy-poll", "50", "--latency"};
+    ASSERT_TRUE(parse_cli(4, (char**) argv, opts));
+    EXPECT_EQ(opts.busy_poll_us, 50);
+    EXPECT_TRUE(opts.report_latency);
+}
+
+TEST_F(CliTest, ParseInterfaceListAndMergeWindow) {
+    const char* argv[] = {"prog", "-I", "eth0,eth1", "--merge-window", "25"};
+    ASSERT_TRUE(parse_cli(5, (char**) argv, opts));
+    EXPECT_EQ(opts.interface, "eth0,eth1");
+    EXPECT_EQ(opts.merge_window_ms, 25);
+}
+
+TEST(SplitInterfacesTest, SplitsCommaSeparatedList) {
+    EXPECT_EQ(split_interfaces("eth0"), std::vector<std::string>({"eth0"}));
+    EXPECT_EQ(split_interfaces("eth0, eth1,,veth2 "),
+              std::vector<std::string>({"eth0", "eth1", "veth2"}));
+    EXPECT_TRUE(split_interfaces(" , ").empty());
+}
+
+TEST_F(CliTest, ParseGeneratorOptions) {
+    const char* argv[] = {"prog",      "-G",          "--gen-rate", "5000",  "--gen-flows", "16",
+                          "--gen-mix", "udp=1,tcp=1", "--gen-size", "64-512"};
+    ASSERT_TRUE(parse_cli(10, (char**) argv, opts));
+    EXPECT_TRUE(opts.generate);
+    EXPECT_EQ(opts.gen_rate, 5000);
+    EXPECT_EQ(opts.gen_flows, 16);
+    EXPECT_EQ(opts.gen_mix, "udp=1,tcp=1");
+    EXPECT_EQ(opts.gen_size, "64-512");
+}
+
+TEST_F(CliTest, InvalidGeneratorMixReturnsFalse) {
+    const char* argv[] = {"prog", "--gen-mix", "udp"};
+    EXPECT_FALSE(parse_cli(3, (char**) argv, opts));
+}
+
+TEST_F(CliTest, ParseStatsInterval) {
+    const char* argv[] = {"prog", "--stats", "5"};
+    ASSERT_TRUE(parse_cli(3, (char**) argv, opts));
+    EXPECT_EQ(opts.stats_interval, 5);
+}
+
+TEST_F(CliTest, ParseCpusAndNuma) {
+    const char* argv[] = {"prog", "--cpus", "0-3,8", "--numa", "off"};
+    ASSERT_TRUE(parse_cli(5, (char**) argv, opts));
+    EXPECT_EQ(opts.cpus, "0-3,8");
+    EXPECT_EQ(opts.numa, "off");
+}
+
+TEST_F(CliTest, InvalidCpusOrNumaReturnsFalse) {
+    const char* bad_cpus[] = {"prog", "--cpus", "3-1"};
+    EXPECT_FALSE(parse_cli(3, (char**) bad_cpus, opts));
+    const char* bad_numa[] = {"prog", "--numa", "near"};
+    EXPECT_FALSE(parse_cli(3, (char**) bad_numa, opts));
+}
+
+TEST_F(CliTest, ParseHugepages) {
+    EXPECT_EQ(opts.hugepages, "auto");
+    const char* argv[] = {"prog", "--hugepages", "2m"};
+    ASSERT_TRUE(parse_cli(3, (char**) argv, opts));
+    EXPECT_EQ(opts.hugepages, "2m");
+
+    const char* bad[] = {"prog", "--hugepages", "4k"};
+    EXPECT_FALSE(parse_cli(3, (char**) bad, opts));
+}
+
+TEST_F(CliTest, ParseDirection) {
+    EXPECT_EQ(opts.direction, "both");
+    const char* argv[] = {"prog", "--direction", "in"};
+    ASSERT_TRUE(parse_cli(3, (char**) argv, opts));
+    EXPECT_EQ(opts.direction, "in");
+
+    const char* bad[] = {"prog", "--direction", "inbound"};
+    EXPECT_FALSE(parse_cli(3, (char**) bad, opts));
+}
+
+TEST_F(CliTest, ParseRecordOnly) {
+    EXPECT_FALSE(opts.record_only);
+    const char* argv[] = {"prog", "--record", "-o", "out.pcap"};
+    ASSERT_TRUE(parse_cli(4, (char**) argv, opts));
+    EXPECT_TRUE(opts.record_only);
+    EXPECT_EQ(opts.output_file, "out.pcap");
+}
+
+TEST_F(CliTest, ParseGso) {
+    EXPECT_EQ(opts.gso, "off");
+    const char* argv[] = {"prog", "--gso", "segment"};
+    ASSERT_TRUE(parse_cli(3, (char**) argv, opts));
+    EXPECT_EQ(opts.gso, "segment");
+
+    const char* bad[] = {"prog", "--gso", "split"};
+    EXPECT_FALSE(parse_cli(3, (char**) bad, opts));
+}
+
+TEST_F(CliTest, ParseAutosize) {
+    EXPECT_TRUE(opts.autosize.empty());
+    const char* argv[] = {"prog", "--autosize", "64m"};
+    ASSERT_TRUE(parse_cli(3, (char**) argv, opts));
+    EXPECT_EQ(opts.autosize, "64m");
+
+    const char* bad[] = {"prog", "--autosize", "64x"};
+    EXPECT_FALSE(parse_cli(3, (char**) bad, opts));
+    const char* zero[] = {"prog", "--autosize", "0"};
+    EXPECT_FALSE(parse_cli(3, (char**) zero, opts));
+}
+
+TEST_F(CliTest, ParseTimestamps) {
+    EXPECT_EQ(opts.timestamps, "kernel");
+    const char* argv[] = {"prog", "--timestamps", "tsc"};
+    ASSERT_TRUE(parse_cli(3, (char**) argv, opts));
+    EXPECT_EQ(opts.timestamps, "tsc");
+
+    const char* bad[] = {"prog", "--timestamps", "hpet"};
+    EXPECT_FALSE(parse_cli(3, (char**) bad, opts));
+}
+
+TEST_F(CliTest, ParseShed) {
+    EXPECT_EQ(opts.shed_bytes, 0);
+    const char* argv[] = {"prog", "--shed", "96"};
+    ASSERT_TRUE(parse_cli(3, (char**) argv, opts));
+    EXPECT_EQ(opts.shed_bytes, 96);
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <linux/if_ether.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "parsers/frame.hpp"
+#include "parsers/protocol_parser.hpp"
+
+// Every allocation through the replaceable global operator new is counted, so a test can check
+// that a stretch of code leaves the heap alone. The replacement applies to the whole test
+// binary; it only counts and otherwise behaves like the default.
+
+namespace {
+
+std::atomic<uint64_t> g_allocations{0};
+
+// keeps the compiler from eliding the allocation in CounterSeesAllocations
+int* volatile g_sink = nullptr;
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+// broadcast ARP request and a TCP SYN over IPv4, Ethernet header included
+const uint8_t ARP_FRAME[42] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE,
+                               0xFF, 0x08, 0x06, 0x00, 0x01, 0x08, 0x00, 0x06, 0x04, 0x00, 0x01,
+                               0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF, 10,   0,    0,    1,    0x00,
+                               0x00, 0x00, 0x00, 0x00, 0x00, 10,   0,    0,    2};
+
+const uint8_t IPV4_FRAME[34] = {0x52, 0x54, 0x00, 0x12, 0x34, 0x56, 0x08, 0x00, 0x27,
+                                0xAB, 0xCD, 0xEF, 0x08, 0x00, 0x45, 0x00, 0x00, 0x3C,
+                                0x1C, 0x46, 0x40, 0x00, 0x40, 0x06, 0x00, 0x00, 192,
+                                168,  1,    100,  192,  168,  1,    1};
+
+}  // namespace
+
+TEST(DecodeAllocationTest, ParsingFramesDoesNotAllocate) {
+    // the per-thread parsers are created on first use, which is allowed to allocate
+    ASSERT_NE(ProtocolParser::get_parser(ETH_P_ARP), nullptr);
+    ASSERT_NE(ProtocolParser::get_parser(ETH_P_IP), nullptr);
+
+    constexpr int PACKETS = 1000;
+    int parsed = 0;
+    const uint64_t before = g_allocations.load(std::memory_order_relaxed);
+    for (int i = 0; i < PACKETS; ++i) {
+        for (const uint8_t* data : {ARP_FRAME, IPV4_FRAME}) {
+            const size_t len = data == ARP_FRAME ? sizeof(ARP_FRAME) : sizeof(IPV4_FRAME);
+            EthernetFrame frame;
+            if (!parse_ethernet_frame(data, len, frame)) {
+                continue;
+            }
+            ProtocolParser* parser = ProtocolParser::get_parser(frame.ethertype);
+            if (parser != nullptr && parser->parse(frame.payload, frame.payload_len)) {
+                ++parsed;
+            }
+        }
+    }
+    const uint64_t allocations = g_allocations.load(std::memory_order_relaxed) - before;
+
+    EXPECT_EQ(parsed, 2 * PACKETS);
+    EXPECT_EQ(allocations, 0u);
+}
+
+TEST(DecodeAllocationTest, AddressesFormatWithoutAllocating) {
+    EthernetFrame frame;
+    ASSERT_TRUE(parse_ethernet_frame(IPV4_FRAME, sizeof(IPV4_FRAME), frame));
+
+    char mac[MAC_TEXT_LEN + 1];
+    char ip[IPV4_TEXT_LEN + 1];
+    const uint64_t before = g_allocations.load(std::memory_order_relaxed);
+    const size_t mac_len = format_address(frame.src_mac, mac);
+    const size_t ip_len = format_address(Ipv4Address::from(frame.payload + 12), ip);
+    const uint64_t allocations = g_allocations.load(std::memory_order_relaxed) - before;
+
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_EQ(std::string(mac, mac_len), "08:00:27:ab:cd:ef");
+    EXPECT_EQ(std::string(ip, ip_len), "192.168.1.100");
+}
+
+TEST(DecodeAllocationTest, CounterSeesAllocations) {
+    const uint64_t before = g_allocations.load(std::memory_order_relaxed);
+    g_sink = new int(7);
+    const uint64_t allocations = g_allocations.load(std::memory_order_relaxed) - before;
+    delete g_sink;
+
+    EXPECT_GE(allocations, 1u);
+}
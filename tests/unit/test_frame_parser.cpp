@@ -14,8 +14,8 @@ TEST_F(FrameParserTest, ValidIpv4Frame) {
                       0x70, 0x18, 0xD7, 0x08, 0x00, 0x45, 0x00, 0x00, 0x34};
 
     ASSERT_TRUE(parse_ethernet_frame(data, sizeof(data), frame));
-    EXPECT_EQ(frame.dst_mac, "88:86:03:fa:52:91");
-    EXPECT_EQ(frame.src_mac, "a4:97:b1:70:18:d7");
+    EXPECT_EQ(to_string(frame.dst_mac), "88:86:03:fa:52:91");
+    EXPECT_EQ(to_string(frame.src_mac), "a4:97:b1:70:18:d7");
     EXPECT_EQ(frame.ethertype, 0x0800);
     EXPECT_EQ(frame.payload_len, 4);
 }
@@ -25,7 +25,7 @@ TEST_F(FrameParserTest, ValidArpFrame) {
                       0xDD, 0xEE, 0xFF, 0x08, 0x06, 0x00, 0x01, 0x08, 0x00};
 
     ASSERT_TRUE(parse_ethernet_frame(data, sizeof(data), frame));
-    EXPECT_EQ(frame.dst_mac, "ff:ff:ff:ff:ff:ff");
+    EXPECT_EQ(to_string(frame.dst_mac), "ff:ff:ff:ff:ff:ff");
     EXPECT_EQ(frame.ethertype, 0x0806);
 }
 
@@ -58,7 +58,7 @@ TEST_F(FrameParserTest, UnicastDestination) {
                       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
 
     ASSERT_TRUE(parse_ethernet_frame(data, sizeof(data), frame));
-    EXPECT_EQ(frame.dst_mac[1], '0');  // unicast bit
+    EXPECT_FALSE(frame.dst_mac.is_multicast());  // unicast bit
 }
 
 TEST_F(FrameParserTest, MulticastDestination) {
@@ -66,7 +66,8 @@ TEST_F(FrameParserTest, MulticastDestination) {
                       0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF, 0x08, 0x00};
 
     ASSERT_TRUE(parse_ethernet_frame(data, sizeof(data), frame));
-    EXPECT_EQ(frame.dst_mac, "01:00:5e:00:00:01");
+    EXPECT_EQ(to_string(frame.dst_mac), "01:00:5e:00:00:01");
+    EXPECT_TRUE(frame.dst_mac.is_multicast());
 }
 
 TEST_F(FrameParserTest, BroadcastDestination) {
@@ -74,7 +75,7 @@ TEST_F(FrameParserTest, BroadcastDestination) {
                       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
 
     ASSERT_TRUE(parse_ethernet_frame(data, sizeof(data), frame));
-    EXPECT_EQ(frame.dst_mac, "ff:ff:ff:ff:ff:ff");
+    EXPECT_EQ(to_string(frame.dst_mac), "ff:ff:ff:ff:ff:ff");
 }
 
 TEST_F(FrameParserTest, LocallyAdministeredMac) {
@@ -82,7 +83,7 @@ TEST_F(FrameParserTest, LocallyAdministeredMac) {
                       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
 
     ASSERT_TRUE(parse_ethernet_frame(data, sizeof(data), frame));
-    EXPECT_EQ(frame.dst_mac, "02:00:00:00:00:01");
+    EXPECT_EQ(to_string(frame.dst_mac), "02:00:00:00:00:01");
 }
 
 TEST_F(FrameParserTest, Ipv6EtherType) {
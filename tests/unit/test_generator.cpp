@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "generator.hpp"
+#include "parsers/frame.hpp"
+#include "parsers/L2/arp.hpp"
+#include "parsers/L3/ipv4.hpp"
+
+class TrafficGeneratorTest : public ::testing::Test {
+protected:
+    TrafficGenerator generator;
+    std::atomic<bool> running{true};
+
+    // runs the generator until limit frames went through fn
+    void generate(uint64_t limit, const std::function<void(const PacketView&)>& fn) {
+        uint64_t seen = 0;
+        generator.run_batch(
+            [&](const PacketView* packets, size_t count) {
+                for (size_t i = 0; i < count && seen < limit; ++i, ++seen) {
+                    fn(packets[i]);
+                }
+                if (seen >= limit) {
+                    running = false;
+                }
+            },
+            running);
+    }
+};
+
+TEST_F(TrafficGeneratorTest, FramesParseAsEthernetArpAndIpv4) {
+    GeneratorConfig config;
+    config.icmp_weight = 1;
+    ASSERT_TRUE(generator.open(config));
+
+    std::map<uint16_t, int> ethertypes;
+    std::set<uint8_t> protocols;
+    generate(2000, [&](const PacketView& packet) {
+        EthernetFrame frame;
+        ASSERT_TRUE(parse_ethernet_frame(packet.data, packet.len, frame));
+        ++ethertypes[frame.ethertype];
+
+        if (frame.ethertype == 0x0806) {
+            ArpParser arp;
+            EXPECT_TRUE(arp.parse(frame.payload, frame.payload_len));
+        } else {
+            ASSERT_EQ(frame.ethertype, 0x0800);
+            Ipv4Parser ipv4;
+            EXPECT_TRUE(ipv4.parse(frame.payload, frame.payload_len));
+            EXPECT_EQ((frame.payload[2] << 8 | frame.payload[3]), packet.len - 14);
+            protocols.insert(frame.payload[9]);
+        }
+        EXPECT_NE(packet.ts_ns, 0u);
+    });
+
+    EXPECT_GT(ethertypes[0x0806], 0);
+    EXPECT_GT(ethertypes[0x0800], ethertypes[0x0806]);
+    EXPECT_EQ(protocols, std::set<uint8_t>({1, 6, 17}));
+    EXPECT_GE(generator.generated(), 2000u);
+}
+
+TEST_F(TrafficGeneratorTest, FollowsMixWeights) {
+    GeneratorConfig config;
+    ASSERT_TRUE(parse_traffic_mix("udp=3,tcp=1", config));
+    ASSERT_TRUE(generator.open(config));
+
+    int udp = 0;
+    int tcp = 0;
+    generate(config.pool_size, [&](const PacketView& packet) {
+        ASSERT_EQ(packet.data[12], 0x08);
+        ASSERT_EQ(packet.data[13], 0x00);
+        (packet.data[23] == 17 ? udp : tcp)++;
+    });
+
+    EXPECT_EQ(udp + tcp, static_cast<int>(config.pool_size));
+    EXPECT_NEAR(static_cast<double>(udp) / (udp + tcp), 0.75, 0.05);
+}
+
+TEST_F(TrafficGeneratorTest, ImixSizes) {
+    GeneratorConfig config;
+    ASSERT_TRUE(parse_traffic_mix("udp=1", config));
+    ASSERT_TRUE(generator.open(config));
+
+    std::map<size_t, int> sizes;
+    generate(config.pool_size, [&](const PacketView& packet) { ++sizes[packet.len]; });
+
+    ASSERT_EQ(sizes.size(), 3u);
+    EXPECT_GT(sizes[60], sizes[590]);
+    EXPECT_GT(sizes[590], sizes[1514]);
+}
+
+TEST_F(TrafficGeneratorTest, UniformSizesStayInRange) {
+    GeneratorConfig config;
+    ASSERT_TRUE(parse_traffic_mix("tcp=1", config));
+    ASSERT_TRUE(parse_frame_sizes("100-200", config));
+    ASSERT_TRUE(generator.open(config));
+
+    generate(1000, [](const PacketView& packet) {
+        EXPECT_GE(packet.len, 100u);
+        EXPECT_LE(packet.len, 200u);
+    });
+}
+
+TEST_F(TrafficGeneratorTest, FlowCountLimitsDistinctSources) {
+    GeneratorConfig config;
+    ASSERT_TRUE(parse_traffic_mix("udp=1", config));
+    config.flow_count = 5;
+    ASSERT_TRUE(generator.open(config));
+
+    std::set<uint16_t> ports;
+    generate(1000, [&](const PacketView& packet) {
+        ports.insert(static_cast<uint16_t>(packet.data[34] << 8 | packet.data[35]));
+    });
+    EXPECT_EQ(ports.size(), 5u);
+}
+
+TEST_F(TrafficGeneratorTest, SnaplenCutsFrames) {
+    GeneratorConfig config;
+    ASSERT_TRUE(parse_traffic_mix("udp=1", config));
+    ASSERT_TRUE(parse_frame_sizes("1000", config));
+    config.snaplen = 64;
+    ASSERT_TRUE(generator.open(config));
+
+    generate(10, [](const PacketView& packet) {
+        EXPECT_EQ(packet.len, 64u);
+        EXPECT_EQ(packet.wire_len(), 1000u);
+    });
+}
+
+TEST_F(TrafficGeneratorTest, PacesToTargetRate) {
+    GeneratorConfig config;
+    config.rate_pps = 2000;
+    ASSERT_TRUE(generator.open(config));
+
+    auto start = std::chrono::steady_clock::now();
+    generate(200, [](const PacketView&) {});
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // 200 frames at 2000 pps take 100 ms
+    EXPECT_GE(elapsed, std::chrono::milliseconds(90));
+    EXPECT_LT(elapsed, std::chrono::seconds(2));
+}
+
+TEST_F(TrafficGeneratorTest, SameSeedSameTraffic) {
+    GeneratorConfig config;
+    config.pool_size = 64;
+    ASSERT_TRUE(generator.open(config));
+    std::vector<std::vector<uint8_t>> first;
+    generate(64, [&](const PacketView& p) { first.emplace_back(p.data, p.data + p.len); });
+
+    TrafficGenerator other;
+    ASSERT_TRUE(other.open(config));
+    size_t index = 0;
+    running = true;
+    other.run_batch(
+        [&](const PacketView* packets, size_t count) {
+            for (size_t i = 0; i < count && index < first.size(); ++i, ++index) {
+                EXPECT_EQ(std::vector<uint8_t>(packets[i].data, packets[i].data + packets[i].len),
+                          first[index]);
+            }
+            if (index >= first.size()) {
+                running = false;
+            }
+        },
+        running);
+}
+
+TEST(GeneratorConfigTest, ParsesMixAndSizes) {
+    GeneratorConfig config;
+    ASSERT_TRUE(parse_traffic_mix("arp=2,icmp=1", config));
+    EXPECT_EQ(config.arp_weight, 2u);
+    EXPECT_EQ(config.icmp_weight, 1u);
+    EXPECT_EQ(config.udp_weight, 0u);
+    EXPECT_EQ(config.tcp_weight, 0u);
+
+    ASSERT_TRUE(parse_frame_sizes("128", config));
+    EXPECT_EQ(config.sizes, FrameSizes::Fixed);
+    EXPECT_EQ(config.min_size, 128u);
+
+    const char* bad_mixes[] = {"", "arp", "udp=0", "sctp=1", "udp=-1", "tcp=x"};
+    for (const char* mix : bad_mixes) {
+        EXPECT_FALSE(parse_traffic_mix(mix, config)) << mix;
+    }
+    const char* bad_sizes[] = {"", "10", "64-20000", "200-100", "big", "60-"};
+    for (const char* sizes : bad_sizes) {
+        EXPECT_FALSE(parse_frame_sizes(sizes, config)) << sizes;
+    }
+}
+
+// counts frames and stops the generator once it has seen enough
+struct CountingSink {
+    std::atomic<bool>* running;
+    uint64_t frames = 0;
+
+    void operator()(const PacketView*, size_t count) {
+        frames += count;
+        if (frames >= 1000) {
+            running->store(false);
+        }
+    }
+};
+
+TEST_F(TrafficGeneratorTest, RunBatchTakesFunctorsAndStdFunction) {
+    ASSERT_TRUE(generator.open(GeneratorConfig{}));
+
+    CountingSink sink{&running};
+    generator.run_batch(sink, running);
+    EXPECT_GE(sink.frames, 1000u);
+
+    running = true;
+    CountingSink wrapped{&running};
+    const std::function<void(const PacketView*, size_t)> callback = std::ref(wrapped);
+    generator.run_batch(callback, running);
+    EXPECT_GE(wrapped.frames, 1000u);
+}
@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "gso.hpp"
+
+namespace {
+
+constexpr uint8_t GSO_TCPV4 = 1;
+constexpr uint8_t GSO_TCPV6 = 4;
+constexpr uint8_t GSO_UDP_L4 = 5;
+
+uint16_t get16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] << 8 | p[1]);
+}
+
+uint32_t get32(const uint8_t* p) {
+    return static_cast<uint32_t>(get16(p)) << 16 | get16(p + 2);
+}
+
+void put16(uint8_t* p, uint16_t value) {
+    p[0] = static_cast<uint8_t>(value >> 8);
+    p[1] = static_cast<uint8_t>(value);
+}
+
+uint32_t sum(const uint8_t* data, size_t len, uint32_t acc = 0) {
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        acc += get16(data + i);
+    }
+    if (len & 1) {
+        acc += static_cast<uint32_t>(data[len - 1]) << 8;
+    }
+    return acc;
+}
+
+uint16_t folded(uint32_t acc) {
+    while (acc >> 16) {
+        acc = (acc & 0xffff) + (acc >> 16);
+    }
+    return static_cast<uint16_t>(acc);
+}
+
+// a correct checksum makes the sum over the covered bytes fold to 0xffff
+bool l4_checksum_ok(const PacketView& segment, bool ipv6, uint8_t protocol) {
+    const uint8_t* ip = segment.data + 14;
+    const size_t l4 = 14 + (ipv6 ? 40 : 20);
+    const size_t l4_len = segment.len - l4;
+    uint32_t acc = ipv6 ? sum(ip + 8, 32) : sum(ip + 12, 8);
+    acc += protocol + static_cast<uint32_t>(l4_len);
+    return folded(sum(segment.data + l4, l4_len, acc)) == 0xffff;
+}
+
+// Ethernet, IPv4 or IPv6, then a TCP or UDP header and payload bytes counting up
+std::vector<uint8_t> super_frame(bool ipv6, bool tcp, size_t payload) {
+    const size_t ip_len = ipv6 ? 40 : 20;
+    const size_t l4_len = tcp ? 20 : 8;
+    std::vector<uint8_t> frame(14 + ip_len + l4_len + payload, 0);
+    put16(frame.data() + 12, ipv6 ? 0x86DD : 0x0800);
+
+    uint8_t* ip = frame.data() + 14;
+    const uint8_t protocol = tcp ? 6 : 17;
+    if (ipv6) {
+        ip[0] = 0x60;
+        put16(ip + 4, static_cast<uint16_t>(l4_len + payload));
+        ip[6] = protocol;
+        ip[7] = 64;
+        ip[23] = 1;
+        ip[39] = 2;
+    } else {
+        ip[0] = 0x45;
+        put16(ip + 2, static_cast<uint16_t>(ip_len + l4_len + payload));
+        put16(ip + 4, 0x1000);
+        ip[8] = 64;
+        ip[9] = protocol;
+        const uint8_t addrs[8] = {10, 0, 0, 1, 10, 0, 0, 2};
+        std::memcpy(ip + 12, addrs, sizeof(addrs));
+    }
+
+    uint8_t* l4 = ip + ip_len;
+    put16(l4, 40000);
+    put16(l4 + 2, tcp ? 80 : 443);
+    if (tcp) {
+        put16(l4 + 4, 0x0001);  // sequence number 0x00010000
+        l4[12] = 0x50;
+        l4[13] = 0x80 | 0x10 | 0x08 | 0x01;  // CWR|ACK|PSH|FIN
+    }
+    for (size_t i = 0; i < payload; ++i) {
+        l4[l4_len + i] = static_cast<uint8_t>(i);
+    }
+    return frame;
+}
+
+// segments point into the segmenter's buffer, so each one is copied out into copies
+std::vector<PacketView> segments_of(GsoSegmenter& segmenter, const PacketView& packet,
+                                    std::vector<std::vector<uint8_t>>& copies) {
+    std::vector<PacketView> segments;
+    copies.clear();
+    copies.reserve(16);
+    EXPECT_TRUE(segmenter.begin(packet));
+    PacketView segment;
+    while (segmenter.next(segment) && segments.size() < 16) {
+        copies.emplace_back(segment.data, segment.data + segment.len);
+        segment.data = copies.back().data();
+        segments.push_back(segment);
+    }
+    return segments;
+}
+
+}  // namespace
+
+TEST(GsoTest, ParsesModeNames) {
+    GsoMode mode = GsoMode::Off;
+    ASSERT_TRUE(parse_gso_mode("keep", mode));
+    EXPECT_EQ(mode, GsoMode::Keep);
+    ASSERT_TRUE(parse_gso_mode("segment", mode));
+    EXPECT_EQ(mode, GsoMode::Segment);
+    ASSERT_TRUE(parse_gso_mode("off", mode));
+    EXPECT_EQ(mode, GsoMode::Off);
+    EXPECT_FALSE(parse_gso_mode("on", mode));
+    EXPECT_STREQ(gso_type_name(GSO_TCPV4 | 0x80), "tcpv4");
+}
+
+TEST(GsoTest, ReadsVnetHeaderInHostOrder) {
+    const uint16_t fields[5] = {static_cast<uint16_t>(1 | GSO_TCPV6 << 8), 74, 1428, 54, 16};
+    uint8_t header[VNET_HDR_LEN];
+    std::memcpy(header, fields, sizeof(header));
+
+    PacketView packet;
+    read_vnet_header(header, packet);
+    EXPECT_EQ(packet.gso.type, GSO_TCPV6);
+    EXPECT_TRUE(packet.gso.needs_csum);
+    EXPECT_EQ(packet.gso.size, 1428);
+    EXPECT_EQ(packet.gso.csum_start, 54);
+    EXPECT_EQ(packet.gso.csum_offset, 16);
+    EXPECT_TRUE(packet.is_gso());
+}
+
+TEST(GsoTest, CutsTcpv4SuperFrame) {
+    auto frame = super_frame(false, true, 2500);
+    PacketView packet{frame.data(), frame.size(), 7};
+    packet.gso.type = GSO_TCPV4;
+    packet.gso.size = 1000;
+    packet.direction = PacketDirection::Outbound;
+
+    GsoSegmenter segmenter;
+    std::vector<std::vector<uint8_t>> copies;
+    auto segments = segments_of(segmenter, packet, copies);
+    ASSERT_EQ(segments.size(), 3u);
+
+    const size_t payloads[3] = {1000, 1000, 500};
+    for (size_t i = 0; i < 3; ++i) {
+        const PacketView& segment = segments[i];
+        const uint8_t* ip = segment.data + 14;
+        const uint8_t* tcp = ip + 20;
+        EXPECT_EQ(segment.len, 54 + payloads[i]);
+        EXPECT_EQ(segment.ts_ns, 7u);
+        EXPECT_EQ(segment.direction, PacketDirection::Outbound);
+        EXPECT_FALSE(segment.is_gso());
+        EXPECT_EQ(get16(ip + 2), 40 + payloads[i]);
+        EXPECT_EQ(get16(ip + 4), 0x1000 + i);
+        EXPECT_EQ(folded(sum(ip, 20)), 0xffff);
+        EXPECT_EQ(get32(tcp + 4), 0x00010000u + 1000 * i);
+        EXPECT_TRUE(l4_checksum_ok(segment, false, 6));
+        EXPECT_EQ(tcp[20], static_cast<uint8_t>(1000 * i));  // payload picks up where it left
+    }
+    EXPECT_EQ(segments[0].data[14 + 20 + 13], 0x80 | 0x10);  // CWR only on the first
+    EXPECT_EQ(segments[1].data[14 + 20 + 13], 0x10);
+    EXPECT_EQ(segments[2].data[14 + 20 + 13], 0x10 | 0x08 | 0x01);  // PSH and FIN on the last
+}
+
+TEST(GsoTest, CutsTcpv6AndUdpSuperFrames) {
+    auto tcp = super_frame(true, true, 3000);
+    PacketView tcp_packet{tcp.data(), tcp.size(), 0};
+    tcp_packet.gso.type = GSO_TCPV6;
+    tcp_packet.gso.size = 1440;
+
+    GsoSegmenter segmenter;
+    std::vector<std::vector<uint8_t>> copies;
+    auto segments = segments_of(segmenter, tcp_packet, copies);
+    ASSERT_EQ(segments.size(), 3u);
+    EXPECT_EQ(get16(segments[0].data + 14 + 4), 20 + 1440);
+    EXPECT_EQ(get16(segments[2].data + 14 + 4), 20 + 120);
+    for (const auto& segment : segments) {
+        EXPECT_TRUE(l4_checksum_ok(segment, true, 6));
+    }
+
+    auto udp = super_frame(false, false, 2000);
+    PacketView udp_packet{udp.data(), udp.size(), 0};
+    udp_packet.gso.type = GSO_UDP_L4;
+    udp_packet.gso.size = 1200;
+    segments = segments_of(segmenter, udp_packet, copies);
+    ASSERT_EQ(segments.size(), 2u);
+    EXPECT_EQ(get16(segments[0].data + 34 + 4), 8 + 1200);
+    EXPECT_EQ(get16(segments[1].data + 34 + 4), 8 + 800);
+    EXPECT_EQ(get16(segments[1].data + 14 + 4), 0x1000 + 1);
+    for (const auto& segment : segments) {
+        EXPECT_TRUE(l4_checksum_ok(segment, false, 17));
+    }
+}
+
+TEST(GsoTest, LeavesFramesItCannotCutAlone) {
+    auto frame = super_frame(false, true, 2500);
+    PacketView packet{frame.data(), frame.size(), 0};
+    GsoSegmenter segmenter;
+    EXPECT_FALSE(segmenter.begin(packet));  // no GSO metadata
+
+    packet.gso.type = GSO_TCPV6;
+    packet.gso.size = 1000;
+    EXPECT_FALSE(segmenter.begin(packet));  // type does not match the headers
+
+    packet.gso.type = GSO_TCPV4;
+    packet.orig_len = frame.size() + 100;
+    EXPECT_FALSE(segmenter.begin(packet));  // cut by the snap length
+
+    packet.orig_len = 0;
+    put16(frame.data() + 12, 0x0806);
+    EXPECT_FALSE(segmenter.begin(packet));
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <string>
+
+#include "hugepages.hpp"
+
+namespace {
+
+// free pages in the default (2 MB) hugetlb pool
+long free_huge_pages() {
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    long value = 0;
+    while (meminfo >> key >> value) {
+        if (key == "HugePages_Free:") {
+            return value;
+        }
+        meminfo.ignore(64, '\n');
+    }
+    return 0;
+}
+
+bool all_zero(const HugeBuffer& buffer) {
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        if (buffer.data()[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+TEST(HugePageModeTest, ParsesModeNames) {
+    HugePageMode mode = HugePageMode::Off;
+    ASSERT_TRUE(parse_huge_page_mode("auto", mode));
+    EXPECT_EQ(mode, HugePageMode::Auto);
+    ASSERT_TRUE(parse_huge_page_mode("2m", mode));
+    EXPECT_EQ(mode, HugePageMode::Huge2M);
+    ASSERT_TRUE(parse_huge_page_mode("1g", mode));
+    EXPECT_EQ(mode, HugePageMode::Huge1G);
+    ASSERT_TRUE(parse_huge_page_mode("off", mode));
+    EXPECT_EQ(mode, HugePageMode::Off);
+    EXPECT_FALSE(parse_huge_page_mode("4k", mode));
+    EXPECT_FALSE(parse_huge_page_mode("", mode));
+}
+
+TEST(HugeBufferTest, SmallBuffersUseNormalPages) {
+    HugeBuffer buffer;
+    ASSERT_TRUE(buffer.allocate(64 * 1024, HugePageMode::Auto));
+    EXPECT_EQ(buffer.backing(), PageBacking::Normal);
+    EXPECT_EQ(buffer.size(), 64u * 1024u);
+    EXPECT_TRUE(all_zero(buffer));
+
+    ASSERT_TRUE(buffer.allocate(4 << 20, HugePageMode::Off));
+    EXPECT_EQ(buffer.backing(), PageBacking::Normal);
+}
+
+TEST(HugeBufferTest, FallsBackWhenThePoolIsEmpty) {
+    const bool available = free_huge_pages() >= 2;
+
+    HugeBuffer buffer;
+    ASSERT_TRUE(buffer.allocate(3 << 20, HugePageMode::Huge2M));
+    if (available) {
+        EXPECT_EQ(buffer.backing(), PageBacking::Huge2M);
+    } else {
+        EXPECT_TRUE(buffer.backing() == PageBacking::Normal ||
+                    buffer.backing() == PageBacking::Transparent);
+    }
+    EXPECT_EQ(buffer.size(), 3u << 20);
+    EXPECT_TRUE(all_zero(buffer));
+
+    buffer.data()[0] = 1;
+    buffer.data()[buffer.size() - 1] = 1;
+    EXPECT_EQ(buffer.data()[buffer.size() - 1], 1);
+}
+
+TEST(HugeBufferTest, ReleaseResetsTheBuffer) {
+    HugeBuffer buffer;
+    ASSERT_TRUE(buffer.allocate(8192, HugePageMode::Auto));
+    buffer.release();
+    EXPECT_EQ(buffer.data(), nullptr);
+    EXPECT_EQ(buffer.size(), 0u);
+    EXPECT_EQ(buffer.backing(), PageBacking::None);
+    EXPECT_FALSE(buffer.allocate(0, HugePageMode::Auto));
+}
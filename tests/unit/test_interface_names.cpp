@@ -0,0 +1,35 @@
+#include <gtest/gtest.h>
+#include <net/if.h>
+
+#include <string>
+
+#include "interface_names.hpp"
+
+TEST(InterfaceNamesTest, ResolvesAnIndexOnce) {
+    const int loopback = static_cast<int>(if_nametoindex("lo"));
+    ASSERT_GT(loopback, 0);
+
+    InterfaceNames names;
+    EXPECT_EQ(names.lookup(loopback), "lo");
+    const std::string* first = &names.lookup(loopback);
+    EXPECT_EQ(&names.lookup(loopback), first);  // served from the table
+    EXPECT_EQ(names.size(), 1u);
+}
+
+TEST(InterfaceNamesTest, SetNamesWinOverTheKernel) {
+    const int loopback = static_cast<int>(if_nametoindex("lo"));
+    ASSERT_GT(loopback, 0);
+
+    InterfaceNames names;
+    names.set(loopback, "loopback");
+    EXPECT_EQ(names.lookup(loopback), "loopback");
+}
+
+TEST(InterfaceNamesTest, UnknownIndexesResolveToNothingAndAreRemembered) {
+    InterfaceNames names;
+    EXPECT_EQ(names.lookup(0), "");
+    EXPECT_EQ(names.lookup(-1), "");
+    EXPECT_EQ(names.lookup(1 << 30), "");
+    EXPECT_EQ(names.lookup(1 << 30), "");
+    EXPECT_EQ(names.size(), 3u);
+}
@@ -2,6 +2,8 @@
 #include <netinet/in.h>
 
 #include <cstring>
+#include <sstream>
+#include <string>
 
 #include "parsers/L3/ipv4.hpp"
 
@@ -282,3 +284,17 @@ TEST_F(Ipv4ParserTest, ManyIpv4PacketsInSequence) {
 TEST_F(Ipv4ParserTest, ProtocolNameCheck) {
     EXPECT_STREQ(parser.protocol_name(), "IPv4");
 }
+
+TEST_F(Ipv4ParserTest, DecodesAddressesAndPrintsThem) {
+    uint8_t data[] = {0x45, 0x00, 0x00, 0x3C, 0x00, 0x00, 0x40, 0x00, 0x40, 0x06,
+                      0x00, 0x00, 10,   0,    0,    1,    255,  255,  100,  9};
+
+    ASSERT_TRUE(parser.parse(data, sizeof(data)));
+    EXPECT_EQ(parser.packet().src_ip, Ipv4Address::from(data + 12));
+    EXPECT_EQ(to_string(parser.packet().dst_ip), "255.255.100.9");
+
+    std::ostringstream out;
+    parser.print(out);
+    EXPECT_NE(out.str().find("  Source IP: 10.0.0.1\n"), std::string::npos);
+    EXPECT_NE(out.str().find("  Destination IP: 255.255.100.9\n"), std::string::npos);
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include "latency.hpp"
+
+TEST(LatencyHistogramTest, EmptyHistogram) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.count(), 0u);
+    EXPECT_EQ(histogram.percentile(50), 0u);
+    EXPECT_EQ(histogram.max(), 0u);
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExact) {
+    LatencyHistogram histogram;
+    for (uint64_t ns = 1; ns <= 10; ++ns) {
+        histogram.record(ns);
+    }
+    EXPECT_EQ(histogram.count(), 10u);
+    EXPECT_EQ(histogram.percentile(50), 5u);
+    EXPECT_EQ(histogram.percentile(100), 10u);
+    EXPECT_EQ(histogram.percentile(0), 1u);
+}
+
+TEST(LatencyHistogramTest, PercentilesWithinBucketPrecision) {
+    LatencyHistogram histogram;
+    for (uint64_t us = 1; us <= 1000; ++us) {
+        histogram.record(us * 1000);
+    }
+
+    // buckets are 1/16 of a power of two wide, so the bound is at most ~6% above the value
+    const uint64_t p50 = histogram.percentile(50);
+    EXPECT_GE(p50, 500000u);
+    EXPECT_LE(p50, 500000u + 500000u / 16);
+
+    const uint64_t p99 = histogram.percentile(99);
+    EXPECT_GE(p99, 990000u);
+    EXPECT_LE(p99, 990000u + 990000u / 16);
+
+    EXPECT_EQ(histogram.percentile(100), 1000000u);
+    EXPECT_EQ(histogram.max(), 1000000u);
+}
+
+TEST(LatencyHistogramTest, HugeValuesDoNotOverflow) {
+    LatencyHistogram histogram;
+    histogram.record(UINT64_MAX);
+    histogram.record(1ULL << 63);
+    EXPECT_EQ(histogram.count(), 2u);
+    EXPECT_EQ(histogram.percentile(100), UINT64_MAX);
+    EXPECT_GE(histogram.percentile(50), 1ULL << 63);
+}
+
+TEST(LatencyHistogramTest, MergeAddsSamples) {
+    LatencyHistogram a;
+    LatencyHistogram b;
+    for (int i = 0; i < 90; ++i) {
+        a.record(1000);
+    }
+    for (int i = 0; i < 10; ++i) {
+        b.record(1000000);
+    }
+
+    a.merge(b);
+    EXPECT_EQ(a.count(), 100u);
+    EXPECT_EQ(a.max(), 1000000u);
+    EXPECT_LE(a.percentile(90), 1000u + 1000u / 16);
+    EXPECT_GE(a.percentile(91), 1000000u);
+}
+
+TEST(LatencyHistogramTest, ResetClearsSamples) {
+    LatencyHistogram histogram;
+    histogram.record(42);
+    histogram.reset();
+    EXPECT_EQ(histogram.count(), 0u);
+    EXPECT_EQ(histogram.max(), 0u);
+}
+
+TEST(LatencyHistogramTest, SummaryFormatsUnits) {
+    LatencyHistogram histogram;
+    histogram.record(500);
+    histogram.record(2500);
+    histogram.record(3000000);
+
+    std::string summary = histogram.summary();
+    // 2500 ns falls in the [2432, 2559] bucket, reported by its upper bound
+    EXPECT_NE(summary.find("p50 2.6 us"), std::string::npos) << summary;
+    EXPECT_NE(summary.find("max 3.0 ms"), std::string::npos) << summary;
+    EXPECT_NE(summary.find("(3 samples)"), std::string::npos) << summary;
+}
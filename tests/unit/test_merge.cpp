@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "merge.hpp"
+
+class FrameMergerTest : public ::testing::Test {
+protected:
+    FrameMerger merger;
+    std::vector<PacketView> delivered;
+    std::vector<std::vector<uint8_t>> payloads;
+
+    // the merger owns its copies, so the views are dereferenced during the callback only
+    void collect(const PacketView* packets, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            delivered.push_back(packets[i]);
+            payloads.emplace_back(packets[i].data, packets[i].data + packets[i].len);
+        }
+    }
+
+    size_t flush(uint64_t watermark) {
+        return merger.flush(watermark, [this](const PacketView* packets, size_t count) {
+            collect(packets, count);
+        });
+    }
+
+    static PacketView frame(const uint8_t* data, size_t len, uint64_t ts, int ifindex) {
+        PacketView packet{data, len, ts};
+        packet.ifindex = ifindex;
+        return packet;
+    }
+};
+
+TEST_F(FrameMergerTest, InterleavesSourcesByTimestamp) {
+    uint8_t a[3] = {1, 2, 3};
+    uint8_t b[2] = {4, 5};
+    PacketView first[2] = {frame(a, 3, 100, 1), frame(a, 1, 300, 1)};
+    PacketView second[2] = {frame(b, 2, 200, 2), frame(b, 1, 400, 2)};
+    merger.push(first, 2);
+    merger.push(second, 2);
+
+    ASSERT_EQ(flush(UINT64_MAX), 4u);
+    ASSERT_EQ(delivered.size(), 4u);
+    EXPECT_EQ(delivered[0].ts_ns, 100u);
+    EXPECT_EQ(delivered[1].ts_ns, 200u);
+    EXPECT_EQ(delivered[2].ts_ns, 300u);
+    EXPECT_EQ(delivered[3].ts_ns, 400u);
+    EXPECT_EQ(delivered[1].ifindex, 2);
+    EXPECT_EQ(payloads[0], std::vector<uint8_t>({1, 2, 3}));
+    EXPECT_EQ(payloads[1], std::vector<uint8_t>({4, 5}));
+    EXPECT_EQ(merger.pending(), 0u);
+}
+
+TEST_F(FrameMergerTest, HoldsFramesAfterWatermark) {
+    uint8_t data[4] = {9, 8, 7, 6};
+    PacketView batch[3] = {frame(data, 4, 50, 1), frame(data + 1, 3, 150, 1),
+                           frame(data + 2, 2, 250, 1)};
+    merger.push(batch, 3);
+
+    EXPECT_EQ(flush(10), 0u);
+    EXPECT_EQ(flush(150), 2u);
+    EXPECT_EQ(merger.pending(), 1u);
+
+    // the held frame survives compaction of the arena
+    EXPECT_EQ(flush(1000), 1u);
+    ASSERT_EQ(payloads.size(), 3u);
+    EXPECT_EQ(payloads[2], std::vector<uint8_t>({7, 6}));
+}
+
+TEST_F(FrameMergerTest, CopiesFramesOnPush) {
+    uint8_t data[2] = {1, 2};
+    PacketView packet = frame(data, 2, 10, 1);
+    merger.push(&packet, 1);
+    data[0] = 0xFF;
+
+    flush(10);
+    ASSERT_EQ(payloads.size(), 1u);
+    EXPECT_EQ(payloads[0][0], 1);
+}
+
+TEST_F(FrameMergerTest, EqualTimestampsKeepPushOrder) {
+    uint8_t data[1] = {0};
+    PacketView a = frame(data, 1, 7, 1);
+    PacketView b = frame(data, 1, 7, 2);
+    merger.push(&a, 1);
+    merger.push(&b, 1);
+
+    merger.flush_all([this](const PacketView* packets, size_t count) { collect(packets, count); });
+    ASSERT_EQ(delivered.size(), 2u);
+    EXPECT_EQ(delivered[0].ifindex, 1);
+    EXPECT_EQ(delivered[1].ifindex, 2);
+}
+
+TEST_F(FrameMergerTest, KeepsOriginalLength) {
+    uint8_t data[4] = {1, 2, 3, 4};
+    PacketView packet = frame(data, 4, 1, 3);
+    packet.orig_len = 1500;
+    merger.push(&packet, 1);
+
+    flush(1);
+    ASSERT_EQ(delivered.size(), 1u);
+    EXPECT_EQ(delivered[0].wire_len(), 1500u);
+}
+
+TEST_F(FrameMergerTest, KeepsDirectionAndVlanTag) {
+    uint8_t data[4] = {1, 2, 3, 4};
+    PacketView packet = frame(data, 4, 1, 3);
+    packet.direction = PacketDirection::Outbound;
+    packet.vlan_tci = 0xa00a;
+    packet.vlan_tpid = 0x8100;
+    merger.push(&packet, 1);
+
+    flush(1);
+    ASSERT_EQ(delivered.size(), 1u);
+    EXPECT_EQ(delivered[0].direction, PacketDirection::Outbound);
+    EXPECT_TRUE(delivered[0].has_vlan());
+    EXPECT_EQ(delivered[0].vlan_id(), 10);
+    EXPECT_EQ(delivered[0].vlan_tci, 0xa00a);
+}
@@ -3,6 +3,7 @@
 #include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <vector>
 
 #include "export/pcap.hpp"
 
@@ -330,3 +331,213 @@ TEST_F(PcapWriterTest, ConsecutiveOpenClose) {
 
     EXPECT_TRUE(file_exists(path));
 }
+
+TEST_F(PcapWriterTest, WritePacketBatch) {
+    std::string path = get_test_file("batch.pcap");
+    ASSERT_TRUE(writer.open(path));
+
+    uint8_t first[] = {0x01, 0x02, 0x03};
+    uint8_t second[] = {0x04, 0x05};
+    PacketView batch[] = {{first, sizeof(first)}, {second, sizeof(second)}};
+    writer.write_packets(batch, 2);
+    writer.close();
+
+    EXPECT_EQ(file_size(path), 24 + 2 * 16 + sizeof(first) + sizeof(second));
+}
+
+TEST_F(PcapWriterTest, NanosecondMagic) {
+    std::string path = get_test_file("nano_magic.pcap");
+    ASSERT_TRUE(writer.open(path, PcapTimestampPrecision::Nano));
+    writer.close();
+
+    std::ifstream file(path, std::ios::binary);
+    uint32_t magic;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    EXPECT_EQ(magic, 0xa1b23c4d);
+}
+
+TEST_F(PcapWriterTest, NanosecondTimestampPreserved) {
+    std::string path = get_test_file("nano_ts.pcap");
+    ASSERT_TRUE(writer.open(path, PcapTimestampPrecision::Nano));
+
+    uint8_t packet[] = {0x01, 0x02};
+    writer.write_packet(packet, sizeof(packet), 1700000000123456789ULL);
+    writer.close();
+
+    std::ifstream file(path, std::ios::binary);
+    file.seekg(24);
+    PcapPacketHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    EXPECT_EQ(header.ts_sec, 1700000000u);
+    EXPECT_EQ(header.ts_usec, 123456789u);
+}
+
+TEST_F(PcapWriterTest, MicrosecondTimestampTruncated) {
+    std::string path = get_test_file("micro_ts.pcap");
+    ASSERT_TRUE(writer.open(path));
+
+    uint8_t packet[] = {0x01, 0x02};
+    writer.write_packet(packet, sizeof(packet), 1700000000123456789ULL);
+    writer.close();
+
+    std::ifstream file(path, std::ios::binary);
+    file.seekg(24);
+    PcapPacketHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    EXPECT_EQ(header.ts_sec, 1700000000u);
+    EXPECT_EQ(header.ts_usec, 123456u);
+}
+
+TEST_F(PcapWriterTest, BatchUsesPacketTimestamps) {
+    std::string path = get_test_file("batch_ts.pcap");
+    ASSERT_TRUE(writer.open(path, PcapTimestampPrecision::Nano));
+
+    uint8_t data[] = {0xAA};
+    PacketView batch[] = {{data, 1, 5000000001ULL}, {data, 1, 5000000002ULL}};
+    writer.write_packets(batch, 2);
+    writer.close();
+
+    std::ifstream file(path, std::ios::binary);
+    PcapPacketHeader first;
+    PcapPacketHeader second;
+    file.seekg(24);
+    file.read(reinterpret_cast<char*>(&first), sizeof(first));
+    file.seekg(24 + 16 + 1);
+    file.read(reinterpret_cast<char*>(&second), sizeof(second));
+    EXPECT_EQ(first.ts_sec, 5u);
+    EXPECT_EQ(first.ts_usec, 1u);
+    EXPECT_EQ(second.ts_usec, 2u);
+}
+
+TEST_F(PcapWriterTest, SnaplenInGlobalHeader) {
+    std::string path = get_test_file("snaplen_header.pcap");
+    ASSERT_TRUE(writer.open(path, PcapTimestampPrecision::Nano, 96));
+    writer.close();
+
+    std::ifstream file(path, std::ios::binary);
+    PcapGlobalHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    EXPECT_EQ(header.snaplen, 96u);
+}
+
+TEST_F(PcapWriterTest, DefaultSnaplenKeepsWholeSuperFrames) {
+    std::string path = get_test_file("snaplen_default.pcap");
+    ASSERT_TRUE(writer.open(path));
+
+    // a full 64 KB IP packet read with GSO, one byte too long for the old 65535 default
+    std::vector<uint8_t> frame(14 + 65535, 0x5A);
+    PacketView packet{frame.data(), frame.size(), 1};
+    writer.write_packets(&packet, 1);
+    writer.close();
+
+    std::ifstream file(path, std::ios::binary);
+    PcapGlobalHeader global;
+    file.read(reinterpret_cast<char*>(&global), sizeof(global));
+    EXPECT_EQ(global.snaplen, DEFAULT_SNAPLEN);
+    PcapPacketHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    EXPECT_EQ(header.incl_len, frame.size());
+    EXPECT_EQ(header.orig_len, frame.size());
+}
+
+TEST_F(PcapWriterTest, TruncatesToSnaplenAndKeepsOrigLen) {
+    std::string path = get_test_file("snaplen_truncate.pcap");
+    ASSERT_TRUE(writer.open(path, PcapTimestampPrecision::Micro, 16));
+
+    uint8_t packet[100];
+    memset(packet, 0xAB, sizeof(packet));
+    writer.write_packet(packet, sizeof(packet));
+    writer.close();
+
+    EXPECT_EQ(file_size(path), 24 + 16 + 16u);
+
+    std::ifstream file(path, std::ios::binary);
+    file.seekg(24);
+    PcapPacketHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    EXPECT_EQ(header.incl_len, 16u);
+    EXPECT_EQ(header.orig_len, 100u);
+}
+
+TEST_F(PcapWriterTest, OrigLenOfTruncatedCapture) {
+    std::string path = get_test_file("orig_len.pcap");
+    ASSERT_TRUE(writer.open(path, PcapTimestampPrecision::Nano, 64));
+
+    // the kernel already cut these frames to 64 bytes
+    uint8_t data[64] = {0};
+    PacketView batch[] = {{data, 64, 1, 1514}, {data, 42, 2}};
+    writer.write_packets(batch, 2);
+    writer.close();
+
+    std::ifstream file(path, std::ios::binary);
+    file.seekg(24);
+    PcapPacketHeader first;
+    file.read(reinterpret_cast<char*>(&first), sizeof(first));
+    file.seekg(64, std::ios::cur);
+    PcapPacketHeader second;
+    file.read(reinterpret_cast<char*>(&second), sizeof(second));
+
+    EXPECT_EQ(first.incl_len, 64u);
+    EXPECT_EQ(first.orig_len, 1514u);
+    EXPECT_EQ(second.incl_len, 42u);
+    EXPECT_EQ(second.orig_len, 42u);
+}
+
+TEST_F(PcapWriterTest, ReinsertsStrippedVlanTag) {
+    std::string path = get_test_file("vlan.pcap");
+    ASSERT_TRUE(writer.open(path, PcapTimestampPrecision::Nano, 14));
+
+    // untagged ARP header as delivered, with the tag in the metadata
+    uint8_t data[20] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xAA, 0xBB, 0xCC,
+                        0xDD, 0xEE, 0xFF, 0x08, 0x06, 0x00, 0x01, 0x08, 0x00};
+    PacketView packet{data, sizeof(data), 1};
+    packet.vlan_tci = 0xa00a;
+    packet.vlan_tpid = 0x88a8;
+    writer.write_packets(&packet, 1);
+    writer.close();
+
+    std::ifstream file(path, std::ios::binary);
+    file.seekg(24);
+    PcapPacketHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    EXPECT_EQ(header.incl_len, 14u);  // cut by the snap length inside the tag
+    EXPECT_EQ(header.orig_len, 24u);
+
+    uint8_t written[14];
+    file.read(reinterpret_cast<char*>(written), sizeof(written));
+    EXPECT_EQ(std::memcmp(written, data, 12), 0);
+    EXPECT_EQ(written[12], 0x88);
+    EXPECT_EQ(written[13], 0xa8);
+    EXPECT_EQ(data[12], 0x08);  // the captured frame itself is left alone
+}
+
+TEST_F(PcapWriterTest, SegmentsGsoSuperFramesWhenAsked) {
+    std::string path = get_test_file("gso.pcap");
+    ASSERT_TRUE(writer.open(path));
+    writer.set_segment_gso(true);
+
+    // IPv6/UDP with 2500 payload bytes sent as 1000-byte datagrams
+    std::vector<uint8_t> frame(14 + 40 + 8 + 2500, 0);
+    frame[12] = 0x86;
+    frame[13] = 0xDD;
+    frame[14] = 0x60;
+    frame[14 + 6] = 17;
+    PacketView packets[2] = {{frame.data(), frame.size(), 0}, {frame.data(), 60, 0}};
+    packets[0].gso.type = 5;
+    packets[0].gso.size = 1000;
+    writer.write_packets(packets, 2);
+    writer.close();
+
+    std::ifstream file(path, std::ios::binary);
+    file.seekg(24);
+    const uint32_t lengths[4] = {1062, 1062, 562, 60};
+    for (uint32_t expected : lengths) {
+        PcapPacketHeader header;
+        ASSERT_TRUE(file.read(reinterpret_cast<char*>(&header), sizeof(header)));
+        EXPECT_EQ(header.incl_len, expected);
+        EXPECT_EQ(header.orig_len, expected);
+        std::vector<char> data(header.incl_len);
+        file.read(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+    EXPECT_EQ(file.peek(), EOF);
+}
@@ -0,0 +1,374 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "export/pcapng.hpp"
+
+namespace fs = std::filesystem;
+
+class PcapngWriterTest : public ::testing::Test {
+protected:
+    PcapngWriter writer;
+    std::string test_dir = "/tmp/pcapng_test";
+
+    struct Block {
+        uint32_t type;
+        std::vector<uint8_t> body;  // everything between the two length fields
+    };
+
+    void SetUp() override {
+        fs::create_directories(test_dir);
+    }
+
+    void TearDown() override {
+        fs::remove_all(test_dir);
+    }
+
+    std::string get_test_file(const std::string& name) {
+        return test_dir + "/" + name;
+    }
+
+    static uint32_t u32(const std::vector<uint8_t>& bytes, size_t offset) {
+        uint32_t value;
+        std::memcpy(&value, bytes.data() + offset, sizeof(value));
+        return value;
+    }
+
+    // splits the file into blocks, checking both length fields of every one
+    std::vector<Block> read_blocks(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)),
+                                   std::istreambuf_iterator<char>());
+
+        std::vector<Block> blocks;
+        size_t offset = 0;
+        while (offset + 12 <= bytes.size()) {
+            uint32_t type = u32(bytes, offset);
+            uint32_t total = u32(bytes, offset + 4);
+            EXPECT_EQ(total % 4, 0u);
+            if (total < 12 || offset + total > bytes.size()) {
+                ADD_FAILURE() << "truncated block at " << offset;
+                break;
+            }
+            EXPECT_EQ(u32(bytes, offset + total - 4), total);
+            blocks.push_back({type, std::vector<uint8_t>(bytes.begin() + offset + 8,
+                                                         bytes.begin() + offset + total - 4)});
+            offset += total;
+        }
+        EXPECT_EQ(offset, bytes.size());
+        return blocks;
+    }
+};
+
+TEST_F(PcapngWriterTest, AutoAddPcapngExtension) {
+    ASSERT_TRUE(writer.open(get_test_file("test")));
+    writer.close();
+    EXPECT_TRUE(fs::exists(get_test_file("test.pcapng")));
+}
+
+TEST_F(PcapngWriterTest, StartsWithSectionHeader) {
+    std::string path = get_test_file("shb.pcapng");
+    ASSERT_TRUE(writer.open(path));
+    writer.close();
+
+    auto blocks = read_blocks(path);
+    ASSERT_EQ(blocks.size(), 1u);
+    EXPECT_EQ(blocks[0].type, 0x0A0D0D0Au);
+    EXPECT_EQ(u32(blocks[0].body, 0), 0x1A2B3C4Du);
+    EXPECT_EQ(u32(blocks[0].body, 4), 1u);  // version 1.0
+}
+
+TEST_F(PcapngWriterTest, DescribesEachInterfaceOnce) {
+    std::string path = get_test_file("interfaces.pcapng");
+    ASSERT_TRUE(writer.open(path, 128));
+    writer.add_interface("vt0", 7);
+    writer.add_interface("vt0", 7);
+
+    uint8_t data[60] = {};
+    PacketView packets[3] = {{data, 60, 1}, {data, 60, 2}, {data, 60, 3}};
+    packets[0].ifindex = 7;
+    packets[1].ifindex = 9;
+    packets[2].ifindex = 7;
+    writer.write_packets(packets, 3);
+    writer.close();
+
+    auto blocks = read_blocks(path);
+    ASSERT_EQ(blocks.size(), 6u);
+    EXPECT_EQ(blocks[1].type, 1u);
+    EXPECT_EQ(u32(blocks[1].body, 0), 1u);    // LINKTYPE_ETHERNET
+    EXPECT_EQ(u32(blocks[1].body, 4), 128u);  // snaplen
+    std::string options(blocks[1].body.begin() + 8, blocks[1].body.end());
+    EXPECT_NE(options.find("vt0"), std::string::npos);
+
+    // the unknown ifindex 9 is described right before its first frame
+    EXPECT_EQ(blocks[2].type, 6u);
+    EXPECT_EQ(blocks[3].type, 1u);
+    EXPECT_EQ(blocks[4].type, 6u);
+    EXPECT_EQ(blocks[5].type, 6u);
+    EXPECT_EQ(u32(blocks[2].body, 0), 0u);
+    EXPECT_EQ(u32(blocks[4].body, 0), 1u);
+    EXPECT_EQ(u32(blocks[5].body, 0), 0u);
+}
+
+TEST_F(PcapngWriterTest, EnhancedPacketBlockFields) {
+    std::string path = get_test_file("epb.pcapng");
+    ASSERT_TRUE(writer.open(path, 4));
+
+    uint8_t data[7] = {1, 2, 3, 4, 5, 6, 7};
+    const uint64_t ts = 0x0000000123456789ULL * 1000;
+    PacketView packet{data, 7, ts, 1500};
+    packet.ifindex = 3;
+    writer.write_packets(&packet, 1);
+    writer.close();
+
+    auto blocks = read_blocks(path);
+    ASSERT_EQ(blocks.size(), 3u);
+    const auto& epb = blocks[2].body;
+    EXPECT_EQ(u32(epb, 4), static_cast<uint32_t>(ts >> 32));
+    EXPECT_EQ(u32(epb, 8), static_cast<uint32_t>(ts));
+    EXPECT_EQ(u32(epb, 12), 4u);     // captured, cut to the snap length
+    EXPECT_EQ(u32(epb, 16), 1500u);  // on the wire
+    EXPECT_EQ(epb.size(), 20u + 4u);
+    EXPECT_EQ(std::vector<uint8_t>(epb.begin() + 20, epb.end()),
+              std::vector<uint8_t>({1, 2, 3, 4}));
+}
+
+TEST_F(PcapngWriterTest, DefaultSnaplenKeepsWholeSuperFrames) {
+    std::string path = get_test_file("snaplen_default.pcapng");
+    ASSERT_TRUE(writer.open(path));
+
+    std::vector<uint8_t> frame(14 + 65535, 0x5A);
+    PacketView packet{frame.data(), frame.size(), 1};
+    writer.write_packets(&packet, 1);
+    writer.close();
+
+    auto blocks = read_blocks(path);
+    ASSERT_EQ(blocks.size(), 3u);
+    EXPECT_EQ(u32(blocks[1].body, 4), DEFAULT_SNAPLEN);
+    EXPECT_EQ(u32(blocks[2].body, 12), frame.size());
+    EXPECT_EQ(u32(blocks[2].body, 16), frame.size());
+}
+
+TEST_F(PcapngWriterTest, PadsPacketDataToFourBytes) {
+    std::string path = get_test_file("pad.pcapng");
+    ASSERT_TRUE(writer.open(path));
+
+    uint8_t data[5] = {1, 2, 3, 4, 5};
+    PacketView packet{data, 5, 0};
+    writer.write_packets(&packet, 1);
+    writer.close();
+
+    auto blocks = read_blocks(path);
+    ASSERT_EQ(blocks.size(), 3u);
+    EXPECT_EQ(blocks[2].body.size(), 20u + 8u);
+}
+
+TEST_F(PcapngWriterTest, DirectionGoesIntoEpbFlags) {
+    std::string path = get_test_file("flags.pcapng");
+    ASSERT_TRUE(writer.open(path));
+
+    uint8_t data[4] = {1, 2, 3, 4};
+    PacketView packets[3] = {{data, 4, 0}, {data, 4, 0}, {data, 4, 0}};
+    packets[0].direction = PacketDirection::Inbound;
+    packets[1].direction = PacketDirection::Outbound;
+    writer.write_packets(packets, 3);
+    writer.close();
+
+    auto blocks = read_blocks(path);
+    ASSERT_EQ(blocks.size(), 5u);
+    for (uint32_t i = 0; i < 2; ++i) {
+        const auto& epb = blocks[2 + i].body;
+        ASSERT_EQ(epb.size(), 20u + 4u + 8u + 4u);
+        EXPECT_EQ(u32(epb, 24), 2u | (4u << 16));  // epb_flags, 4 bytes
+        EXPECT_EQ(u32(epb, 28), i + 1);            // 1 inbound, 2 outbound
+        EXPECT_EQ(u32(epb, 32), 0u);               // opt_endofopt
+    }
+    EXPECT_EQ(blocks[4].body.size(), 20u + 4u);  // unknown direction, no options
+}
+
+TEST_F(PcapngWriterTest, PacketTypeGoesIntoReceptionBits) {
+    std::string path = get_test_file("reception.pcapng");
+    ASSERT_TRUE(writer.open(path));
+
+    uint8_t data[4] = {1, 2, 3, 4};
+    PacketView packets[4] = {{data, 4, 0}, {data, 4, 0}, {data, 4, 0}, {data, 4, 0}};
+    const PacketType types[4] = {PacketType::Host, PacketType::Multicast, PacketType::Broadcast,
+                                 PacketType::OtherHost};
+    for (size_t i = 0; i < 4; ++i) {
+        packets[i].direction = PacketDirection::Inbound;
+        packets[i].type = types[i];
+    }
+    writer.write_packets(packets, 4);
+    writer.close();
+
+    auto blocks = read_blocks(path);
+    ASSERT_EQ(blocks.size(), 6u);
+    for (uint32_t i = 0; i < 4; ++i) {
+        const auto& epb = blocks[2 + i].body;
+        ASSERT_EQ(epb.size(), 20u + 4u + 8u + 4u);
+        EXPECT_EQ(u32(epb, 28), 1u | ((i + 1) << 2));  // inbound; unicast to promiscuous
+    }
+}
+
+TEST_F(PcapngWriterTest, DeclaredInterfaceComesFirst) {
+    std::string path = get_test_file("declared.pcapng");
+    ASSERT_TRUE(writer.open(path));
+    writer.add_interface("any", 0);
+    writer.add_interface("any", 0);  // declared once
+
+    uint8_t data[4] = {1, 2, 3, 4};
+    PacketView packet{data, 4, 0};
+    packet.ifindex = 5;
+    writer.write_packets(&packet, 1);
+    writer.close();
+
+    auto blocks = read_blocks(path);
+    ASSERT_EQ(blocks.size(), 4u);
+    EXPECT_EQ(blocks[1].type, 1u);
+    const std::string name(blocks[1].body.begin() + 12, blocks[1].body.begin() + 15);
+    EXPECT_EQ(name, "any");
+    EXPECT_EQ(blocks[2].type, 1u);
+    EXPECT_EQ(u32(blocks[3].body, 0), 1u);  // the frame's own interface, id 1
+}
+
+TEST_F(PcapngWriterTest, ReinsertsStrippedVlanTag) {
+    std::string path = get_test_file("vlan.pcapng");
+    ASSERT_TRUE(writer.open(path));
+
+    uint8_t data[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 0x08, 0x00, 0x45, 0x00};
+    PacketView packet{data, sizeof(data), 0, 60};
+    packet.vlan_tci = 0x0064;
+    packet.vlan_tpid = 0x8100;
+    writer.write_packets(&packet, 1);
+    writer.close();
+
+    auto blocks = read_blocks(path);
+    ASSERT_EQ(blocks.size(), 3u);
+    const auto& epb = blocks[2].body;
+    EXPECT_EQ(u32(epb, 12), 20u);  // captured
+    EXPECT_EQ(u32(epb, 16), 64u);  // on the wire
+    const std::vector<uint8_t> tagged(epb.begin() + 20, epb.begin() + 40);
+    EXPECT_EQ(tagged, std::vector<uint8_t>({1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 0x81, 0x00,
+                                            0x00, 0x64, 0x08, 0x00, 0x45, 0x00}));
+}
+
+TEST_F(PcapngWriterTest, WriteWithoutOpen) {
+    uint8_t data[14] = {};
+    PacketView packet{data, 14, 0};
+    writer.write_packets(&packet, 1);
+    EXPECT_FALSE(writer.is_open());
+}
+
+TEST_F(PcapngWriterTest, InterfaceStatisticsBlock) {
+    std::string path = get_test_file("isb.pcapng");
+    ASSERT_TRUE(writer.open(path));
+    writer.add_interface("vt0", 4);
+
+    InterfaceStatistics stats;
+    stats.ts_ns = 5000000000ULL;
+    stats.received = 1200;
+    stats.dropped = 34;
+    stats.delivered = 1166;
+    writer.write_statistics(4, stats);
+    writer.close();
+
+    auto blocks = read_blocks(path);
+    ASSERT_EQ(blocks.size(), 3u);
+    const auto& isb = blocks[2].body;
+    EXPECT_EQ(blocks[2].type, 5u);
+    EXPECT_EQ(u32(isb, 0), 0u);
+    EXPECT_EQ(u32(isb, 4), static_cast<uint32_t>(stats.ts_ns >> 32));
+    EXPECT_EQ(u32(isb, 8), static_cast<uint32_t>(stats.ts_ns));
+
+    // isb_filteraccept, isb_osdrop and isb_usrdeliv, 8-byte values each
+    const uint16_t codes[3] = {6, 7, 8};
+    const uint64_t values[3] = {1200, 34, 1166};
+    for (size_t i = 0; i < 3; ++i) {
+        const size_t option = 12 + i * 12;
+        uint16_t code;
+        uint16_t len;
+        uint64_t value;
+        std::memcpy(&code, isb.data() + option, 2);
+        std::memcpy(&len, isb.data() + option + 2, 2);
+        std::memcpy(&value, isb.data() + option + 4, 8);
+        EXPECT_EQ(code, codes[i]);
+        EXPECT_EQ(len, 8u);
+        EXPECT_EQ(value, values[i]);
+    }
+}
+
+TEST_F(PcapngWriterTest, GsoSuperFrameKeptWithCommentOrSegmented) {
+    std::string path = get_test_file("gso.pcapng");
+    ASSERT_TRUE(writer.open(path));
+
+    // IPv4/TCP with 30 payload bytes standing for three 10-byte segments
+    std::vector<uint8_t> frame(14 + 20 + 20 + 30, 0);
+    frame[12] = 0x08;
+    frame[14] = 0x45;
+    frame[14 + 9] = 6;
+    frame[34 + 12] = 0x50;
+    PacketView packet{frame.data(), frame.size(), 0};
+    packet.gso.type = 1;
+    packet.gso.size = 10;
+    writer.write_packets(&packet, 1);
+    writer.set_segment_gso(true);
+    writer.write_packets(&packet, 1);
+    writer.close();
+
+    auto blocks = read_blocks(path);
+    ASSERT_EQ(blocks.size(), 2u + 1u + 3u);
+    const auto& whole = blocks[2].body;
+    EXPECT_EQ(u32(whole, 12), 84u);
+    const std::string comment = "GSO tcpv4, 10-byte segments";
+    const size_t options = 20 + 84;
+    EXPECT_EQ(u32(whole, options), 1u | static_cast<uint32_t>(comment.size()) << 16);
+    EXPECT_EQ(std::string(whole.begin() + options + 4,
+                          whole.begin() + options + 4 + static_cast<long>(comment.size())),
+              comment);
+
+    for (size_t i = 3; i < 6; ++i) {
+        EXPECT_EQ(u32(blocks[i].body, 12), 64u);  // headers and one segment, no options
+        EXPECT_EQ(blocks[i].body.size(), 20u + 64u);
+    }
+}
+
+TEST_F(PcapngWriterTest, ShedIntervalBlockHasTimesAndComment) {
+    std::string path = get_test_file("shed.pcapng");
+    ASSERT_TRUE(writer.open(path));
+    writer.add_interface("vt0", 4);
+
+    ShedInterval interval;
+    interval.level = ShedLevel::Headers;
+    interval.header_bytes = 96;
+    interval.start_ns = 5000000000ULL;
+    interval.end_ns = 5250000000ULL;
+    interval.frames = 10;
+    interval.cut = 8;
+    interval.peak_fill = 0.6;
+    writer.write_shed_interval(4, interval);
+    writer.close();
+
+    auto blocks = read_blocks(path);
+    ASSERT_EQ(blocks.size(), 3u);
+    const auto& isb = blocks[2].body;
+    EXPECT_EQ(blocks[2].type, 5u);
+    EXPECT_EQ(u32(isb, 4), static_cast<uint32_t>(interval.end_ns >> 32));
+    EXPECT_EQ(u32(isb, 8), static_cast<uint32_t>(interval.end_ns));
+
+    // isb_starttime and isb_endtime, then the comment; no counters
+    EXPECT_EQ(u32(isb, 12), 2u | 8u << 16);
+    EXPECT_EQ(u32(isb, 16), static_cast<uint32_t>(interval.start_ns >> 32));
+    EXPECT_EQ(u32(isb, 20), static_cast<uint32_t>(interval.start_ns));
+    EXPECT_EQ(u32(isb, 24), 3u | 8u << 16);
+    EXPECT_EQ(u32(isb, 32), static_cast<uint32_t>(interval.end_ns));
+    const std::string comment =
+        "Load shedding: frames cut to 96 bytes, 0.25 s: 10 frames, 8 cut, 0 skipped, 60% full";
+    EXPECT_EQ(u32(isb, 36), 1u | static_cast<uint32_t>(comment.size()) << 16);
+    EXPECT_EQ(std::string(isb.begin() + 40, isb.begin() + 40 + static_cast<long>(comment.size())),
+              comment);
+}
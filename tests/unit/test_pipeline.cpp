@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <net/if.h>
+
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include "export/pcap.hpp"
+#include "parsers/protocol_parser.hpp"
+#include "pipeline.hpp"
+
+namespace fs = std::filesystem;
+
+class PipelineTest : public ::testing::Test {
+protected:
+    CliOptions opts;
+    std::string test_dir = "/tmp/pipeline_test";
+
+    // broadcast ARP request
+    uint8_t arp_frame[42] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE,
+                             0xFF, 0x08, 0x06, 0x00, 0x01, 0x08, 0x00, 0x06, 0x04, 0x00, 0x01,
+                             0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF, 10,   0,    0,    1,    0x00,
+                             0x00, 0x00, 0x00, 0x00, 0x00, 10,   0,    0,    2};
+
+    void SetUp() override {
+        fs::create_directories(test_dir);
+    }
+
+    void TearDown() override {
+        fs::remove_all(test_dir);
+    }
+};
+
+TEST_F(PipelineTest, CountsValidFrames) {
+    Pipeline pipeline(opts, nullptr);
+    for (int i = 0; i < 3; ++i) {
+        pipeline.on_frame(arp_frame, sizeof(arp_frame));
+    }
+    EXPECT_EQ(pipeline.packet_count(), 3u);
+}
+
+TEST_F(PipelineTest, IgnoresRuntFrames) {
+    Pipeline pipeline(opts, nullptr);
+    pipeline.on_frame(arp_frame, 13);
+    EXPECT_EQ(pipeline.packet_count(), 0u);
+}
+
+TEST_F(PipelineTest, WritesToOwnWriter) {
+    std::string path = test_dir + "/pipeline.pcap";
+    PcapWriter writer;
+    ASSERT_TRUE(writer.open(path));
+
+    Pipeline pipeline(opts, &writer, 0);
+    pipeline.on_frame(arp_frame, sizeof(arp_frame));
+    pipeline.on_frame(arp_frame, sizeof(arp_frame));
+    writer.close();
+
+    EXPECT_EQ(fs::file_size(path), 24 + 2 * (16 + sizeof(arp_frame)));
+}
+
+TEST_F(PipelineTest, IndependentCountersPerPipeline) {
+    Pipeline first(opts, nullptr, 0);
+    Pipeline second(opts, nullptr, 1);
+
+    std::thread t1([&]() {
+        for (int i = 0; i < 100; ++i) {
+            first.on_frame(arp_frame, sizeof(arp_frame));
+        }
+    });
+    std::thread t2([&]() {
+        for (int i = 0; i < 50; ++i) {
+            second.on_frame(arp_frame, sizeof(arp_frame));
+        }
+    });
+    t1.join();
+    t2.join();
+
+    EXPECT_EQ(first.packet_count(), 100u);
+    EXPECT_EQ(second.packet_count(), 50u);
+}
+
+TEST_F(PipelineTest, ParsersArePerThread) {
+    ProtocolParser* main_parser = ProtocolParser::get_parser(0x0806);
+    ProtocolParser* other_parser = nullptr;
+
+    std::thread t([&]() { other_parser = ProtocolParser::get_parser(0x0806); });
+    t.join();
+
+    ASSERT_NE(main_parser, nullptr);
+    ASSERT_NE(other_parser, nullptr);
+    EXPECT_NE(main_parser, other_parser);
+    EXPECT_EQ(main_parser, ProtocolParser::get_parser(0x0806));
+}
+
+TEST_F(PipelineTest, BatchStopsAtPacketLimit) {
+    std::string path = test_dir + "/limit.pcap";
+    PcapWriter writer;
+    ASSERT_TRUE(writer.open(path));
+
+    Pipeline pipeline(opts, &writer);
+    pipeline.set_packet_limit(3);
+
+    PacketView batch[5];
+    for (auto& packet : batch) {
+        packet = {arp_frame, sizeof(arp_frame)};
+    }
+    pipeline.on_batch(batch, 5);
+    writer.close();
+
+    EXPECT_TRUE(pipeline.limit_reached());
+    EXPECT_EQ(pipeline.packet_count(), 3u);
+    EXPECT_EQ(fs::file_size(path), 24 + 3 * (16 + sizeof(arp_frame)));
+}
+
+TEST_F(PipelineTest, BatchSkipsRuntFrames) {
+    std::string path = test_dir + "/runt.pcap";
+    PcapWriter writer;
+    ASSERT_TRUE(writer.open(path));
+
+    Pipeline pipeline(opts, &writer);
+    PacketView batch[3] = {{arp_frame, sizeof(arp_frame)}, {arp_frame, 10},
+                           {arp_frame, sizeof(arp_frame)}};
+    pipeline.on_batch(batch, 3);
+    writer.close();
+
+    EXPECT_EQ(pipeline.packet_count(), 2u);
+    EXPECT_EQ(fs::file_size(path), 24 + 2 * (16 + sizeof(arp_frame)));
+}
+
+TEST_F(PipelineTest, RecordOnlyExportsWithoutPrinting) {
+    std::string path = test_dir + "/record.pcap";
+    PcapWriter writer;
+    ASSERT_TRUE(writer.open(path));
+
+    opts.record_only = true;
+    Pipeline pipeline(opts, &writer);
+    pipeline.set_packet_limit(3);
+    PacketView batch[5] = {{arp_frame, sizeof(arp_frame)}, {arp_frame, 10},
+                           {arp_frame, sizeof(arp_frame)}, {arp_frame, sizeof(arp_frame)},
+                           {arp_frame, sizeof(arp_frame)}};
+
+    std::ostringstream console;
+    std::streambuf* saved = std::cout.rdbuf(console.rdbuf());
+    pipeline.on_batch(batch, 5);
+    std::cout.rdbuf(saved);
+    writer.close();
+
+    EXPECT_TRUE(console.str().empty());
+    EXPECT_EQ(pipeline.packet_count(), 3u);
+    EXPECT_EQ(fs::file_size(path), 24 + 3 * (16 + sizeof(arp_frame)));
+}
+
+TEST_F(PipelineTest, LabelsFramesWithInterfaceAndPacketType) {
+    const int loopback = static_cast<int>(if_nametoindex("lo"));
+    ASSERT_GT(loopback, 0);
+
+    Pipeline pipeline(opts, nullptr);
+    pipeline.label_interfaces();
+    PacketView batch[2] = {{arp_frame, sizeof(arp_frame)}, {arp_frame, sizeof(arp_frame)}};
+    batch[0].ifindex = loopback;
+    batch[0].direction = PacketDirection::Inbound;
+    batch[0].type = PacketType::Broadcast;
+    batch[1].ifindex = loopback;
+    batch[1].direction = PacketDirection::Outbound;
+    batch[1].type = PacketType::Outgoing;
+
+    std::ostringstream console;
+    std::streambuf* saved = std::cout.rdbuf(console.rdbuf());
+    pipeline.on_batch(batch, 2);
+    std::cout.rdbuf(saved);
+
+    EXPECT_NE(console.str().find("] lo | in broadcast | 42 bytes"), std::string::npos);
+    EXPECT_NE(console.str().find("] lo | out | 42 bytes"), std::string::npos);
+}
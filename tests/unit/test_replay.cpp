@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "export/pcap.hpp"
+#include "export/pcapng.hpp"
+#include "replay.hpp"
+
+namespace fs = std::filesystem;
+
+class PcapReaderTest : public ::testing::Test {
+protected:
+    PcapReader reader;
+    std::string test_dir = "/tmp/pcap_reader_test";
+
+    void SetUp() override {
+        fs::create_directories(test_dir);
+    }
+
+    void TearDown() override {
+        reader.close();
+        fs::remove_all(test_dir);
+    }
+
+    std::string get_test_file(const std::string& name) {
+        return test_dir + "/" + name;
+    }
+
+    static std::vector<uint8_t> frame(uint8_t fill, size_t len) {
+        std::vector<uint8_t> bytes(len, fill);
+        bytes[12] = 0x08;
+        bytes[13] = 0x00;
+        return bytes;
+    }
+
+    // three frames 1.5 ms apart, the second cut to 40 of its 100 bytes
+    void write_file(const std::string& path, PcapTimestampPrecision precision) {
+        PcapWriter writer;
+        ASSERT_TRUE(writer.open(path, precision));
+        const uint64_t base = 1700000000ULL * 1000000000ULL + 123456000ULL;
+        writer.write_packet(frame(0x11, 60).data(), 60, base);
+        writer.write_packet(frame(0x22, 40).data(), 40, base + 1500000, 100);
+        writer.write_packet(frame(0x33, 1514).data(), 1514, base + 3000000);
+        writer.close();
+    }
+};
+
+TEST_F(PcapReaderTest, ReadsMicrosecondAndNanosecondFiles) {
+    for (auto precision : {PcapTimestampPrecision::Micro, PcapTimestampPrecision::Nano}) {
+        const std::string path = get_test_file("frames.pcap");
+        write_file(path, precision);
+        ASSERT_TRUE(reader.open(path));
+
+        const std::vector<PacketView>& frames = reader.frames();
+        ASSERT_EQ(frames.size(), 3u);
+        EXPECT_EQ(frames[0].len, 60u);
+        EXPECT_EQ(frames[0].data[0], 0x11);
+        EXPECT_EQ(frames[1].len, 40u);
+        EXPECT_EQ(frames[1].orig_len, 100u);
+        EXPECT_EQ(frames[2].len, 1514u);
+        EXPECT_EQ(frames[2].data[1513], 0x33);
+
+        EXPECT_EQ(frames[0].ts_ns, 1700000000ULL * 1000000000ULL + 123456000ULL);
+        EXPECT_EQ(frames[1].ts_ns - frames[0].ts_ns, 1500000u);
+        EXPECT_EQ(frames[2].ts_ns - frames[0].ts_ns, 3000000u);
+        reader.close();
+    }
+}
+
+TEST_F(PcapReaderTest, ReadsSwappedByteOrder) {
+    const std::string path = get_test_file("swapped.pcap");
+    write_file(path, PcapTimestampPrecision::Micro);
+
+    // rewrite every header field big-endian, as a capture from a big-endian host would have it
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(file)), {});
+    auto swap32 = [&bytes](size_t offset) {
+        std::swap(bytes[offset], bytes[offset + 3]);
+        std::swap(bytes[offset + 1], bytes[offset + 2]);
+    };
+    auto swap16 = [&bytes](size_t offset) { std::swap(bytes[offset], bytes[offset + 1]); };
+    swap32(0);
+    swap16(4);
+    swap16(6);
+    for (size_t offset : {8, 12, 16, 20}) {
+        swap32(offset);
+    }
+    for (size_t offset = 24; offset < bytes.size();) {
+        uint32_t incl_len;
+        std::memcpy(&incl_len, &bytes[offset + 8], sizeof(incl_len));
+        for (size_t field = 0; field < 16; field += 4) {
+            swap32(offset + field);
+        }
+        offset += 16 + incl_len;
+    }
+    file.seekp(0);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    file.close();
+
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_EQ(reader.frames().size(), 3u);
+    EXPECT_EQ(reader.frames()[1].len, 40u);
+    EXPECT_EQ(reader.frames()[1].orig_len, 100u);
+    EXPECT_EQ(reader.frames()[2].ts_ns - reader.frames()[0].ts_ns, 3000000u);
+}
+
+TEST_F(PcapReaderTest, DropsTruncatedLastRecord) {
+    const std::string path = get_test_file("cut.pcap");
+    write_file(path, PcapTimestampPrecision::Micro);
+    fs::resize_file(path, fs::file_size(path) - 10);
+
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_EQ(reader.frames().size(), 2u);
+}
+
+TEST_F(PcapReaderTest, RejectsOtherFormats) {
+    const std::string pcapng = get_test_file("frames.pcapng");
+    PcapngWriter writer;
+    ASSERT_TRUE(writer.open(pcapng));
+    writer.close();
+    EXPECT_FALSE(reader.open(pcapng));
+
+    const std::string text = get_test_file("notes.txt");
+    std::ofstream(text) << "not a capture file at all";
+    EXPECT_FALSE(reader.open(text));
+
+    EXPECT_FALSE(reader.open(get_test_file("missing.pcap")));
+}
+
+TEST(ReplaySpeedTest, ParsesMultipliersAndMax) {
+    double speed = -1;
+    ASSERT_TRUE(parse_replay_speed("max", speed));
+    EXPECT_EQ(speed, 0.0);
+    ASSERT_TRUE(parse_replay_speed("1", speed));
+    EXPECT_EQ(speed, 1.0);
+    ASSERT_TRUE(parse_replay_speed("2.5", speed));
+    EXPECT_EQ(speed, 2.5);
+
+    for (const char* invalid : {"", "0", "-1", "fast", "2x", "nan"}) {
+        EXPECT_FALSE(parse_replay_speed(invalid, speed)) << invalid;
+    }
+}
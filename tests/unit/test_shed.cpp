@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "shed.hpp"
+
+namespace {
+
+constexpr uint64_t MS = 1000000;
+
+LoadShedConfig config() {
+    LoadShedConfig config;
+    config.enabled = true;
+    config.header_bytes = 64;
+    config.sample_rate = 4;
+    config.recover_ms = 100;
+    return config;
+}
+
+std::vector<PacketView> frames(size_t count, size_t len, std::vector<uint8_t>& data) {
+    data.assign(len, 0);
+    std::vector<PacketView> packets(count);
+    for (size_t i = 0; i < count; ++i) {
+        packets[i].data = data.data();
+        packets[i].len = len;
+        packets[i].ts_ns = i;
+    }
+    return packets;
+}
+
+}  // namespace
+
+TEST(LoadShedderTest, EscalatesAtOnceAndRecoversOneLevelAtATime) {
+    LoadShedder shedder(config());
+    EXPECT_FALSE(shedder.update(0.3, 1 * MS));
+    EXPECT_EQ(shedder.level(), ShedLevel::None);
+
+    EXPECT_TRUE(shedder.update(0.95, 2 * MS));
+    EXPECT_EQ(shedder.level(), ShedLevel::Drop);
+
+    // calm has to last recover_ms for every step down
+    EXPECT_FALSE(shedder.update(0.1, 10 * MS));
+    EXPECT_FALSE(shedder.update(0.1, 50 * MS));
+    EXPECT_TRUE(shedder.update(0.1, 110 * MS));
+    EXPECT_EQ(shedder.level(), ShedLevel::Sample);
+
+    // pressure at the current level starts the calm over
+    EXPECT_FALSE(shedder.update(0.1, 150 * MS));
+    EXPECT_FALSE(shedder.update(0.8, 200 * MS));
+    EXPECT_FALSE(shedder.update(0.1, 250 * MS));
+    EXPECT_FALSE(shedder.update(0.1, 300 * MS));
+    EXPECT_TRUE(shedder.update(0.1, 350 * MS));
+    EXPECT_EQ(shedder.level(), ShedLevel::Headers);
+
+    EXPECT_FALSE(shedder.update(0.0, 400 * MS));
+    EXPECT_TRUE(shedder.update(0.0, 500 * MS));
+    EXPECT_EQ(shedder.level(), ShedLevel::None);
+
+    const auto& finished = shedder.finished();
+    ASSERT_EQ(finished.size(), 3u);
+    EXPECT_EQ(finished[0].level, ShedLevel::Drop);
+    EXPECT_EQ(finished[0].start_ns, 2 * MS);
+    EXPECT_EQ(finished[0].end_ns, 110 * MS);
+    EXPECT_DOUBLE_EQ(finished[0].peak_fill, 0.95);
+    EXPECT_EQ(finished[1].level, ShedLevel::Sample);
+    EXPECT_DOUBLE_EQ(finished[1].peak_fill, 0.8);
+    EXPECT_EQ(finished[2].level, ShedLevel::Headers);
+    EXPECT_EQ(finished[2].end_ns, 500 * MS);
+}
+
+TEST(LoadShedderTest, CutsSamplesAndDropsBatches) {
+    LoadShedder shedder(config());
+    std::vector<uint8_t> data;
+    auto packets = frames(8, 200, data);
+    EXPECT_EQ(shedder.apply(packets.data(), packets.size()), 8u);
+    EXPECT_EQ(packets[0].len, 200u);
+
+    shedder.update(0.6, 1 * MS);
+    ASSERT_EQ(shedder.apply(packets.data(), packets.size()), 8u);
+    EXPECT_EQ(packets[0].len, 64u);
+    EXPECT_EQ(packets[0].orig_len, 200u);
+    EXPECT_EQ(packets[0].wire_len(), 200u);
+
+    // one in four kept, compacted to the front in order
+    packets = frames(8, 40, data);
+    shedder.update(0.8, 2 * MS);
+    ASSERT_EQ(shedder.apply(packets.data(), packets.size()), 2u);
+    EXPECT_EQ(packets[0].ts_ns, 0u);
+    EXPECT_EQ(packets[1].ts_ns, 4u);
+    EXPECT_EQ(packets[1].len, 40u);  // short frames stay whole
+
+    shedder.update(0.9, 3 * MS);
+    EXPECT_EQ(shedder.apply(packets.data(), packets.size()), 0u);
+
+    EXPECT_EQ(shedder.total_cut(), 8u);
+    EXPECT_EQ(shedder.total_skipped(), 6u + 8u);
+    EXPECT_EQ(shedder.current().level, ShedLevel::Drop);
+    EXPECT_EQ(shedder.current().skipped, 8u);
+    ASSERT_EQ(shedder.finished().size(), 2u);
+    EXPECT_EQ(shedder.finished()[0].cut, 8u);
+    EXPECT_EQ(shedder.finished()[1].frames, 8u);
+    EXPECT_EQ(shedder.finished()[1].skipped, 6u);
+}
+
+TEST(LoadShedderTest, DescribesIntervals) {
+    ShedInterval interval;
+    interval.level = ShedLevel::Sample;
+    interval.header_bytes = 128;
+    interval.sample_rate = 8;
+    interval.start_ns = 1000000000;
+    interval.end_ns = 1420000000;
+    interval.frames = 9000;
+    interval.cut = 1125;
+    interval.skipped = 7875;
+    interval.peak_fill = 0.93;
+    EXPECT_EQ(describe_shed_interval(interval),
+              "frames cut to 128 bytes, 1 in 8 kept, 0.42 s: 9000 frames, 1125 cut, 7875 skipped, "
+              "93% full");
+    EXPECT_STREQ(shed_level_name(ShedLevel::Drop), "drop");
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+#include "status.hpp"
+
+TEST(CaptureStatsTest, DropRate) {
+    CaptureStats stats;
+    EXPECT_EQ(stats.drop_rate(), 0.0);
+
+    stats.packets = 400;
+    stats.drops = 100;
+    EXPECT_DOUBLE_EQ(stats.drop_rate(), 0.25);
+}
+
+TEST(CaptureStatsTest, Accumulates) {
+    CaptureStats total;
+    CaptureStats worker;
+    worker.packets = 10;
+    worker.drops = 2;
+    worker.freezes = 1;
+    total += worker;
+    total += worker;
+    EXPECT_EQ(total.packets, 20u);
+    EXPECT_EQ(total.drops, 4u);
+    EXPECT_EQ(total.freezes, 2u);
+}
+
+TEST(CaptureStatsTest, Format) {
+    CaptureStats stats;
+    stats.packets = 1200;
+    stats.drops = 3;
+    EXPECT_EQ(format_capture_stats(stats), "1200 received, 3 dropped (0.25%)");
+
+    stats.freezes = 2;
+    EXPECT_EQ(format_capture_stats(stats), "1200 received, 3 dropped (0.25%), 2 ring freezes");
+
+    stats.freezes = 0;
+    stats.cut = 40;
+    stats.shed = 7;
+    EXPECT_EQ(format_capture_stats(stats),
+              "1200 received, 3 dropped (0.25%), 40 cut to headers, 7 shed");
+}
+
+TEST(StatusReporterTest, PrintsPeriodicLine) {
+    std::ostringstream out;
+    {
+        StatusReporter status({}, []() { return uint64_t{500}; }, 1, out);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1300));
+    }
+    EXPECT_NE(out.str().find("[*] 1 s: 500 captured (500/s), kernel 0 received"),
+              std::string::npos)
+        << out.str();
+}
+
+TEST(StatusReporterTest, ZeroIntervalPrintsNothing) {
+    std::ostringstream out;
+    StatusReporter status({}, []() { return uint64_t{1}; }, 0, out);
+    status.stop();
+    EXPECT_TRUE(out.str().empty());
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <poll.h>
+
+#include <chrono>
+#include <thread>
+
+#include "stop_signal.hpp"
+
+namespace {
+
+bool readable(int fd) {
+    struct pollfd pfd{fd, POLLIN, 0};
+    return poll(&pfd, 1, 0) == 1;
+}
+
+}  // namespace
+
+TEST(StopSignalTest, RequestMakesEventfdReadable) {
+    StopSignal stop;
+    ASSERT_GE(stop.fd(), 0);
+    EXPECT_FALSE(stop.requested());
+    EXPECT_FALSE(readable(stop.fd()));
+
+    stop.request();
+    EXPECT_TRUE(stop.requested());
+    EXPECT_TRUE(readable(stop.fd()));
+    // stays readable for every poller until reset
+    EXPECT_TRUE(readable(stop.fd()));
+    EXPECT_EQ(stop.timeout_ms(100), 0);
+
+    stop.reset();
+    EXPECT_FALSE(stop.requested());
+    EXPECT_FALSE(readable(stop.fd()));
+}
+
+TEST(StopSignalTest, TimeoutShrinksToTheDeadline) {
+    StopSignal stop;
+    EXPECT_EQ(stop.timeout_ms(100), 100);
+
+    stop.set_deadline_in(50);
+    const int timeout = stop.timeout_ms(100);
+    EXPECT_GT(timeout, 0);
+    EXPECT_LE(timeout, 50);
+    EXPECT_EQ(stop.timeout_ms(10), 10);
+    EXPECT_FALSE(stop.requested());
+
+    stop.set_deadline_in(0);
+    EXPECT_EQ(stop.timeout_ms(100), 100);
+}
+
+TEST(StopSignalTest, WaitEndsAtTheDeadline) {
+    StopSignal stop;
+    stop.set_deadline_in(30);
+
+    const auto start = std::chrono::steady_clock::now();
+    while (!stop.wait(1000)) {
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_TRUE(stop.requested());
+    EXPECT_GE(elapsed, std::chrono::milliseconds(29));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(500));
+}
+
+TEST(StopSignalTest, RequestWakesWaiterFromAnotherThread) {
+    StopSignal stop;
+    std::thread requester([&stop]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        stop.request();
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(stop.wait(5000));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    requester.join();
+}
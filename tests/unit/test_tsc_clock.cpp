@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <time.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+
+#include "tsc_clock.hpp"
+
+namespace {
+
+// how far wall_clock_ns() may be from CLOCK_REALTIME read right next to it
+constexpr int64_t TOLERANCE_NS = 1000000;
+
+int64_t realtime() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+int64_t offset_from_realtime() {
+    const int64_t before = realtime();
+    const auto wall = static_cast<int64_t>(wall_clock_ns());
+    const int64_t after = realtime();
+    if (wall < before) {
+        return wall - before;
+    }
+    return wall > after ? wall - after : 0;
+}
+
+}  // namespace
+
+TEST(TscClockTest, FollowsRealtime) {
+    EXPECT_LT(std::abs(offset_from_realtime()), TOLERANCE_NS);
+}
+
+TEST(TscClockTest, CalibratedClockTracksRealtime) {
+    if (!calibrate_tsc_clock()) {
+        GTEST_SKIP() << "No invariant TSC";
+    }
+    EXPECT_TRUE(tsc_clock_active());
+    EXPECT_GT(tsc_clock_hz(), 1000000u);
+
+    uint64_t last = 0;
+    for (int i = 0; i < 1000; ++i) {
+        const uint64_t now = wall_clock_ns();
+        EXPECT_GE(now, last);
+        last = now;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_LT(std::abs(offset_from_realtime()), TOLERANCE_NS);
+}
+
+TEST(TscClockTest, ResyncKeepsTheClockOnRealtime) {
+    if (!calibrate_tsc_clock()) {
+        GTEST_SKIP() << "No invariant TSC";
+    }
+    const uint64_t hz = tsc_clock_hz();
+    {
+        TscResync resync(10);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        EXPECT_LT(std::abs(offset_from_realtime()), TOLERANCE_NS);
+    }
+
+    // the rate is re-measured, not replaced by something far off
+    const uint64_t resynced = tsc_clock_hz();
+    EXPECT_LT(resynced > hz ? resynced - hz : hz - resynced, hz / 100);
+}
+
+TEST(TscClockTest, ResyncNeverMovesTheClockBack) {
+    if (!calibrate_tsc_clock()) {
+        GTEST_SKIP() << "No invariant TSC";
+    }
+
+    // resyncs as often as possible, each one a chance for a step back
+    std::atomic<bool> running{true};
+    std::thread resync([&]() {
+        while (running.load()) {
+            resync_tsc_clock();
+        }
+    });
+
+    uint64_t last = wall_clock_ns();
+    uint64_t backwards = 0;
+    const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+    while (std::chrono::steady_clock::now() < end) {
+        const uint64_t now = wall_clock_ns();
+        if (now < last) {
+            ++backwards;
+        }
+        last = now;
+    }
+    running = false;
+    resync.join();
+
+    EXPECT_EQ(backwards, 0u);
+    EXPECT_LT(std::abs(offset_from_realtime()), TOLERANCE_NS);
+}